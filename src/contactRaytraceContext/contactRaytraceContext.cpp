@@ -348,20 +348,148 @@ MStatus ContactRaytraceContext::raytraceContacts(bool suppressVisualization)
     return MS::kSuccess;
 }
 
+// Only steps 1 and 3 touch the scene. The timeline is stepped once without
+// redraws, and every frame is traced in parallel in between.
 MStatus ContactRaytraceContext::raytraceContactsBulk(int frameStart,
                                                      int frameEnd)
 {
     MStatus status;
 
+    status = wipeTraceLines();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = clearVisualizations();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Step 1: Snapshot every frame with object contacts. Rays are
+    // interpolated in world space, so they carry the object's transform at
+    // their frame.
+
+    MAnimControl animCtrl;
+    MSelectionList selectionList;
+
+    MString objectShapeName = OBJECT_NAME + "Shape_";
+
+    vector<ContactRayFrame> rayFrames;
+
     for (int i = frameStart; i <= frameEnd; i++)
     {
-        status = jumpToFrame(i, true);
+        m_frame = i;
+
+        MTime newFrame((double)m_frame, m_framerate);
+
+        status = animCtrl.setCurrentTime(newFrame);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MString objectContactGroup = CONTACT_GROUP_PREFIX + objectShapeName +
+                                     MString(to_string(m_frame).c_str());
+
+        selectionList.clear();
+
+        status =
+            MGlobal::getSelectionListByName(objectContactGroup, selectionList);
+
+        // No contacts in frame - do nothing
+        if (status != MS::kSuccess)
+        {
+            continue;
+        }
+
+        MStringArray serializedObjectContactPoints;
+        status = getContactAttribute(objectContactGroup,
+                                     serializedObjectContactPoints);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        ContactRayFrame rayFrame;
+        rayFrame.frame = m_frame;
+
+        status = getContactRays(serializedObjectContactPoints, rayFrame.sources,
+                                rayFrame.directions);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = getHandVertices(rayFrame.handVertices);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        rayFrames.push_back(move(rayFrame));
+    }
+
+    int numFrames = rayFrames.size();
+
+    if (numFrames == 0)
+    {
+        MGlobal::displayInfo("No contacts found in frame range");
+        return MS::kSuccess;
+    }
+
+    // Topology comes from the current frame, later refits only move points
+    status = updateHandBVH();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        int numVertices = rayFrames[f].handVertices.size() / 3;
+
+        if (numVertices != m_hand_bvh.getNumVertices())
+        {
+            MGlobal::displayInfo("ERROR: Hand topology changes over the "
+                                 "frame range");
+            return MS::kFailure;
+        }
+    }
+
+    // Step 2: Trace. Each thread refits its own copy of the hierarchy, and
+    // the pool hands out contiguous frames first so that refits stay small.
+
+    int numThreads = max((int)thread::hardware_concurrency(), 1);
+
+    TaskPool pool(min(numThreads, numFrames));
+    numThreads = pool.getNumThreads();
+
+    MGlobal::displayInfo("Raytracing contacts in " +
+                         MString(to_string(numFrames).c_str()) +
+                         " frames on " +
+                         MString(to_string(numThreads).c_str()) +
+                         " threads...");
+
+    vector<MeshBVH> handBVHs(numThreads, m_hand_bvh);
+
+    pool.run(numFrames,
+             [&](int worker, int f)
+             {
+                 ContactRayFrame &rayFrame = rayFrames[f];
+                 MeshBVH &handBVH = handBVHs[worker];
+
+                 int numRays = rayFrame.sources.size() / 3;
+
+                 handBVH.refit(rayFrame.handVertices);
+
+                 rayFrame.hits.resize(numRays);
+
+                 handBVH.traceRays(rayFrame.sources.data(),
+                                   rayFrame.directions.data(), numRays,
+                                   CONTACT_RAY_LENGTH, rayFrame.hits.data());
+             });
+
+    // Step 3: Write back. Attributes are keyed on their frame, not on the
+    // current time.
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        m_frame = rayFrames[f].frame;
+
+        status = writeHandContacts(rayFrames[f].hits);
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        status = raytraceContacts(true);
+        status = cleanBadContacts();
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    m_frame = frameEnd;
+
+    m_view.refresh(true, true);
+
+    MGlobal::displayInfo("Done");
+
     return MS::kSuccess;
 }
 
@@ -441,6 +569,8 @@ MStatus ContactRaytraceContext::loadScene()
     status = selectionList.getDagPath(0, m_object_geometry);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    m_hand_bvh.clear();
+
     return MS::kSuccess;
 }
 
@@ -744,6 +874,81 @@ MStatus ContactRaytraceContext::getContactAttribute(
     return MS::kSuccess;
 }
 
+// World space rays from the object contact points along their normals
+MStatus ContactRaytraceContext::getContactRays(
+    MStringArray &serializedObjectContactPoints, vector<float> &sources,
+    vector<float> &directions)
+{
+    MStatus status;
+
+    MFnMesh fnObjectMesh(m_object_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFloatPoint objectRaySource;
+    MFloatVector objectRayDirection;
+
+    int numPoints = serializedObjectContactPoints.length();
+
+    vector<int> vertexIndices;
+    vector<double> coords;
+
+    sources.clear();
+    directions.clear();
+
+    sources.reserve(3 * numPoints);
+    directions.reserve(3 * numPoints);
+
+    for (int i = 0; i < numPoints; i++)
+    {
+        vertexIndices.clear();
+        coords.clear();
+
+        MString serializedObjectContactPoint = serializedObjectContactPoints[i];
+
+        status = parseSerializedPoint(
+            fnObjectMesh, serializedObjectContactPoint, vertexIndices, coords);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status =
+            interpolateSerializedPoint(fnObjectMesh, vertexIndices, coords,
+                                       objectRaySource, objectRayDirection);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        sources.insert(sources.end(), {objectRaySource.x, objectRaySource.y,
+                                       objectRaySource.z});
+        directions.insert(directions.end(),
+                          {objectRayDirection.x, objectRayDirection.y,
+                           objectRayDirection.z});
+    }
+
+    return MS::kSuccess;
+}
+
+MStatus ContactRaytraceContext::getHandVertices(vector<float> &vertices)
+{
+    MStatus status;
+
+    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFloatPointArray points;
+    status = fnHandMesh.getPoints(points, MSpace::kWorld);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int numVertices = points.length();
+
+    vertices.resize(3 * numVertices);
+
+    for (int v = 0; v < numVertices; v++)
+    {
+        vertices[3 * v] = points[v].x;
+        vertices[3 * v + 1] = points[v].y;
+        vertices[3 * v + 2] = points[v].z;
+    }
+
+    return MS::kSuccess;
+}
+
 MStatus ContactRaytraceContext::getPairedFrameContactPoints(
     vector<MPointArray> &pairedContactPoints)
 {
@@ -1058,81 +1263,24 @@ MStatus ContactRaytraceContext::raytraceContactPoints(
 {
     MStatus status;
 
-    MFnMesh fnHandMesh(m_hand_geometry, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
-
-    MFnMesh fnObjectMesh(m_object_geometry, &status);
+    status = updateHandBVH();
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    MFloatPoint objectRaySource;
-    MFloatVector objectRayDirection;
-    MFloatPointArray hitPoints;
-    MIntArray hitFaces, hitTriangles;
-    MFloatArray hitBary1s, hitBary2s;
-
-    MString handShapeName = SOURCE_HAND_NAME + "Shape";
-    MString partialContactName;
-
-    MString handContactGroupName = CONTACT_GROUP_PREFIX + handShapeName +
-                                   MString("_") +
-                                   MString(to_string(m_frame).c_str());
-
-    MStringArray serializedHandContactPoints;
-
-    vector<int> vertexIndices;
-    vector<double> coords;
-
-    for (int i = 0; i < serializedObjectContactPoints.length(); i++)
-    {
-        vertexIndices.clear();
-        coords.clear();
-
-        MString serializedObjectContactPoint = serializedObjectContactPoints[i];
-
-        status = parseSerializedPoint(
-            fnObjectMesh, serializedObjectContactPoint, vertexIndices, coords);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-
-        status =
-            interpolateSerializedPoint(fnObjectMesh, vertexIndices, coords,
-                                       objectRaySource, objectRayDirection);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-
-        int objectPointIndex = i;
-        int handPointIndex = -1;
+    vector<float> sources;
+    vector<float> directions;
 
-        if (fnHandMesh.allIntersections(objectRaySource, objectRayDirection,
-                                        NULL, NULL, false, MSpace::kWorld,
-                                        1000.0, false, NULL, false, hitPoints,
-                                        NULL, &hitFaces, &hitTriangles,
-                                        &hitBary1s, &hitBary2s, 1e-6, &status))
-        {
-            MString serializedHitPoint;
+    status = getContactRays(serializedObjectContactPoints, sources, directions);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-            status = selectTrueContactIntersection(
-                objectRaySource, objectRayDirection, fnHandMesh,
-                serializedHitPoint, hitPoints.length());
-            CHECK_MSTATUS_AND_RETURN_IT(status);
+    int numPoints = serializedObjectContactPoints.length();
 
-            status = serializedHandContactPoints.append(serializedHitPoint);
-            CHECK_MSTATUS_AND_RETURN_IT(status);
-        }
-        else
-        {
-            status = serializedHandContactPoints.append(DEFAULT_MISS_FILLER);
-            CHECK_MSTATUS_AND_RETURN_IT(status);
-        }
-    }
+    // All rays of the frame at once, so they are traced in packets
+    vector<BVHRayHits> frameHits(numPoints);
 
-    if (serializedHandContactPoints.length() !=
-        serializedObjectContactPoints.length())
-    {
-        MGlobal::displayInfo("ERROR: Unequal number of pairings generated");
-        return MS::kFailure;
-    }
+    m_hand_bvh.traceRays(sources.data(), directions.data(), numPoints,
+                         CONTACT_RAY_LENGTH, frameHits.data());
 
-    status =
-        setContactAttribute(handContactGroupName, serializedHandContactPoints);
+    status = writeHandContacts(frameHits);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
     return MS::kSuccess;
@@ -1181,50 +1329,30 @@ MStatus ContactRaytraceContext::redrawTraceLines()
 }
 
 MStatus ContactRaytraceContext::selectTrueContactIntersection(
-    MFloatPoint &raySource, MFloatVector &rayDirection, MFnMesh &fnHandMesh,
-    MString &serializedHitPoint, int numHitPoints)
+    BVHRayHits &hits, MString &serializedHitPoint)
 {
-    MStatus status;
-
-    MFloatPoint resolvedHitPoint;
-    int hitFace, hitTriangle;
-    float hitBary1, hitBary2;
-
     // If even number of hits, hand has undershot - use current ray
     // Otherwise hand has overshot and is penetrating object - invert ray
-    bool isPenetrating = numHitPoints % 2 != 0;
+    bool isPenetrating = hits.numForwardHits % 2 != 0;
 
 #ifndef OBJECT_SUBSTITUTION
-    MFloatVector resolvedRayDir =
-        (isPenetrating) ? -1.0 * rayDirection : rayDirection;
+    bool useBackward = isPenetrating;
 #else
-    MFloatVector resolvedRayDir = rayDirection;
+    bool useBackward = false;
 #endif
 
+    BVHHit hit;
+
     // Take closest intersection with corrected ray direction
-    if (fnHandMesh.closestIntersection(
-            raySource, resolvedRayDir, NULL, NULL, false, MSpace::kWorld,
-            1000.0, false, NULL, resolvedHitPoint, NULL, &hitFace, &hitTriangle,
-            &hitBary1, &hitBary2, 1e-6, &status))
+    if (useBackward && hits.backwardFound)
     {
-        string serializedHitPointChar =
-            "f " + to_string(hitFace) + " " + to_string(hitBary1) + " " +
-            to_string(hitBary2) + " " + to_string(1.0 - hitBary1 - hitBary2);
-
-        serializedHitPoint = serializedHitPointChar.c_str();
+        hit = hits.backward;
     }
 
     // If no hits just take closest of original hits
-    else if (fnHandMesh.closestIntersection(
-                 raySource, rayDirection, NULL, NULL, false, MSpace::kWorld,
-                 1000.0, false, NULL, resolvedHitPoint, NULL, &hitFace,
-                 &hitTriangle, &hitBary1, &hitBary2, 1e-6, &status))
+    else if (hits.forwardFound)
     {
-        string serializedHitPointChar =
-            "f " + to_string(hitFace) + " " + to_string(hitBary1) + " " +
-            to_string(hitBary2) + " " + to_string(1.0 - hitBary1 - hitBary2);
-
-        serializedHitPoint = serializedHitPointChar.c_str();
+        hit = hits.forward;
     }
 
     else
@@ -1234,6 +1362,12 @@ MStatus ContactRaytraceContext::selectTrueContactIntersection(
         return MS::kFailure;
     }
 
+    string serializedHitPointChar =
+        "f " + to_string(hit.face) + " " + to_string(hit.bary1) + " " +
+        to_string(hit.bary2) + " " + to_string(1.0 - hit.bary1 - hit.bary2);
+
+    serializedHitPoint = serializedHitPointChar.c_str();
+
     return MS::kSuccess;
 }
 
@@ -1332,6 +1466,62 @@ MStatus ContactRaytraceContext::setContactAttribute(
     return MS::kSuccess;
 }
 
+// World space hand triangles at the current frame. The hand only deforms
+// over a take, so the hierarchy of the last build is refit to the new points
+// and only rebuilt once it degrades. Faces are fanned from their first
+// vertex, so triangle faces keep the vertex order of getPolygonVertices that
+// serialized face points rely on.
+MStatus ContactRaytraceContext::updateHandBVH()
+{
+    MStatus status;
+
+    vector<float> vertices;
+
+    status = getHandVertices(vertices);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int numVertices = vertices.size() / 3;
+
+    if (!m_hand_bvh.isEmpty() && m_hand_bvh.getNumVertices() == numVertices)
+    {
+        m_hand_bvh.refit(vertices);
+
+        return MS::kSuccess;
+    }
+
+    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MIntArray polygonCounts, polygonConnects;
+    status = fnHandMesh.getVertices(polygonCounts, polygonConnects);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int numFaces = polygonCounts.length();
+
+    vector<int> triangleVertices, triangleFaces, faceTriangles;
+
+    int faceStart = 0;
+
+    for (int f = 0; f < numFaces; f++)
+    {
+        for (int k = 1; k < polygonCounts[f] - 1; k++)
+        {
+            triangleVertices.push_back(polygonConnects[faceStart]);
+            triangleVertices.push_back(polygonConnects[faceStart + k]);
+            triangleVertices.push_back(polygonConnects[faceStart + k + 1]);
+
+            triangleFaces.push_back(f);
+            faceTriangles.push_back(k - 1);
+        }
+
+        faceStart += polygonCounts[f];
+    }
+
+    m_hand_bvh.build(vertices, triangleVertices, triangleFaces, faceTriangles);
+
+    return MS::kSuccess;
+}
+
 MStatus ContactRaytraceContext::wipeTraceLines()
 {
     MStatus status;
@@ -1358,6 +1548,56 @@ MStatus ContactRaytraceContext::wipeTraceLines()
     return MS::kSuccess;
 }
 
+// Resolves the hits of a frame's object contact points into the hand
+// contact attribute of the frame, with misses filled in
+MStatus ContactRaytraceContext::writeHandContacts(vector<BVHRayHits> &frameHits)
+{
+    MStatus status;
+
+    MString handShapeName = SOURCE_HAND_NAME + "Shape";
+
+    MString handContactGroupName = CONTACT_GROUP_PREFIX + handShapeName +
+                                   MString("_") +
+                                   MString(to_string(m_frame).c_str());
+
+    MStringArray serializedHandContactPoints;
+
+    int numPoints = frameHits.size();
+
+    for (int i = 0; i < numPoints; i++)
+    {
+        BVHRayHits &hits = frameHits[i];
+
+        if (hits.numForwardHits > 0)
+        {
+            MString serializedHitPoint;
+
+            status = selectTrueContactIntersection(hits, serializedHitPoint);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            status = serializedHandContactPoints.append(serializedHitPoint);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+        else
+        {
+            status = serializedHandContactPoints.append(DEFAULT_MISS_FILLER);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+    }
+
+    if (serializedHandContactPoints.length() != numPoints)
+    {
+        MGlobal::displayInfo("ERROR: Unequal number of pairings generated");
+        return MS::kFailure;
+    }
+
+    status =
+        setContactAttribute(handContactGroupName, serializedHandContactPoints);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
 // Core Context Teardown
 
 MStatus ContactRaytraceContext::clearVisualizations()
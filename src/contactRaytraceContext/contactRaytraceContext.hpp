@@ -27,12 +27,16 @@
 #include <maya/MVector.h>
 #include <maya/MVectorArray.h>
 
+#include "meshBVH.hpp"
+#include "taskPool.hpp"
+
 #include <cstring>
 #include <fstream>
 #include <map>
 #include <set>
 #include <sstream>
 #include <stack>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -52,6 +56,8 @@ using namespace std;
 
 #define DEFAULT_MISS_FILLER MString("X")
 
+#define CONTACT_RAY_LENGTH 1000.0f // Scene units
+
 #define OBJECT_CONTACT_COLOR MColor(1.0, 0.0, 1.0)
 #define HAND_CONTACT_COLOR MColor(0.0, 1.0, 1.0)
 
@@ -64,6 +70,17 @@ using namespace std;
 
 // #define OBJECT_SUBSTITUTION
 
+// A frame of a bulk raytrace, snapshotted so it can be traced off the Maya
+// thread
+struct ContactRayFrame
+{
+    int frame;
+    vector<float> handVertices; // 3 per vertex, world space
+    vector<float> sources;      // 3 per object contact point, world space
+    vector<float> directions;
+    vector<BVHRayHits> hits;
+};
+
 class ContactRaytraceContext : public MPxContext
 {
 public:
@@ -121,6 +138,11 @@ public:
     MStatus getContactAttribute(MString &contactName,
                                 MStringArray &serializedContactPoints);
 
+    MStatus getContactRays(MStringArray &serializedObjectContactPoints,
+                           vector<float> &sources, vector<float> &directions);
+
+    MStatus getHandVertices(vector<float> &vertices);
+
     MStatus
     getPairedFrameContactPoints(vector<MPointArray> &pairedContactPoints);
 
@@ -140,17 +162,18 @@ public:
 
     MStatus redrawTraceLines();
 
-    MStatus selectTrueContactIntersection(MFloatPoint &raySource,
-                                          MFloatVector &rayDirection,
-                                          MFnMesh &fnHandMesh,
-                                          MString &serializedHitPoint,
-                                          int numHitPoints);
+    MStatus selectTrueContactIntersection(BVHRayHits &hits,
+                                          MString &serializedHitPoint);
 
     MStatus setContactAttribute(MString &contactGroupName,
                                 MStringArray &serializedContactPoints);
 
+    MStatus updateHandBVH();
+
     MStatus wipeTraceLines();
 
+    MStatus writeHandContacts(vector<BVHRayHits> &frameHits);
+
     // Core Context Teardown
 
     MStatus clearVisualizations();
@@ -165,9 +188,10 @@ private:
 
     MDagPath m_object_geometry;
 
-    // Hand mesh var
+    // Hand mesh vars
 
     MDagPath m_hand_geometry;
+    MeshBVH m_hand_bvh; // World space, refit to the frame of the last trace
 
     // View vars
 
@@ -0,0 +1,829 @@
+#include "meshBVH.hpp"
+
+MeshBVH::MeshBVH() : m_build_cost(0.0f) {}
+
+MeshBVH::~MeshBVH() {}
+
+// Triangle vertices index the 3 floats per vertex of vertices. Face triangles
+// give each triangle's index within its face, as reported by hits.
+void MeshBVH::build(const vector<float> &vertices,
+                    const vector<int> &triangleVertices,
+                    const vector<int> &triangleFaces,
+                    const vector<int> &faceTriangles)
+{
+    clear();
+
+    m_vertices = vertices;
+    m_triangle_vertices = triangleVertices;
+    m_triangle_faces = triangleFaces;
+    m_face_triangles = faceTriangles;
+
+    rebuild();
+}
+
+void MeshBVH::clear()
+{
+    m_nodes.clear();
+
+    m_triangle_vertices.clear();
+    m_triangle_faces.clear();
+    m_face_triangles.clear();
+    m_centroids.clear();
+
+    m_vertices.clear();
+
+    m_build_cost = 0.0f;
+}
+
+// Moves the mesh to new positions of the same vertices. The hierarchy is kept
+// and its bounds refit bottom-up, unless that has degraded its SAH cost past
+// BVH_REBUILD_DEGRADATION of the last build. True if it was rebuilt.
+bool MeshBVH::refit(const vector<float> &vertices)
+{
+    m_vertices = vertices;
+
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    for (int n = m_nodes.size() - 1; n >= 0; n--)
+    {
+        BVHNode &node = m_nodes[n];
+
+        if (node.count > 0)
+        {
+            computeBounds(node.leftFirst, node.count, node.boundsMin,
+                          node.boundsMax);
+            continue;
+        }
+
+        const BVHNode &left = m_nodes[node.leftFirst];
+        const BVHNode &right = m_nodes[node.leftFirst + 1];
+
+        for (int a = 0; a < 3; a++)
+        {
+            node.boundsMin[a] = min(left.boundsMin[a], right.boundsMin[a]);
+            node.boundsMax[a] = max(left.boundsMax[a], right.boundsMax[a]);
+        }
+    }
+
+    if (computeCost() <= BVH_REBUILD_DEGRADATION * m_build_cost)
+    {
+        return false;
+    }
+
+    rebuild();
+
+    return true;
+}
+
+float MeshBVH::getBuildCost() const { return m_build_cost; }
+
+int MeshBVH::getNumNodes() const { return m_nodes.size(); }
+
+int MeshBVH::getNumTriangles() const { return m_triangle_faces.size(); }
+
+int MeshBVH::getNumVertices() const { return m_vertices.size() / 3; }
+
+bool MeshBVH::isEmpty() const { return m_nodes.empty(); }
+
+// Walks the nodes along the whole line through the origin once, up to
+// maxDistance either side. Every node the line crosses is visited, since all
+// of the forward hits are counted.
+void MeshBVH::traceRay(const float *origin, const float *direction,
+                       float maxDistance, BVHRayHits &hits) const
+{
+    hits.numForwardHits = 0;
+    hits.forwardFound = false;
+    hits.backwardFound = false;
+
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    float inverseDirection[3] = {1.0f / direction[0], 1.0f / direction[1],
+                                 1.0f / direction[2]};
+
+    int stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode &current = m_nodes[stack[--stackSize]];
+
+        if (intersectBounds(current, origin, inverseDirection, -maxDistance,
+                            maxDistance) == FLT_MAX)
+        {
+            continue;
+        }
+
+        // Builds cap the depth, so the stack cannot overflow
+        if (current.count == 0)
+        {
+            stack[stackSize++] = current.leftFirst + 1;
+            stack[stackSize++] = current.leftFirst;
+
+            continue;
+        }
+
+        for (int t = current.leftFirst; t < current.leftFirst + current.count;
+             t++)
+        {
+            float distance, bary1, bary2;
+
+            if (intersectTriangle(t, origin, direction, distance, bary1,
+                                  bary2))
+            {
+                recordHit(t, distance, bary1, bary2, maxDistance, hits);
+            }
+        }
+    }
+}
+
+// Same hits as traceRay for every ray. Rays are grouped by the proximity of
+// their origins, so that each packet stays coherent through the tree.
+void MeshBVH::traceRays(const float *origins, const float *directions,
+                        int numRays, float maxDistance,
+                        BVHRayHits *hits) const
+{
+#if BVH_PACKET_LANES > 1
+    vector<int> order;
+    computeRayOrder(origins, numRays, order);
+
+    for (int start = 0; start < numRays; start += BVH_PACKET_LANES)
+    {
+        int packetSize = min(numRays - start, BVH_PACKET_LANES);
+
+        tracePacket(origins, directions, &order[start], packetSize,
+                    maxDistance, hits);
+    }
+#else
+    for (int r = 0; r < numRays; r++)
+    {
+        traceRay(&origins[3 * r], &directions[3 * r], maxDistance, hits[r]);
+    }
+#endif
+}
+
+// Padded by the rounding of the triangle and slab tests, so that hits on the
+// boundary of a node are never culled
+void MeshBVH::computeBounds(int first, int count, float *boundsMin,
+                            float *boundsMax) const
+{
+    fill(boundsMin, boundsMin + 3, FLT_MAX);
+    fill(boundsMax, boundsMax + 3, -FLT_MAX);
+
+    for (int t = first; t < first + count; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            const float *vertex =
+                &m_vertices[3 * m_triangle_vertices[3 * t + k]];
+
+            for (int a = 0; a < 3; a++)
+            {
+                boundsMin[a] = min(boundsMin[a], vertex[a]);
+                boundsMax[a] = max(boundsMax[a], vertex[a]);
+            }
+        }
+    }
+
+    for (int a = 0; a < 3; a++)
+    {
+        float padding = BVH_BOUNDS_PADDING *
+                        max(abs(boundsMin[a]), abs(boundsMax[a]));
+
+        boundsMin[a] -= padding;
+        boundsMax[a] += padding;
+    }
+}
+
+// Expected cost of a random ray through the root - node visits and triangle
+// tests weighted by the chance of reaching each node
+float MeshBVH::computeCost() const
+{
+    float rootArea = computeArea(m_nodes[0].boundsMin, m_nodes[0].boundsMax);
+
+    if (!(rootArea > 0.0f))
+    {
+        return 0.0f;
+    }
+
+    float cost = 0.0f;
+
+    for (const BVHNode &node : m_nodes)
+    {
+        float area = computeArea(node.boundsMin, node.boundsMax);
+
+        cost += area * (node.count > 0 ? node.count : BVH_TRAVERSAL_COST);
+    }
+
+    return cost / rootArea;
+}
+
+// Binned SAH over the triangle centroids. False if a leaf is cheaper than
+// any split, unless the node is too large to be a leaf.
+bool MeshBVH::findSplit(int node, int &axis, float &split) const
+{
+    int first = m_nodes[node].leftFirst;
+    int count = m_nodes[node].count;
+
+    float centroidMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float centroidMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    for (int t = first; t < first + count; t++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            centroidMin[a] = min(centroidMin[a], m_centroids[3 * t + a]);
+            centroidMax[a] = max(centroidMax[a], m_centroids[3 * t + a]);
+        }
+    }
+
+    float bestCost = FLT_MAX;
+
+    for (int a = 0; a < 3; a++)
+    {
+        float extent = centroidMax[a] - centroidMin[a];
+
+        if (!(extent > 0.0f))
+        {
+            continue;
+        }
+
+        float scale = BVH_NUM_BINS / extent;
+
+        int binCounts[BVH_NUM_BINS] = {0};
+        float binMins[BVH_NUM_BINS][3];
+        float binMaxs[BVH_NUM_BINS][3];
+
+        for (int b = 0; b < BVH_NUM_BINS; b++)
+        {
+            fill(binMins[b], binMins[b] + 3, FLT_MAX);
+            fill(binMaxs[b], binMaxs[b] + 3, -FLT_MAX);
+        }
+
+        for (int t = first; t < first + count; t++)
+        {
+            int bin = min(
+                (int)((m_centroids[3 * t + a] - centroidMin[a]) * scale),
+                BVH_NUM_BINS - 1);
+
+            binCounts[bin]++;
+
+            float triangleMin[3];
+            float triangleMax[3];
+
+            computeBounds(t, 1, triangleMin, triangleMax);
+
+            for (int k = 0; k < 3; k++)
+            {
+                binMins[bin][k] = min(binMins[bin][k], triangleMin[k]);
+                binMaxs[bin][k] = max(binMaxs[bin][k], triangleMax[k]);
+            }
+        }
+
+        // Sweep from the left, then from the right while costing each plane
+        float leftAreas[BVH_NUM_BINS - 1];
+        int leftCounts[BVH_NUM_BINS - 1];
+
+        float sweepMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float sweepMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        int sweepCount = 0;
+
+        for (int b = 0; b < BVH_NUM_BINS - 1; b++)
+        {
+            sweepCount += binCounts[b];
+
+            for (int k = 0; k < 3; k++)
+            {
+                sweepMin[k] = min(sweepMin[k], binMins[b][k]);
+                sweepMax[k] = max(sweepMax[k], binMaxs[b][k]);
+            }
+
+            leftCounts[b] = sweepCount;
+            leftAreas[b] = sweepCount > 0 ? computeArea(sweepMin, sweepMax)
+                                          : 0.0f;
+        }
+
+        fill(sweepMin, sweepMin + 3, FLT_MAX);
+        fill(sweepMax, sweepMax + 3, -FLT_MAX);
+        sweepCount = 0;
+
+        for (int b = BVH_NUM_BINS - 1; b > 0; b--)
+        {
+            sweepCount += binCounts[b];
+
+            for (int k = 0; k < 3; k++)
+            {
+                sweepMin[k] = min(sweepMin[k], binMins[b][k]);
+                sweepMax[k] = max(sweepMax[k], binMaxs[b][k]);
+            }
+
+            int leftCount = leftCounts[b - 1];
+
+            if (leftCount == 0 || sweepCount == 0)
+            {
+                continue;
+            }
+
+            float cost = leftAreas[b - 1] * leftCount +
+                         computeArea(sweepMin, sweepMax) * sweepCount;
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                axis = a;
+                split = centroidMin[a] + b / scale;
+            }
+        }
+    }
+
+    if (bestCost == FLT_MAX)
+    {
+        return false; // Coincident centroids
+    }
+
+    float nodeArea =
+        computeArea(m_nodes[node].boundsMin, m_nodes[node].boundsMax);
+
+    if (count <= BVH_MAX_LEAF_SIZE && nodeArea > 0.0f &&
+        BVH_TRAVERSAL_COST + bestCost / nodeArea >= count)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// New hierarchy over the current triangles and vertices
+void MeshBVH::rebuild()
+{
+    m_nodes.clear();
+
+    int numTriangles = m_triangle_faces.size();
+
+    if (numTriangles == 0)
+    {
+        m_build_cost = 0.0f;
+        return;
+    }
+
+    m_centroids.resize(3 * numTriangles);
+
+    for (int t = 0; t < numTriangles; t++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            m_centroids[3 * t + a] =
+                (m_vertices[3 * m_triangle_vertices[3 * t] + a] +
+                 m_vertices[3 * m_triangle_vertices[3 * t + 1] + a] +
+                 m_vertices[3 * m_triangle_vertices[3 * t + 2] + a]) /
+                3.0f;
+        }
+    }
+
+    // A binary tree never needs more nodes than this, so references into
+    // the array stay valid while subdividing
+    m_nodes.reserve(2 * numTriangles - 1);
+
+    BVHNode root;
+    root.leftFirst = 0;
+    root.count = numTriangles;
+
+    computeBounds(0, numTriangles, root.boundsMin, root.boundsMax);
+
+    m_nodes.push_back(root);
+
+    subdivide(0, 0);
+
+    m_build_cost = computeCost();
+}
+
+// Traversals hold at most one pending node per level plus two children, so
+// leaves stop one level short of the stack size
+void MeshBVH::subdivide(int node, int depth)
+{
+    int first = m_nodes[node].leftFirst;
+    int count = m_nodes[node].count;
+
+    int axis;
+    float split;
+
+    if (count <= 1 || depth >= BVH_STACK_SIZE - 1 ||
+        !findSplit(node, axis, split))
+    {
+        return;
+    }
+
+    // Partition the triangles in place about the split plane
+    int i = first;
+    int j = first + count - 1;
+
+    while (i <= j)
+    {
+        if (m_centroids[3 * i + axis] < split)
+        {
+            i++;
+            continue;
+        }
+
+        for (int a = 0; a < 3; a++)
+        {
+            swap(m_triangle_vertices[3 * i + a],
+                 m_triangle_vertices[3 * j + a]);
+            swap(m_centroids[3 * i + a], m_centroids[3 * j + a]);
+        }
+
+        swap(m_triangle_faces[i], m_triangle_faces[j]);
+        swap(m_face_triangles[i], m_face_triangles[j]);
+
+        j--;
+    }
+
+    int leftCount = i - first;
+
+    if (leftCount == 0 || leftCount == count)
+    {
+        return;
+    }
+
+    int left = m_nodes.size();
+
+    BVHNode children[2];
+    children[0].leftFirst = first;
+    children[0].count = leftCount;
+    children[1].leftFirst = i;
+    children[1].count = count - leftCount;
+
+    for (BVHNode &child : children)
+    {
+        computeBounds(child.leftFirst, child.count, child.boundsMin,
+                      child.boundsMax);
+
+        m_nodes.push_back(child);
+    }
+
+    m_nodes[node].leftFirst = left;
+    m_nodes[node].count = 0;
+
+    subdivide(left, depth + 1);
+    subdivide(left + 1, depth + 1);
+}
+
+// Updates the hits of a ray with one of its triangle intersections
+void MeshBVH::recordHit(int triangle, float distance, float bary1,
+                        float bary2, float maxDistance,
+                        BVHRayHits &hits) const
+{
+    if (distance == 0.0f || abs(distance) > maxDistance)
+    {
+        return;
+    }
+
+    bool forward = distance > 0.0f;
+
+    if (forward)
+    {
+        hits.numForwardHits++;
+    }
+
+    bool &found = forward ? hits.forwardFound : hits.backwardFound;
+    BVHHit &hit = forward ? hits.forward : hits.backward;
+
+    if (found && abs(distance) >= hit.distance)
+    {
+        return;
+    }
+
+    found = true;
+
+    hit.distance = abs(distance);
+    hit.face = m_triangle_faces[triangle];
+    hit.triangle = m_face_triangles[triangle];
+    hit.bary1 = bary1;
+    hit.bary2 = bary2;
+}
+
+// Traverses once for a packet of rays, given by their indices. A node is
+// entered if any ray of the packet crosses it, with the slab tests of all
+// rays done together, and its triangles are tested against those rays only.
+void MeshBVH::tracePacket(const float *origins, const float *directions,
+                          const int *rays, int numRays, float maxDistance,
+                          BVHRayHits *hits) const
+{
+    for (int k = 0; k < numRays; k++)
+    {
+        BVHRayHits &rayHits = hits[rays[k]];
+
+        rayHits.numForwardHits = 0;
+        rayHits.forwardFound = false;
+        rayHits.backwardFound = false;
+    }
+
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+#if BVH_PACKET_LANES > 1
+    // Structure of arrays, idle lanes repeat the first ray
+    float laneValues[6][BVH_PACKET_LANES];
+
+    for (int k = 0; k < BVH_PACKET_LANES; k++)
+    {
+        int ray = rays[k < numRays ? k : 0];
+
+        for (int a = 0; a < 3; a++)
+        {
+            laneValues[a][k] = origins[3 * ray + a];
+            laneValues[3 + a][k] = 1.0f / directions[3 * ray + a];
+        }
+    }
+
+    int activeMask = (1 << numRays) - 1;
+#endif
+
+#if BVH_PACKET_LANES == 8
+    __m256 laneOrigins[3];
+    __m256 laneInverses[3];
+
+    for (int a = 0; a < 3; a++)
+    {
+        laneOrigins[a] = _mm256_loadu_ps(laneValues[a]);
+        laneInverses[a] = _mm256_loadu_ps(laneValues[3 + a]);
+    }
+
+    __m256 laneMinDistance = _mm256_set1_ps(-maxDistance);
+    __m256 laneMaxDistance = _mm256_set1_ps(maxDistance);
+#elif BVH_PACKET_LANES == 4
+    __m128 laneOrigins[3];
+    __m128 laneInverses[3];
+
+    for (int a = 0; a < 3; a++)
+    {
+        laneOrigins[a] = _mm_loadu_ps(laneValues[a]);
+        laneInverses[a] = _mm_loadu_ps(laneValues[3 + a]);
+    }
+
+    __m128 laneMinDistance = _mm_set1_ps(-maxDistance);
+    __m128 laneMaxDistance = _mm_set1_ps(maxDistance);
+#endif
+
+    int stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const BVHNode &current = m_nodes[stack[--stackSize]];
+
+        int mask = 0;
+
+        // Same operand order as intersectBounds, so NaNs resolve the same way
+#if BVH_PACKET_LANES == 8
+        __m256 entry = laneMinDistance;
+        __m256 exit = laneMaxDistance;
+
+        for (int a = 0; a < 3; a++)
+        {
+            __m256 t1 = _mm256_mul_ps(
+                _mm256_sub_ps(_mm256_set1_ps(current.boundsMin[a]),
+                              laneOrigins[a]),
+                laneInverses[a]);
+            __m256 t2 = _mm256_mul_ps(
+                _mm256_sub_ps(_mm256_set1_ps(current.boundsMax[a]),
+                              laneOrigins[a]),
+                laneInverses[a]);
+
+            entry = _mm256_max_ps(_mm256_min_ps(t2, t1), entry);
+            exit = _mm256_min_ps(_mm256_max_ps(t2, t1), exit);
+        }
+
+        mask = _mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ)) &
+               activeMask;
+#elif BVH_PACKET_LANES == 4
+        __m128 entry = laneMinDistance;
+        __m128 exit = laneMaxDistance;
+
+        for (int a = 0; a < 3; a++)
+        {
+            __m128 t1 = _mm_mul_ps(
+                _mm_sub_ps(_mm_set1_ps(current.boundsMin[a]), laneOrigins[a]),
+                laneInverses[a]);
+            __m128 t2 = _mm_mul_ps(
+                _mm_sub_ps(_mm_set1_ps(current.boundsMax[a]), laneOrigins[a]),
+                laneInverses[a]);
+
+            entry = _mm_max_ps(_mm_min_ps(t2, t1), entry);
+            exit = _mm_min_ps(_mm_max_ps(t2, t1), exit);
+        }
+
+        mask = _mm_movemask_ps(_mm_cmple_ps(entry, exit)) & activeMask;
+#else
+        for (int k = 0; k < numRays; k++)
+        {
+            const float *origin = &origins[3 * rays[k]];
+            const float *direction = &directions[3 * rays[k]];
+
+            float inverseDirection[3] = {1.0f / direction[0],
+                                         1.0f / direction[1],
+                                         1.0f / direction[2]};
+
+            if (intersectBounds(current, origin, inverseDirection,
+                                -maxDistance, maxDistance) != FLT_MAX)
+            {
+                mask |= 1 << k;
+            }
+        }
+#endif
+
+        if (mask == 0)
+        {
+            continue;
+        }
+
+        // Builds cap the depth, so the stack cannot overflow
+        if (current.count == 0)
+        {
+            stack[stackSize++] = current.leftFirst + 1;
+            stack[stackSize++] = current.leftFirst;
+
+            continue;
+        }
+
+        for (int t = current.leftFirst; t < current.leftFirst + current.count;
+             t++)
+        {
+            for (int k = 0; k < numRays; k++)
+            {
+                if (!(mask & (1 << k)))
+                {
+                    continue;
+                }
+
+                int ray = rays[k];
+                float distance, bary1, bary2;
+
+                if (intersectTriangle(t, &origins[3 * ray],
+                                      &directions[3 * ray], distance, bary1,
+                                      bary2))
+                {
+                    recordHit(t, distance, bary1, bary2, maxDistance,
+                              hits[ray]);
+                }
+            }
+        }
+    }
+}
+
+// Moller-Trumbore, accepting both windings. The distance is signed, negative
+// behind the origin.
+bool MeshBVH::intersectTriangle(int triangle, const float *origin,
+                                const float *direction, float &distance,
+                                float &bary1, float &bary2) const
+{
+    const float *v0 = &m_vertices[3 * m_triangle_vertices[3 * triangle]];
+    const float *v1 = &m_vertices[3 * m_triangle_vertices[3 * triangle + 1]];
+    const float *v2 = &m_vertices[3 * m_triangle_vertices[3 * triangle + 2]];
+
+    float edge1[3] = {v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]};
+    float edge2[3] = {v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]};
+
+    float p[3] = {direction[1] * edge2[2] - direction[2] * edge2[1],
+                  direction[2] * edge2[0] - direction[0] * edge2[2],
+                  direction[0] * edge2[1] - direction[1] * edge2[0]};
+
+    float determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+
+    if (abs(determinant) < BVH_PARALLEL_EPSILON)
+    {
+        return false;
+    }
+
+    float inverseDeterminant = 1.0f / determinant;
+
+    float s[3] = {origin[0] - v0[0], origin[1] - v0[1], origin[2] - v0[2]};
+
+    float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverseDeterminant;
+
+    if (u < 0.0f || u > 1.0f)
+    {
+        return false;
+    }
+
+    float q[3] = {s[1] * edge1[2] - s[2] * edge1[1],
+                  s[2] * edge1[0] - s[0] * edge1[2],
+                  s[0] * edge1[1] - s[1] * edge1[0]};
+
+    float v = (direction[0] * q[0] + direction[1] * q[1] +
+               direction[2] * q[2]) *
+              inverseDeterminant;
+
+    if (v < 0.0f || u + v > 1.0f)
+    {
+        return false;
+    }
+
+    distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) *
+               inverseDeterminant;
+
+    bary1 = 1.0f - u - v;
+    bary2 = u;
+
+    return true;
+}
+
+float MeshBVH::computeArea(const float *boundsMin, const float *boundsMax)
+{
+    float extent[3] = {boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1],
+                       boundsMax[2] - boundsMin[2]};
+
+    return extent[0] * extent[1] + extent[1] * extent[2] +
+           extent[2] * extent[0];
+}
+
+// Rays sorted along a Morton curve through the bounds of their origins, so
+// that consecutive rays start close together
+void MeshBVH::computeRayOrder(const float *origins, int numRays,
+                              vector<int> &order)
+{
+    order.resize(numRays);
+
+    if (numRays == 0)
+    {
+        return;
+    }
+
+    float originMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float originMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    for (int r = 0; r < numRays; r++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            originMin[a] = min(originMin[a], origins[3 * r + a]);
+            originMax[a] = max(originMax[a], origins[3 * r + a]);
+        }
+    }
+
+    int cells = 1 << BVH_MORTON_BITS;
+
+    vector<pair<uint32_t, int>> codes(numRays);
+
+    for (int r = 0; r < numRays; r++)
+    {
+        uint32_t code = 0;
+
+        for (int a = 0; a < 3; a++)
+        {
+            float extent = originMax[a] - originMin[a];
+            float position = extent > 0.0f
+                                 ? (origins[3 * r + a] - originMin[a]) / extent
+                                 : 0.0f;
+
+            uint32_t cell = min((int)(position * cells), cells - 1);
+
+            // Interleave the bits of the three axes
+            for (int b = 0; b < BVH_MORTON_BITS; b++)
+            {
+                code |= ((cell >> b) & 1u) << (3 * b + a);
+            }
+        }
+
+        codes[r] = make_pair(code, r);
+    }
+
+    sort(codes.begin(), codes.end());
+
+    for (int r = 0; r < numRays; r++)
+    {
+        order[r] = codes[r].second;
+    }
+}
+
+// Entry distance of the ray into the node within the given span, FLT_MAX on
+// a miss
+float MeshBVH::intersectBounds(const BVHNode &node, const float *origin,
+                               const float *inverseDirection,
+                               float minDistance, float maxDistance)
+{
+    float entry = minDistance;
+    float exit = maxDistance;
+
+    for (int a = 0; a < 3; a++)
+    {
+        float t1 = (node.boundsMin[a] - origin[a]) * inverseDirection[a];
+        float t2 = (node.boundsMax[a] - origin[a]) * inverseDirection[a];
+
+        entry = max(entry, min(t1, t2));
+        exit = min(exit, max(t1, t2));
+    }
+
+    return entry <= exit ? entry : FLT_MAX;
+}
@@ -0,0 +1,133 @@
+#ifndef MESHBVH_H
+#define MESHBVH_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BVH_PACKET_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BVH_PACKET_LANES 4
+#else
+#define BVH_PACKET_LANES 1
+#endif
+
+using namespace std;
+
+#define BVH_NUM_BINS 16              // SAH candidates per axis
+#define BVH_MAX_LEAF_SIZE 4          // Triangles, larger nodes are always split
+#define BVH_TRAVERSAL_COST 1.0f      // Of a node visit, relative to a triangle
+#define BVH_STACK_SIZE 64            // Traversal nodes, also caps build depth
+#define BVH_PARALLEL_EPSILON 1e-6f   // Determinant of rays along a triangle
+#define BVH_REBUILD_DEGRADATION 1.3f // Refit SAH cost over the built one
+#define BVH_BOUNDS_PADDING 1e-5f     // Relative to the coordinates
+#define BVH_MORTON_BITS 10           // Per axis, when grouping rays
+
+// 32 bytes, so two nodes share a cache line. Interior nodes keep their two
+// children next to each other at leftFirst, leaves their triangles.
+struct BVHNode
+{
+    float boundsMin[3];
+    int leftFirst;
+    float boundsMax[3];
+    int count; // 0 for interior nodes
+};
+
+// A ray hit on a mesh face, with the same barycentrics as
+// MFnMesh::closestIntersection (bary1 and bary2 weight the first two
+// vertices of the triangle)
+struct BVHHit
+{
+    float distance;
+    int face;
+    int triangle; // Within the face
+    float bary1;
+    float bary2;
+};
+
+// Hits of a ray from a single traversal - the number of hits ahead, whose
+// parity tells if the origin is inside a closed mesh, and the closest hit on
+// either side of the origin. Backward distances are measured along the
+// reversed direction.
+struct BVHRayHits
+{
+    int numForwardHits;
+    bool forwardFound;
+    bool backwardFound;
+    BVHHit forward;
+    BVHHit backward;
+};
+
+// Not a Maya context - bounding volume hierarchy over the triangles of a
+// mesh, built with binned SAH into a flat node array. Triangles are reordered
+// so that every leaf references a contiguous run. Rays hit both sides of a
+// triangle, like the MFnMesh intersection queries. A mesh that only deforms
+// is refit rather than rebuilt. Batches of rays are traced in packets that
+// share node visits, on SSE2 or AVX2 lanes where available.
+class MeshBVH
+{
+public:
+    MeshBVH();
+    virtual ~MeshBVH();
+
+    void build(const vector<float> &vertices,
+               const vector<int> &triangleVertices,
+               const vector<int> &triangleFaces,
+               const vector<int> &faceTriangles);
+    void clear();
+    bool refit(const vector<float> &vertices);
+
+    void traceRay(const float *origin, const float *direction,
+                  float maxDistance, BVHRayHits &hits) const;
+    void traceRays(const float *origins, const float *directions,
+                   int numRays, float maxDistance, BVHRayHits *hits) const;
+
+    float getBuildCost() const;
+    int getNumNodes() const;
+    int getNumTriangles() const;
+    int getNumVertices() const;
+    bool isEmpty() const;
+
+private:
+    void computeBounds(int first, int count, float *boundsMin,
+                       float *boundsMax) const;
+    float computeCost() const;
+    bool findSplit(int node, int &axis, float &split) const;
+    void rebuild();
+    void subdivide(int node, int depth);
+
+    bool intersectTriangle(int triangle, const float *origin,
+                           const float *direction, float &distance,
+                           float &bary1, float &bary2) const;
+    void recordHit(int triangle, float distance, float bary1, float bary2,
+                   float maxDistance, BVHRayHits &hits) const;
+    void tracePacket(const float *origins, const float *directions,
+                     const int *rays, int numRays, float maxDistance,
+                     BVHRayHits *hits) const;
+
+    static float computeArea(const float *boundsMin, const float *boundsMax);
+    static void computeRayOrder(const float *origins, int numRays,
+                                vector<int> &order);
+    static float intersectBounds(const BVHNode &node, const float *origin,
+                                 const float *inverseDirection,
+                                 float minDistance, float maxDistance);
+
+    vector<BVHNode> m_nodes; // Root first, children after their parents
+    float m_build_cost;      // SAH cost right after the last build
+
+    // Triangle vars (in leaf order)
+
+    vector<int> m_triangle_vertices; // 3 per triangle
+    vector<int> m_triangle_faces;
+    vector<int> m_face_triangles;    // Index of the triangle within its face
+    vector<float> m_centroids;       // 3 per triangle, only used by builds
+
+    vector<float> m_vertices; // 3 per vertex
+};
+
+#endif // MESHBVH_H
@@ -0,0 +1,54 @@
+#ifndef BINARYSTREAM_H
+#define BINARYSTREAM_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+// Not a Maya context - helpers shared by the native binary formats. Values
+// are written in host byte order and vectors are prefixed with their length.
+// A short or implausible read leaves the stream failed, so callers only need
+// to check it once at the end.
+
+#define BINARY_STREAM_MAX_LENGTH (1u << 30) // Guards against corrupt lengths
+
+template <typename T> void writeBinaryValue(ostream &out, const T &value)
+{
+    out.write((const char *)&value, sizeof(T));
+}
+
+template <typename T> void readBinaryValue(istream &in, T &value)
+{
+    in.read((char *)&value, sizeof(T));
+}
+
+template <typename T>
+void writeBinaryVector(ostream &out, const vector<T> &values)
+{
+    uint32_t length = values.size();
+
+    writeBinaryValue(out, length);
+    out.write((const char *)values.data(), length * sizeof(T));
+}
+
+template <typename T> void readBinaryVector(istream &in, vector<T> &values)
+{
+    uint32_t length = 0;
+
+    readBinaryValue(in, length);
+
+    if (!in || length > BINARY_STREAM_MAX_LENGTH / sizeof(T))
+    {
+        in.setstate(ios::failbit);
+        values.clear();
+        return;
+    }
+
+    values.resize(length);
+    in.read((char *)values.data(), length * sizeof(T));
+}
+
+#endif // BINARYSTREAM_H
@@ -0,0 +1,294 @@
+#include "boxSDF.hpp"
+
+BoxSDF::BoxSDF()
+{
+    fill(m_inverse, m_inverse + 16, 0.0);
+    fill(m_half_dims, m_half_dims + 3, 0.0);
+}
+
+BoxSDF::~BoxSDF() {}
+
+// Gradient is chained back to world space
+double BoxSDF::computeDistance(const double *point, double *gradient) const
+{
+    const double *t = m_inverse;
+
+    double relative[3];
+    double q[3];
+    double outside[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+        relative[r] = t[4 * r] * point[0] + t[4 * r + 1] * point[1] +
+                      t[4 * r + 2] * point[2] + t[4 * r + 3];
+        q[r] = abs(relative[r]) - m_half_dims[r];
+        outside[r] = max(q[r], 0.0);
+    }
+
+    double outsideLength = sqrt(outside[0] * outside[0] +
+                                outside[1] * outside[1] +
+                                outside[2] * outside[2]);
+
+    double signedDistance =
+        outsideLength + min(max(q[0], max(q[1], q[2])), 0.0);
+
+    double localGradient[3] = {0.0, 0.0, 0.0};
+
+    if (outsideLength > 0.0) // Outside - points away from closest feature
+    {
+        for (int r = 0; r < 3; r++)
+        {
+            localGradient[r] = outside[r] / outsideLength;
+        }
+    }
+    else // Inside - points out through the closest face
+    {
+        int closestAxis = (q[0] > q[1]) ? ((q[0] > q[2]) ? 0 : 2)
+                                        : ((q[1] > q[2]) ? 1 : 2);
+
+        localGradient[closestAxis] = 1.0;
+    }
+
+    for (int r = 0; r < 3; r++)
+    {
+        if (relative[r] < 0.0)
+        {
+            localGradient[r] *= -1.0;
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        gradient[c] = localGradient[0] * t[c] + localGradient[1] * t[4 + c] +
+                      localGradient[2] * t[8 + c];
+    }
+
+    return signedDistance;
+}
+
+// Sum of -min(sdf, 0) over all points. A point is only inside when every
+// q = |relative| - halfDim is negative, in which case the penetration is
+// simply -max(q), so no square roots are needed. Penetrating point indices
+// are appended in increasing order if requested.
+double BoxSDF::computePenetration(const double *xs, const double *ys,
+                                  const double *zs, int numPoints,
+                                  vector<int> *penetratingPoints) const
+{
+    double penetration = 0.0;
+
+    int start = 0;
+
+#if BOX_SDF_LANES == 4
+    const double *t = m_inverse;
+
+    __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256d zero = _mm256_setzero_pd();
+    __m256d sum = _mm256_setzero_pd();
+
+    __m256d rows[3][4];
+    __m256d halfDims[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            rows[r][c] = _mm256_set1_pd(t[4 * r + c]);
+        }
+
+        halfDims[r] = _mm256_set1_pd(m_half_dims[r]);
+    }
+
+    for (; start + 4 <= numPoints; start += 4)
+    {
+        __m256d x = _mm256_loadu_pd(xs + start);
+        __m256d y = _mm256_loadu_pd(ys + start);
+        __m256d z = _mm256_loadu_pd(zs + start);
+
+        __m256d maxQ;
+
+        for (int r = 0; r < 3; r++)
+        {
+            __m256d relative = _mm256_add_pd(
+                _mm256_add_pd(_mm256_mul_pd(rows[r][0], x),
+                              _mm256_mul_pd(rows[r][1], y)),
+                _mm256_add_pd(_mm256_mul_pd(rows[r][2], z), rows[r][3]));
+
+            __m256d q = _mm256_sub_pd(_mm256_andnot_pd(signMask, relative),
+                                      halfDims[r]);
+
+            maxQ = r == 0 ? q : _mm256_max_pd(maxQ, q);
+        }
+
+        __m256d inside = _mm256_cmp_pd(maxQ, zero, _CMP_LT_OQ);
+        int mask = _mm256_movemask_pd(inside);
+
+        if (mask == 0)
+        {
+            continue;
+        }
+
+        sum = _mm256_sub_pd(sum, _mm256_and_pd(inside, maxQ));
+
+        if (penetratingPoints)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                if (mask & (1 << k))
+                {
+                    penetratingPoints->push_back(start + k);
+                }
+            }
+        }
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+
+    penetration = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif BOX_SDF_LANES == 2
+    const double *t = m_inverse;
+
+    __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d zero = _mm_setzero_pd();
+    __m128d sum = _mm_setzero_pd();
+
+    __m128d rows[3][4];
+    __m128d halfDims[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            rows[r][c] = _mm_set1_pd(t[4 * r + c]);
+        }
+
+        halfDims[r] = _mm_set1_pd(m_half_dims[r]);
+    }
+
+    for (; start + 2 <= numPoints; start += 2)
+    {
+        __m128d x = _mm_loadu_pd(xs + start);
+        __m128d y = _mm_loadu_pd(ys + start);
+        __m128d z = _mm_loadu_pd(zs + start);
+
+        __m128d maxQ;
+
+        for (int r = 0; r < 3; r++)
+        {
+            __m128d relative =
+                _mm_add_pd(_mm_add_pd(_mm_mul_pd(rows[r][0], x),
+                                      _mm_mul_pd(rows[r][1], y)),
+                           _mm_add_pd(_mm_mul_pd(rows[r][2], z), rows[r][3]));
+
+            __m128d q =
+                _mm_sub_pd(_mm_andnot_pd(signMask, relative), halfDims[r]);
+
+            maxQ = r == 0 ? q : _mm_max_pd(maxQ, q);
+        }
+
+        __m128d inside = _mm_cmplt_pd(maxQ, zero);
+        int mask = _mm_movemask_pd(inside);
+
+        if (mask == 0)
+        {
+            continue;
+        }
+
+        sum = _mm_sub_pd(sum, _mm_and_pd(inside, maxQ));
+
+        if (penetratingPoints)
+        {
+            for (int k = 0; k < 2; k++)
+            {
+                if (mask & (1 << k))
+                {
+                    penetratingPoints->push_back(start + k);
+                }
+            }
+        }
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+
+    penetration = lanes[0] + lanes[1];
+#endif
+
+    // Tail (or everything without SIMD)
+    computePenetrationScalar(xs, ys, zs, start, numPoints, penetration,
+                             penetratingPoints);
+
+    return penetration;
+}
+
+// Conservative - the world AABB is bounded again in box space, so an
+// oriented box only overlaps what it can actually reach
+bool BoxSDF::overlapsBounds(const double *boundsMin,
+                            const double *boundsMax) const
+{
+    const double *t = m_inverse;
+
+    double center[3];
+    double extent[3];
+
+    for (int c = 0; c < 3; c++)
+    {
+        center[c] = 0.5 * (boundsMin[c] + boundsMax[c]);
+        extent[c] = 0.5 * (boundsMax[c] - boundsMin[c]);
+    }
+
+    for (int r = 0; r < 3; r++)
+    {
+        double relative = t[4 * r] * center[0] + t[4 * r + 1] * center[1] +
+                          t[4 * r + 2] * center[2] + t[4 * r + 3];
+        double relativeExtent = abs(t[4 * r]) * extent[0] +
+                                abs(t[4 * r + 1]) * extent[1] +
+                                abs(t[4 * r + 2]) * extent[2];
+
+        if (abs(relative) - relativeExtent > m_half_dims[r])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BoxSDF::setBox(const double *inverse, const double *halfDims)
+{
+    copy(inverse, inverse + 16, m_inverse);
+    copy(halfDims, halfDims + 3, m_half_dims);
+}
+
+void BoxSDF::computePenetrationScalar(const double *xs, const double *ys,
+                                      const double *zs, int start, int end,
+                                      double &penetration,
+                                      vector<int> *penetratingPoints) const
+{
+    const double *t = m_inverse;
+
+    for (int i = start; i < end; i++)
+    {
+        double maxQ = -HUGE_VAL;
+
+        for (int r = 0; r < 3; r++)
+        {
+            double relative = t[4 * r] * xs[i] + t[4 * r + 1] * ys[i] +
+                              t[4 * r + 2] * zs[i] + t[4 * r + 3];
+
+            maxQ = max(maxQ, abs(relative) - m_half_dims[r]);
+        }
+
+        if (maxQ >= 0.0)
+        {
+            continue;
+        }
+
+        penetration -= maxQ;
+
+        if (penetratingPoints)
+        {
+            penetratingPoints->push_back(i);
+        }
+    }
+}
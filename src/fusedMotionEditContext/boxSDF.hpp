@@ -0,0 +1,50 @@
+#ifndef BOXSDF_H
+#define BOXSDF_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BOX_SDF_LANES 4
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BOX_SDF_LANES 2
+#else
+#define BOX_SDF_LANES 1
+#endif
+
+using namespace std;
+
+// Not a Maya context - signed distance to an oriented box (the table). The
+// inverse transform uses the conventional column vector layout, i.e. local
+// coordinate r = sum_c t[4r + c] * p[c] + t[4r + 3]. Batch queries take SoA
+// points and are vectorized with whatever the target supports.
+class BoxSDF
+{
+public:
+    BoxSDF();
+    virtual ~BoxSDF();
+
+    double computeDistance(const double *point, double *gradient) const;
+    double computePenetration(const double *xs, const double *ys,
+                              const double *zs, int numPoints,
+                              vector<int> *penetratingPoints) const;
+
+    bool overlapsBounds(const double *boundsMin,
+                        const double *boundsMax) const;
+
+    void setBox(const double *inverse, const double *halfDims);
+
+private:
+    void computePenetrationScalar(const double *xs, const double *ys,
+                                  const double *zs, int start, int end,
+                                  double &penetration,
+                                  vector<int> *penetratingPoints) const;
+
+    double m_inverse[16];
+    double m_half_dims[3];
+};
+
+#endif // BOXSDF_H
@@ -0,0 +1,178 @@
+#include "dofUndoHistory.hpp"
+
+DofUndoHistory::DofUndoHistory()
+    : m_first_sequence(0), m_memory_cap(DEFAULT_UNDO_MEMORY_CAP),
+      m_memory_usage(0), m_num_entries(0)
+{
+}
+
+DofUndoHistory::~DofUndoHistory() {}
+
+void DofUndoHistory::clear()
+{
+    m_entries.clear();
+    m_entries_valid.clear();
+    m_frame_sequences.clear();
+
+    m_first_sequence = 0;
+    m_memory_usage = 0;
+    m_num_entries = 0;
+}
+
+size_t DofUndoHistory::getMemoryCap() const { return m_memory_cap; }
+
+size_t DofUndoHistory::getMemoryUsage() const { return m_memory_usage; }
+
+int DofUndoHistory::getNumEntries() const { return m_num_entries; }
+
+// Takes a sequence from record. Entries since undone or dropped are skipped.
+void DofUndoHistory::markKeyed(long sequence)
+{
+    long index = sequence - m_first_sequence;
+
+    if (sequence < 0 || index < 0 || index >= (long)m_entries.size() ||
+        !m_entries_valid[index])
+    {
+        return;
+    }
+
+    m_entries[index].keyed = true;
+}
+
+bool DofUndoHistory::popFrame(int frame, DofDelta &delta)
+{
+    auto it = m_frame_sequences.find(frame);
+
+    if (it == m_frame_sequences.end())
+    {
+        return false;
+    }
+
+    dropEntry(it->second.back(), delta);
+    trimUndoneEntries();
+
+    return true;
+}
+
+bool DofUndoHistory::popLatest(DofDelta &delta)
+{
+    if (m_entries.empty())
+    {
+        return false;
+    }
+
+    dropEntry(m_first_sequence + m_entries.size() - 1, delta);
+    trimUndoneEntries();
+
+    return true;
+}
+
+// Returns the sequence of the new entry, or -1 if the run left the frame
+// unchanged and nothing was recorded
+long DofUndoHistory::record(int frame, const vector<double> &before,
+                            const vector<double> &after, bool keyed)
+{
+    DofDelta delta;
+    delta.frame = frame;
+    delta.keyed = keyed;
+
+    for (int i = 0; i < before.size(); i++)
+    {
+        if (before[i] != after[i])
+        {
+            delta.dofIndices.push_back(i);
+            delta.dofValues.push_back(before[i]);
+        }
+    }
+
+    if (delta.dofIndices.empty())
+    {
+        return -1;
+    }
+
+    delta.dofIndices.shrink_to_fit();
+    delta.dofValues.shrink_to_fit();
+
+    long sequence = m_first_sequence + m_entries.size();
+
+    m_memory_usage += computeEntrySize(delta);
+    m_num_entries++;
+
+    m_entries.push_back(move(delta));
+    m_entries_valid.push_back(true);
+    m_frame_sequences[frame].push_back(sequence);
+
+    trimToMemoryCap();
+
+    return sequence;
+}
+
+void DofUndoHistory::setMemoryCap(size_t memoryCap)
+{
+    m_memory_cap = memoryCap;
+
+    trimToMemoryCap();
+}
+
+size_t DofUndoHistory::computeEntrySize(const DofDelta &delta)
+{
+    return sizeof(DofDelta) + sizeof(bool) + sizeof(long) +
+           delta.dofIndices.capacity() * sizeof(int) +
+           delta.dofValues.capacity() * sizeof(double);
+}
+
+// Moves the entry out and leaves an invalid placeholder in the ring
+void DofUndoHistory::dropEntry(long sequence, DofDelta &delta)
+{
+    int index = sequence - m_first_sequence;
+
+    m_memory_usage -= computeEntrySize(m_entries[index]);
+    m_num_entries--;
+
+    delta = move(m_entries[index]);
+    m_entries[index] = DofDelta();
+    m_entries_valid[index] = false;
+
+    vector<long> &frameSequences = m_frame_sequences[delta.frame];
+
+    for (auto it = frameSequences.begin(); it != frameSequences.end(); it++)
+    {
+        if (*it == sequence)
+        {
+            frameSequences.erase(it);
+            break;
+        }
+    }
+
+    if (frameSequences.empty())
+    {
+        m_frame_sequences.erase(delta.frame);
+    }
+}
+
+void DofUndoHistory::trimToMemoryCap()
+{
+    DofDelta dropped;
+
+    while (m_memory_usage > m_memory_cap && !m_entries.empty())
+    {
+        dropEntry(m_first_sequence, dropped);
+        trimUndoneEntries();
+    }
+}
+
+void DofUndoHistory::trimUndoneEntries()
+{
+    while (!m_entries.empty() && !m_entries_valid.front())
+    {
+        m_entries.pop_front();
+        m_entries_valid.pop_front();
+        m_first_sequence++;
+    }
+
+    while (!m_entries.empty() && !m_entries_valid.back())
+    {
+        m_entries.pop_back();
+        m_entries_valid.pop_back();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef DOFUNDOHISTORY_H
+#define DOFUNDOHISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#define DEFAULT_UNDO_MEMORY_CAP (64 << 20) // Bytes
+
+// Dofs an optimizer run changed on one frame, with their values before it
+struct DofDelta
+{
+    int frame;
+    bool keyed; // Whether the solution was written to the rig's anim curves
+
+    vector<int> dofIndices;
+    vector<double> dofValues;
+};
+
+// Not a Maya context - bounded undo history of optimizer runs. Each solved
+// frame stores only the dofs that changed. Entries form a ring buffer in
+// solve order and are indexed by frame, so the latest solve of any frame can
+// be undone. The oldest entries are dropped once the memory cap is exceeded.
+class DofUndoHistory
+{
+public:
+    DofUndoHistory();
+    virtual ~DofUndoHistory();
+
+    void clear();
+
+    size_t getMemoryCap() const;
+    size_t getMemoryUsage() const;
+    int getNumEntries() const;
+
+    void markKeyed(long sequence);
+
+    bool popFrame(int frame, DofDelta &delta);
+    bool popLatest(DofDelta &delta);
+
+    long record(int frame, const vector<double> &before,
+                const vector<double> &after, bool keyed);
+
+    void setMemoryCap(size_t memoryCap);
+
+private:
+    static size_t computeEntrySize(const DofDelta &delta);
+
+    void dropEntry(long sequence, DofDelta &delta);
+    void trimToMemoryCap();
+    void trimUndoneEntries();
+
+    deque<DofDelta> m_entries;   // Oldest first
+    deque<bool> m_entries_valid; // False once undone out of order
+    long m_first_sequence;       // Of m_entries.front()
+
+    map<int, vector<long>> m_frame_sequences; // Oldest first per frame
+
+    size_t m_memory_cap;
+    size_t m_memory_usage;
+    int m_num_entries; // Valid entries only
+};
+
+#endif // DOFUNDOHISTORY_H
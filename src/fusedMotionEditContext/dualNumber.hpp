@@ -0,0 +1,279 @@
+#ifndef DUALNUMBER_H
+#define DUALNUMBER_H
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Dofs differentiated per pass of the dual number objective
+#define DUAL_NUMBER_WIDTH 8
+
+// Not a Maya context - forward mode automatic differentiation. A dual number
+// carries a value and its derivatives along N seeded directions, and every
+// arithmetic operation applies the chain rule to them, so one evaluation of
+// a function templated on the scalar type yields N exact partials.
+// Comparisons only look at the value.
+template <int N> class DualNumber
+{
+public:
+    DualNumber() : m_value(0.0)
+    {
+        fill(m_derivatives, m_derivatives + N, 0.0);
+    }
+
+    DualNumber(double value) : m_value(value)
+    {
+        fill(m_derivatives, m_derivatives + N, 0.0);
+    }
+
+    // Seeds direction lane, or none if lane is outside [0, N)
+    DualNumber(double value, int lane) : m_value(value)
+    {
+        fill(m_derivatives, m_derivatives + N, 0.0);
+
+        if (lane >= 0 && lane < N)
+        {
+            m_derivatives[lane] = 1.0;
+        }
+    }
+
+    DualNumber &operator+=(const DualNumber &b)
+    {
+        m_value += b.m_value;
+
+        for (int i = 0; i < N; i++)
+        {
+            m_derivatives[i] += b.m_derivatives[i];
+        }
+
+        return *this;
+    }
+
+    DualNumber &operator-=(const DualNumber &b)
+    {
+        m_value -= b.m_value;
+
+        for (int i = 0; i < N; i++)
+        {
+            m_derivatives[i] -= b.m_derivatives[i];
+        }
+
+        return *this;
+    }
+
+    DualNumber &operator*=(const DualNumber &b)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            m_derivatives[i] =
+                m_derivatives[i] * b.m_value + m_value * b.m_derivatives[i];
+        }
+
+        m_value *= b.m_value;
+
+        return *this;
+    }
+
+    DualNumber &operator/=(const DualNumber &b)
+    {
+        double inverse = 1.0 / b.m_value;
+
+        m_value *= inverse;
+
+        for (int i = 0; i < N; i++)
+        {
+            m_derivatives[i] =
+                (m_derivatives[i] - m_value * b.m_derivatives[i]) * inverse;
+        }
+
+        return *this;
+    }
+
+    // Scalar factors skip the product rule
+
+    DualNumber &operator*=(double b)
+    {
+        m_value *= b;
+
+        for (int i = 0; i < N; i++)
+        {
+            m_derivatives[i] *= b;
+        }
+
+        return *this;
+    }
+
+    DualNumber &operator/=(double b) { return *this *= 1.0 / b; }
+
+    // Value of f(x) given f and its derivative at x.value
+    DualNumber chain(double value, double derivative) const
+    {
+        DualNumber result(value);
+
+        for (int i = 0; i < N; i++)
+        {
+            result.m_derivatives[i] = derivative * m_derivatives[i];
+        }
+
+        return result;
+    }
+
+    double m_value;
+    double m_derivatives[N];
+};
+
+template <int N>
+DualNumber<N> operator+(DualNumber<N> a, const DualNumber<N> &b)
+{
+    return a += b;
+}
+
+template <int N> DualNumber<N> operator+(DualNumber<N> a, double b)
+{
+    a.m_value += b;
+    return a;
+}
+
+template <int N> DualNumber<N> operator+(double a, DualNumber<N> b)
+{
+    b.m_value += a;
+    return b;
+}
+
+template <int N>
+DualNumber<N> operator-(DualNumber<N> a, const DualNumber<N> &b)
+{
+    return a -= b;
+}
+
+template <int N> DualNumber<N> operator-(DualNumber<N> a, double b)
+{
+    a.m_value -= b;
+    return a;
+}
+
+template <int N> DualNumber<N> operator-(double a, const DualNumber<N> &b)
+{
+    return DualNumber<N>(a) -= b;
+}
+
+template <int N> DualNumber<N> operator-(DualNumber<N> a)
+{
+    return a *= -1.0;
+}
+
+template <int N>
+DualNumber<N> operator*(DualNumber<N> a, const DualNumber<N> &b)
+{
+    return a *= b;
+}
+
+template <int N> DualNumber<N> operator*(DualNumber<N> a, double b)
+{
+    return a *= b;
+}
+
+template <int N> DualNumber<N> operator*(double a, DualNumber<N> b)
+{
+    return b *= a;
+}
+
+template <int N>
+DualNumber<N> operator/(DualNumber<N> a, const DualNumber<N> &b)
+{
+    return a /= b;
+}
+
+template <int N> DualNumber<N> operator/(DualNumber<N> a, double b)
+{
+    return a /= b;
+}
+
+template <int N> DualNumber<N> operator/(double a, const DualNumber<N> &b)
+{
+    return DualNumber<N>(a) /= b;
+}
+
+template <int N> bool operator<(const DualNumber<N> &a, double b)
+{
+    return a.m_value < b;
+}
+
+template <int N> bool operator>(const DualNumber<N> &a, double b)
+{
+    return a.m_value > b;
+}
+
+template <int N> bool operator<=(const DualNumber<N> &a, double b)
+{
+    return a.m_value <= b;
+}
+
+template <int N> bool operator>=(const DualNumber<N> &a, double b)
+{
+    return a.m_value >= b;
+}
+
+// Zero derivative at zero, matching the subgradient of the analytic L1 terms
+template <int N> DualNumber<N> abs(const DualNumber<N> &a)
+{
+    double sign = a.m_value > 0.0 ? 1.0 : (a.m_value < 0.0 ? -1.0 : 0.0);
+
+    return a.chain(abs(a.m_value), sign);
+}
+
+template <int N> DualNumber<N> cos(const DualNumber<N> &a)
+{
+    return a.chain(cos(a.m_value), -sin(a.m_value));
+}
+
+template <int N> DualNumber<N> sin(const DualNumber<N> &a)
+{
+    return a.chain(sin(a.m_value), cos(a.m_value));
+}
+
+// Zero derivative at zero, as the analytic distance terms skip that case
+template <int N> DualNumber<N> sqrt(const DualNumber<N> &a)
+{
+    double root = sqrt(a.m_value);
+
+    return a.chain(root, root > 0.0 ? 0.5 / root : 0.0);
+}
+
+// Lets code templated on the scalar type read values and chain in fields
+// that are only evaluated in double precision
+
+inline double getDualValue(double a) { return a; }
+
+template <int N> double getDualValue(const DualNumber<N> &a)
+{
+    return a.m_value;
+}
+
+// Value of a scalar field at a 3D point, given its value and gradient there
+inline double chainDualField(double value, const double *gradient,
+                             const double *point)
+{
+    return value;
+}
+
+template <int N>
+DualNumber<N> chainDualField(double value, const double *gradient,
+                             const DualNumber<N> *point)
+{
+    DualNumber<N> result(value);
+
+    for (int i = 0; i < N; i++)
+    {
+        result.m_derivatives[i] = gradient[0] * point[0].m_derivatives[i] +
+                                  gradient[1] * point[1].m_derivatives[i] +
+                                  gradient[2] * point[2].m_derivatives[i];
+    }
+
+    return result;
+}
+
+typedef DualNumber<DUAL_NUMBER_WIDTH> DofDual;
+
+#endif // DUALNUMBER_H
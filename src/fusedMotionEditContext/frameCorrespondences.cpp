@@ -0,0 +1,256 @@
+#include "frameCorrespondences.hpp"
+
+FrameCorrespondences::FrameCorrespondences() : m_object_inverse_set(false)
+{
+}
+
+FrameCorrespondences::~FrameCorrespondences() {}
+
+bool FrameCorrespondences::addContact(const vector<int> &handVertices,
+                                      const vector<double> &handCoords,
+                                      const double *objectPosition,
+                                      const double *objectNormal)
+{
+    int strideVertices[CORRESPONDENCE_STRIDE];
+    double strideWeights[CORRESPONDENCE_STRIDE];
+    int vertexCount;
+
+    if (!computeInterpolationWeights(handVertices, handCoords, strideVertices,
+                                     strideWeights, vertexCount))
+    {
+        return false;
+    }
+
+    m_contact_vertices.insert(m_contact_vertices.end(), strideVertices,
+                              strideVertices + CORRESPONDENCE_STRIDE);
+    m_contact_weights.insert(m_contact_weights.end(), strideWeights,
+                             strideWeights + CORRESPONDENCE_STRIDE);
+    m_contact_vertex_counts.push_back(vertexCount);
+
+    m_contact_targets.insert(m_contact_targets.end(), objectPosition,
+                             objectPosition + 3);
+    m_contact_target_normals.insert(m_contact_target_normals.end(),
+                                    objectNormal, objectNormal + 3);
+
+    return true;
+}
+
+bool FrameCorrespondences::addMarker(const vector<int> &handVertices,
+                                     const vector<double> &handCoords,
+                                     const double *markerPosition)
+{
+    int strideVertices[CORRESPONDENCE_STRIDE];
+    double strideWeights[CORRESPONDENCE_STRIDE];
+    int vertexCount;
+
+    if (!computeInterpolationWeights(handVertices, handCoords, strideVertices,
+                                     strideWeights, vertexCount))
+    {
+        return false;
+    }
+
+    m_marker_vertices.insert(m_marker_vertices.end(), strideVertices,
+                             strideVertices + CORRESPONDENCE_STRIDE);
+    m_marker_weights.insert(m_marker_weights.end(), strideWeights,
+                            strideWeights + CORRESPONDENCE_STRIDE);
+    m_marker_vertex_counts.push_back(vertexCount);
+
+    m_marker_targets.insert(m_marker_targets.end(), markerPosition,
+                            markerPosition + 3);
+
+    return true;
+}
+
+void FrameCorrespondences::clear()
+{
+    m_contact_vertices.clear();
+    m_contact_weights.clear();
+    m_contact_vertex_counts.clear();
+    m_contact_targets.clear();
+    m_contact_target_normals.clear();
+
+    m_marker_vertices.clear();
+    m_marker_weights.clear();
+    m_marker_vertex_counts.clear();
+    m_marker_targets.clear();
+
+    m_object_inverse_set = false;
+}
+
+int FrameCorrespondences::getNumContacts() const
+{
+    return m_contact_vertex_counts.size();
+}
+
+int FrameCorrespondences::getNumMarkers() const
+{
+    return m_marker_vertex_counts.size();
+}
+
+const int *FrameCorrespondences::getContactVertices(int contact) const
+{
+    return &m_contact_vertices[CORRESPONDENCE_STRIDE * contact];
+}
+
+const double *FrameCorrespondences::getContactWeights(int contact) const
+{
+    return &m_contact_weights[CORRESPONDENCE_STRIDE * contact];
+}
+
+int FrameCorrespondences::getContactVertexCount(int contact) const
+{
+    return m_contact_vertex_counts[contact];
+}
+
+const double *FrameCorrespondences::getContactTarget(int contact) const
+{
+    return &m_contact_targets[3 * contact];
+}
+
+const double *FrameCorrespondences::getContactTargetNormal(int contact) const
+{
+    return &m_contact_target_normals[3 * contact];
+}
+
+const int *FrameCorrespondences::getMarkerVertices(int marker) const
+{
+    return &m_marker_vertices[CORRESPONDENCE_STRIDE * marker];
+}
+
+const double *FrameCorrespondences::getMarkerWeights(int marker) const
+{
+    return &m_marker_weights[CORRESPONDENCE_STRIDE * marker];
+}
+
+int FrameCorrespondences::getMarkerVertexCount(int marker) const
+{
+    return m_marker_vertex_counts[marker];
+}
+
+const double *FrameCorrespondences::getMarkerTarget(int marker) const
+{
+    return &m_marker_targets[3 * marker];
+}
+
+// Null unless the frame carries the object's pose
+const double *FrameCorrespondences::getObjectInverse() const
+{
+    return m_object_inverse_set ? m_object_inverse : nullptr;
+}
+
+void FrameCorrespondences::setObjectInverse(const double *objectInverse)
+{
+    m_object_inverse_set = objectInverse != nullptr;
+
+    if (m_object_inverse_set)
+    {
+        copy(objectInverse, objectInverse + 16, m_object_inverse);
+    }
+}
+
+bool FrameCorrespondences::read(istream &in)
+{
+    FrameCorrespondences frame;
+    vector<double> objectInverse;
+
+    readBinaryVector(in, frame.m_contact_vertices);
+    readBinaryVector(in, frame.m_contact_weights);
+    readBinaryVector(in, frame.m_contact_vertex_counts);
+    readBinaryVector(in, frame.m_contact_targets);
+    readBinaryVector(in, frame.m_contact_target_normals);
+    readBinaryVector(in, frame.m_marker_vertices);
+    readBinaryVector(in, frame.m_marker_weights);
+    readBinaryVector(in, frame.m_marker_vertex_counts);
+    readBinaryVector(in, frame.m_marker_targets);
+    readBinaryVector(in, objectInverse);
+
+    size_t numContacts = frame.m_contact_vertex_counts.size();
+    size_t numMarkers = frame.m_marker_vertex_counts.size();
+    size_t contactStride = CORRESPONDENCE_STRIDE * numContacts;
+    size_t markerStride = CORRESPONDENCE_STRIDE * numMarkers;
+
+    if (!in || frame.m_contact_vertices.size() != contactStride ||
+        frame.m_contact_weights.size() != contactStride ||
+        frame.m_contact_targets.size() != 3 * numContacts ||
+        frame.m_contact_target_normals.size() != 3 * numContacts ||
+        frame.m_marker_vertices.size() != markerStride ||
+        frame.m_marker_weights.size() != markerStride ||
+        frame.m_marker_targets.size() != 3 * numMarkers ||
+        (!objectInverse.empty() && objectInverse.size() != 16))
+    {
+        return false;
+    }
+
+    frame.setObjectInverse(objectInverse.empty() ? nullptr
+                                                 : objectInverse.data());
+
+    *this = move(frame);
+
+    return true;
+}
+
+void FrameCorrespondences::write(ostream &out) const
+{
+    vector<double> objectInverse;
+
+    if (m_object_inverse_set)
+    {
+        objectInverse.assign(m_object_inverse, m_object_inverse + 16);
+    }
+
+    writeBinaryVector(out, m_contact_vertices);
+    writeBinaryVector(out, m_contact_weights);
+    writeBinaryVector(out, m_contact_vertex_counts);
+    writeBinaryVector(out, m_contact_targets);
+    writeBinaryVector(out, m_contact_target_normals);
+    writeBinaryVector(out, m_marker_vertices);
+    writeBinaryVector(out, m_marker_weights);
+    writeBinaryVector(out, m_marker_vertex_counts);
+    writeBinaryVector(out, m_marker_targets);
+    writeBinaryVector(out, objectInverse);
+}
+
+// Same interpolation as the serialized point formats - barycentric for faces,
+// linear for edges and none for vertices
+bool FrameCorrespondences::computeInterpolationWeights(
+    const vector<int> &vertices, const vector<double> &coords,
+    int *strideVertices, double *strideWeights, int &vertexCount)
+{
+    if (vertices.size() == 3 && coords.size() == 3) // Face
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            strideVertices[i] = vertices[i];
+            strideWeights[i] = coords[i];
+        }
+
+        vertexCount = 3;
+    }
+    else if (vertices.size() == 2 && coords.size() == 1) // Edge
+    {
+        strideVertices[0] = vertices[0];
+        strideVertices[1] = vertices[1];
+        strideVertices[2] = vertices[0];
+
+        strideWeights[0] = 1.0 - coords[0];
+        strideWeights[1] = coords[0];
+        strideWeights[2] = 0.0;
+
+        vertexCount = 2;
+    }
+    else if (vertices.size() == 1)
+    {
+        strideVertices[0] = strideVertices[1] = strideVertices[2] = vertices[0];
+
+        strideWeights[0] = 1.0;
+        strideWeights[1] = strideWeights[2] = 0.0;
+
+        vertexCount = 1;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
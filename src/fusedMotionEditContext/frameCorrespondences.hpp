@@ -0,0 +1,82 @@
+#ifndef FRAMECORRESPONDENCES_H
+#define FRAMECORRESPONDENCES_H
+
+#include "binaryStream.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+// Hand surface points are stored with a fixed stride so that faces, edges
+// and vertices share one layout. Unused slots carry zero weight.
+#define CORRESPONDENCE_STRIDE 3
+
+// Not a Maya context - the contact and marker correspondences of a single
+// frame, resolved once from their serialized form so that objective
+// evaluations only touch flat arrays
+class FrameCorrespondences
+{
+public:
+    FrameCorrespondences();
+    virtual ~FrameCorrespondences();
+
+    bool addContact(const vector<int> &handVertices,
+                    const vector<double> &handCoords,
+                    const double *objectPosition, const double *objectNormal);
+    bool addMarker(const vector<int> &handVertices,
+                   const vector<double> &handCoords,
+                   const double *markerPosition);
+    void clear();
+
+    int getNumContacts() const;
+    int getNumMarkers() const;
+
+    const int *getContactVertices(int contact) const;
+    const double *getContactWeights(int contact) const;
+    int getContactVertexCount(int contact) const;
+    const double *getContactTarget(int contact) const;
+    const double *getContactTargetNormal(int contact) const;
+
+    const int *getMarkerVertices(int marker) const;
+    const double *getMarkerWeights(int marker) const;
+    int getMarkerVertexCount(int marker) const;
+    const double *getMarkerTarget(int marker) const;
+
+    const double *getObjectInverse() const;
+    void setObjectInverse(const double *objectInverse);
+
+    bool read(istream &in);
+    void write(ostream &out) const;
+
+    static bool computeInterpolationWeights(const vector<int> &vertices,
+                                            const vector<double> &coords,
+                                            int *strideVertices,
+                                            double *strideWeights,
+                                            int &vertexCount);
+
+private:
+    // Contact vars
+
+    vector<int> m_contact_vertices;   // CORRESPONDENCE_STRIDE per contact
+    vector<double> m_contact_weights; // CORRESPONDENCE_STRIDE per contact
+    vector<int> m_contact_vertex_counts;
+
+    // Object surface point and normal, 3 per contact each
+    vector<double> m_contact_targets;
+    vector<double> m_contact_target_normals;
+
+    // Marker vars
+
+    vector<int> m_marker_vertices;   // CORRESPONDENCE_STRIDE per marker point
+    vector<double> m_marker_weights; // CORRESPONDENCE_STRIDE per marker point
+    vector<int> m_marker_vertex_counts;
+    vector<double> m_marker_targets; // 3 per marker point, mocap marker
+
+    // Object vars
+
+    bool m_object_inverse_set;
+    double m_object_inverse[16]; // Column vector layout, as BoxSDF
+};
+
+#endif // FRAMECORRESPONDENCES_H
@@ -0,0 +1,891 @@
+#include "frameObjective.hpp"
+
+FrameObjective::FrameObjective(const HandKinematics &kinematics,
+                               const HandSkinning &skinning)
+    : m_kinematics(kinematics), m_skinning(skinning),
+      m_correspondences(nullptr), m_table_enabled(false),
+      m_object_sdf(nullptr),
+      m_contact_distance_coefficient(1.0), m_contact_normal_coefficient(1.0),
+      m_marker_coefficient(1.0), m_contact_coefficient(1.0),
+      m_intersection_coefficient(1.0), m_prior_coefficient(50.0),
+      m_weighted_marker_error(0.0), m_weighted_contact_error(0.0),
+      m_weighted_intersection_error(0.0), m_weighted_prior_error(0.0)
+{
+}
+
+FrameObjective::~FrameObjective() {}
+
+// Exact gradient by forward mode differentiation of the templated objective,
+// DUAL_NUMBER_WIDTH dofs per pass. Independent of the analytic gradient and
+// of any step size, but far slower. Returns the objective.
+double FrameObjective::computeDualGradient(const vector<double> &dofs,
+                                           vector<double> &grad)
+{
+    int numDofs = m_kinematics.getNumDofs();
+
+    m_telemetry.numObjectiveEvaluations++;
+    m_telemetry.numGradientEvaluations++;
+
+    grad.resize(numDofs);
+    m_dual_dofs.resize(numDofs);
+
+    double objective = 0.0;
+
+    for (int first = 0; first < numDofs; first += DUAL_NUMBER_WIDTH)
+    {
+        for (int i = 0; i < numDofs; i++)
+        {
+            m_dual_dofs[i] = DofDual(dofs[i], i - first);
+        }
+
+        DofDual result = evaluateObjective(m_dual_dofs, m_dual_pose);
+
+        int numLanes = min(DUAL_NUMBER_WIDTH, numDofs - first);
+
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            grad[first + lane] = result.m_derivatives[lane];
+        }
+
+        objective = result.m_value;
+    }
+
+    return objective;
+}
+
+// Gauss-Newton model of the objective (row major hessian). Distance, table
+// and prior terms are L1 style, so each is reweighted into a least squares
+// residual that matches its value and gradient at the given dofs. Normal
+// anti-alignment is exactly |n_hand + n_object|^2 / 2. Returns the objective.
+double FrameObjective::computeNormalEquations(const vector<double> &dofs,
+                                              vector<double> &hessian,
+                                              vector<double> &gradient)
+{
+    int numDofs = m_kinematics.getNumDofs();
+
+    vector<double> noGrad;
+
+    m_telemetry.numObjectiveEvaluations++;
+    m_telemetry.numGradientEvaluations++;
+
+    double objective = computeTerms(dofs, noGrad);
+
+    TelemetryClock termStart = SolveTelemetry::now();
+
+    m_kinematics.computeDofAxes(m_pose, m_dof_axes, m_dof_pivots);
+
+    m_telemetry.kinematicsTime += SolveTelemetry::secondsSince(termStart);
+
+    hessian.assign(numDofs * numDofs, 0.0);
+    gradient.assign(numDofs, 0.0);
+    m_jacobian_row.assign(numDofs, 0.0);
+
+    static const double identity[9] = {1.0, 0.0, 0.0, 0.0, 1.0,
+                                       0.0, 0.0, 0.0, 1.0};
+
+    double position[3];
+    double normal[3];
+
+    // Step 1: L1 prior, diagonal only
+
+    termStart = SolveTelemetry::now();
+
+    for (int i = 6; i < numDofs; i++)
+    {
+        double priorDifference = dofs[i] - m_prior_dofs[i];
+        double weight = m_prior_coefficient /
+                        max(abs(priorDifference), REWEIGHT_EPSILON);
+
+        hessian[numDofs * i + i] += weight;
+        gradient[i] += weight * priorDifference;
+    }
+
+    m_telemetry.priorTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 2: Contact distance and normal anti-alignment
+
+    termStart = SolveTelemetry::now();
+
+    double contactDistanceCoefficient =
+        m_contact_coefficient * m_contact_distance_coefficient;
+    double contactNormalCoefficient =
+        m_contact_coefficient * m_contact_normal_coefficient;
+
+    int numContacts =
+        m_correspondences ? m_correspondences->getNumContacts() : 0;
+
+    for (int i = 0; i < numContacts; i++)
+    {
+        const int *vertices = m_correspondences->getContactVertices(i);
+        const double *weights = m_correspondences->getContactWeights(i);
+        int numVertices = m_correspondences->getContactVertexCount(i);
+
+        const double *target = m_correspondences->getContactTarget(i);
+        const double *targetNormal =
+            m_correspondences->getContactTargetNormal(i);
+
+        m_skinning.computePoint(m_pose, vertices, weights, numVertices,
+                                position, normal);
+
+        double offset[3];
+        double normalSum[3];
+
+        for (int c = 0; c < 3; c++)
+        {
+            offset[c] = position[c] - target[c];
+            normalSum[c] = normal[c] + targetNormal[c];
+        }
+
+        double distance = sqrt(offset[0] * offset[0] + offset[1] * offset[1] +
+                               offset[2] * offset[2]);
+
+        accumulateResidualRows(vertices, weights, numVertices, identity, 3,
+                               false, offset,
+                               contactDistanceCoefficient /
+                                   max(distance, REWEIGHT_EPSILON),
+                               hessian, gradient);
+
+        accumulateResidualRows(vertices, weights, numVertices, identity, 3,
+                               true, normalSum, contactNormalCoefficient,
+                               hessian, gradient);
+    }
+
+    m_telemetry.contactTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 3: Marker distance
+
+    termStart = SolveTelemetry::now();
+
+    int numMarkers = m_correspondences ? m_correspondences->getNumMarkers() : 0;
+
+    for (int i = 0; i < numMarkers; i++)
+    {
+        const int *vertices = m_correspondences->getMarkerVertices(i);
+        const double *weights = m_correspondences->getMarkerWeights(i);
+        int numVertices = m_correspondences->getMarkerVertexCount(i);
+
+        const double *target = m_correspondences->getMarkerTarget(i);
+
+        m_skinning.computePoint(m_pose, vertices, weights, numVertices,
+                                position, normal);
+
+        double offset[3] = {position[0] - target[0], position[1] - target[1],
+                            position[2] - target[2]};
+
+        double distance = sqrt(offset[0] * offset[0] + offset[1] * offset[1] +
+                               offset[2] * offset[2]);
+
+        accumulateResidualRows(vertices, weights, numVertices, identity, 3,
+                               false, offset,
+                               m_marker_coefficient /
+                                   max(distance, REWEIGHT_EPSILON),
+                               hessian, gradient);
+    }
+
+    m_telemetry.markerTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 4: Table and object penetration, one row per penetrating vertex
+
+    if (m_intersection_coefficient <= 0.0 ||
+        (!m_table_enabled && !getObjectInverse()))
+    {
+        return objective;
+    }
+
+    termStart = SolveTelemetry::now();
+
+    int numBones = m_skinning.getNumBones();
+
+    double vertexWeight = 1.0;
+
+    for (int b = 0; b < numBones; b++)
+    {
+        bool reached[2];
+
+        if (!findReachedFields(b, reached))
+        {
+            continue;
+        }
+
+        const int *vertices = m_skinning.getBoneVertices(b);
+        int numVertices = m_skinning.getBoneVertexCount(b);
+
+        m_vertex_xs.resize(numVertices);
+        m_vertex_ys.resize(numVertices);
+        m_vertex_zs.resize(numVertices);
+
+        m_skinning.computeVertexPositions(m_pose, vertices, numVertices,
+                                          m_vertex_xs.data(),
+                                          m_vertex_ys.data(),
+                                          m_vertex_zs.data());
+
+        for (int field = 0; field < 2; field++)
+        {
+            if (!reached[field])
+            {
+                continue;
+            }
+
+            m_penetrating_vertices.clear();
+
+            computeFieldPenetration(field == 1, numVertices,
+                                    &m_penetrating_vertices);
+
+            for (int k : m_penetrating_vertices)
+            {
+                double vertexPosition[3] = {m_vertex_xs[k], m_vertex_ys[k],
+                                            m_vertex_zs[k]};
+                double sdfGradient[3];
+
+                double signedDistance = computeFieldDistance(
+                    field == 1, vertexPosition, sdfGradient);
+
+                accumulateResidualRows(
+                    &vertices[k], &vertexWeight, 1, sdfGradient, 1, false,
+                    &signedDistance,
+                    m_intersection_coefficient /
+                        max(-signedDistance, REWEIGHT_EPSILON),
+                    hessian, gradient);
+            }
+        }
+    }
+
+    m_telemetry.intersectionTime += SolveTelemetry::secondsSince(termStart);
+
+    return objective;
+}
+
+double FrameObjective::computeObjective(const vector<double> &dofs,
+                                        vector<double> &grad)
+{
+    m_telemetry.numObjectiveEvaluations++;
+
+    if (grad.size() > 0)
+    {
+        m_telemetry.numGradientEvaluations++;
+    }
+
+    return computeTerms(dofs, grad);
+}
+
+// The templated objective in double precision, without any culling. Should
+// match computeObjective up to rounding.
+double
+FrameObjective::computeReferenceObjective(const vector<double> &dofs) const
+{
+    HandPose pose;
+
+    return evaluateObjective(dofs, pose);
+}
+
+const HandPose &FrameObjective::getPose() const { return m_pose; }
+
+const FrameTelemetry &FrameObjective::getTelemetry() const
+{
+    return m_telemetry;
+}
+
+void FrameObjective::getWeightedErrors(double &markerError,
+                                       double &contactError,
+                                       double &intersectionError,
+                                       double &priorError) const
+{
+    markerError = m_weighted_marker_error;
+    contactError = m_weighted_contact_error;
+    intersectionError = m_weighted_intersection_error;
+    priorError = m_weighted_prior_error;
+}
+
+void FrameObjective::resetTelemetry() { m_telemetry = FrameTelemetry(); }
+
+void FrameObjective::setCoefficients(double contactDistance,
+                                     double contactNormal, double marker,
+                                     double contact, double intersection,
+                                     double prior)
+{
+    m_contact_distance_coefficient = contactDistance;
+    m_contact_normal_coefficient = contactNormal;
+    m_marker_coefficient = marker;
+    m_contact_coefficient = contact;
+    m_intersection_coefficient = intersection;
+    m_prior_coefficient = prior;
+}
+
+void FrameObjective::setCorrespondences(
+    const FrameCorrespondences *correspondences)
+{
+    m_correspondences = correspondences;
+}
+
+// Null disables the object term. The grid is only read, so it can be shared
+// by every thread's objective.
+void FrameObjective::setObjectSDF(const ObjectSDF *objectSDF)
+{
+    m_object_sdf = objectSDF;
+}
+
+void FrameObjective::setPriorDofs(const vector<double> &priorDofs)
+{
+    m_prior_dofs = priorDofs;
+}
+
+// Inverse uses the conventional column vector layout, null disables the
+// table term
+void FrameObjective::setTable(const double *tableInverse,
+                              const double *tableHalfDims)
+{
+    m_table_enabled = tableInverse != nullptr;
+
+    if (!m_table_enabled)
+    {
+        return;
+    }
+
+    m_table.setBox(tableInverse, tableHalfDims);
+}
+
+double FrameObjective::optimizerWrapper(const vector<double> &x,
+                                        vector<double> &grad, void *data)
+{
+    FrameObjective *pObjective = (FrameObjective *)data;
+    if (!pObjective)
+    {
+        return numeric_limits<double>::quiet_NaN();
+    }
+
+    return pObjective->computeObjective(x, grad);
+}
+
+// Each row is the derivative of the point position (or normal) along one
+// direction. Rows are only nonzero over the dofs that move the point's
+// joints, so the hessian update stays within that block.
+void FrameObjective::accumulateResidualRows(
+    const int *vertices, const double *weights, int numVertices,
+    const double *rowDirections, int numRows, bool normalRows,
+    const double *residuals, double residualWeight, vector<double> &hessian,
+    vector<double> &gradient)
+{
+    int numDofs = m_kinematics.getNumDofs();
+
+    double noWeight[3] = {0.0, 0.0, 0.0};
+
+    m_skinning.collectPointDofs(m_kinematics, vertices, numVertices,
+                                m_block_dofs);
+
+    int numBlockDofs = m_block_dofs.size();
+
+    m_block_jacobian.resize(numRows * numBlockDofs);
+
+    for (int r = 0; r < numRows; r++)
+    {
+        const double *direction = &rowDirections[3 * r];
+
+        m_skinning.accumulatePointGradient(
+            m_kinematics, m_pose, m_dof_axes, m_dof_pivots, vertices, weights,
+            numVertices, normalRows ? noWeight : direction,
+            normalRows ? direction : noWeight, m_jacobian_row);
+
+        for (int a = 0; a < numBlockDofs; a++)
+        {
+            double &entry = m_jacobian_row[m_block_dofs[a]];
+
+            m_block_jacobian[numBlockDofs * r + a] = entry;
+            entry = 0.0;
+        }
+    }
+
+    for (int a = 0; a < numBlockDofs; a++)
+    {
+        int rowDof = m_block_dofs[a];
+
+        for (int r = 0; r < numRows; r++)
+        {
+            double weightedEntry =
+                residualWeight * m_block_jacobian[numBlockDofs * r + a];
+
+            gradient[rowDof] += weightedEntry * residuals[r];
+
+            for (int b = 0; b < numBlockDofs; b++)
+            {
+                hessian[numDofs * rowDof + m_block_dofs[b]] +=
+                    weightedEntry * m_block_jacobian[numBlockDofs * r + b];
+            }
+        }
+    }
+}
+
+// Skins the bone's vertices in one pass and batch tests them against the
+// table and the object, skipping any field the bone bounds cannot reach
+double FrameObjective::computeBonePenetration(int bone, bool gradientRequested,
+                                              vector<double> &grad)
+{
+    bool reached[2];
+
+    if (!findReachedFields(bone, reached))
+    {
+        return 0.0;
+    }
+
+    const int *vertices = m_skinning.getBoneVertices(bone);
+    int numVertices = m_skinning.getBoneVertexCount(bone);
+
+    m_vertex_xs.resize(numVertices);
+    m_vertex_ys.resize(numVertices);
+    m_vertex_zs.resize(numVertices);
+
+    m_skinning.computeVertexPositions(m_pose, vertices, numVertices,
+                                      m_vertex_xs.data(), m_vertex_ys.data(),
+                                      m_vertex_zs.data());
+
+    double penetration = 0.0;
+
+    double noNormalWeight[3] = {0.0, 0.0, 0.0};
+    double vertexWeight = 1.0;
+
+    for (int field = 0; field < 2; field++)
+    {
+        if (!reached[field])
+        {
+            continue;
+        }
+
+        m_penetrating_vertices.clear();
+
+        penetration += computeFieldPenetration(
+            field == 1, numVertices,
+            gradientRequested ? &m_penetrating_vertices : nullptr);
+
+        for (int k : m_penetrating_vertices)
+        {
+            double position[3] = {m_vertex_xs[k], m_vertex_ys[k],
+                                  m_vertex_zs[k]};
+            double sdfGradient[3];
+
+            computeFieldDistance(field == 1, position, sdfGradient);
+
+            double positionWeight[3];
+
+            for (int c = 0; c < 3; c++)
+            {
+                positionWeight[c] =
+                    sdfGradient[c] * (-1.0 * m_intersection_coefficient);
+            }
+
+            m_skinning.accumulatePointGradient(
+                m_kinematics, m_pose, m_dof_axes, m_dof_pivots, &vertices[k],
+                &vertexWeight, 1, positionWeight, noNormalWeight, grad);
+        }
+    }
+
+    return penetration;
+}
+
+double FrameObjective::computeFieldDistance(bool object, const double *point,
+                                            double *gradient) const
+{
+    if (object)
+    {
+        return m_object_sdf->computeDistance(getObjectInverse(), point,
+                                             gradient);
+    }
+
+    return m_table.computeDistance(point, gradient);
+}
+
+// Tests the skinned vertices in the scratch arrays
+double
+FrameObjective::computeFieldPenetration(bool object, int numVertices,
+                                        vector<int> *penetratingVertices) const
+{
+    if (object)
+    {
+        return m_object_sdf->computePenetration(
+            getObjectInverse(), m_vertex_xs.data(), m_vertex_ys.data(),
+            m_vertex_zs.data(), numVertices, penetratingVertices);
+    }
+
+    return m_table.computePenetration(m_vertex_xs.data(), m_vertex_ys.data(),
+                                      m_vertex_zs.data(), numVertices,
+                                      penetratingVertices);
+}
+
+double FrameObjective::computeIntersectionError(bool gradientRequested,
+                                                vector<double> &grad)
+{
+    int numBones = m_skinning.getNumBones();
+
+    double intersectionError = 0.0;
+
+    for (int b = 0; b < numBones; b++)
+    {
+        intersectionError += computeBonePenetration(b, gradientRequested, grad);
+    }
+
+    return intersectionError;
+}
+
+double FrameObjective::computeTerms(const vector<double> &dofs,
+                                   vector<double> &grad)
+{
+    bool gradientRequested = grad.size() > 0;
+
+    int numDofs = m_kinematics.getNumDofs();
+
+    TelemetryClock termStart = SolveTelemetry::now();
+
+    m_kinematics.computePose(dofs, m_pose);
+
+    if (gradientRequested)
+    {
+        fill(grad.begin(), grad.end(), 0.0);
+        m_kinematics.computeDofAxes(m_pose, m_dof_axes, m_dof_pivots);
+    }
+
+    m_telemetry.kinematicsTime += SolveTelemetry::secondsSince(termStart);
+
+    double position[3];
+    double normal[3];
+
+    double noNormalWeight[3] = {0.0, 0.0, 0.0};
+
+    // Step 1: L1 prior
+
+    termStart = SolveTelemetry::now();
+
+    double priorError = 0.0;
+
+    for (int i = 0; i < numDofs; i++)
+    {
+        // Do not include base movement in prior error
+        if (i > 5)
+        {
+            double priorDifference = dofs[i] - m_prior_dofs[i];
+
+            priorError += abs(priorDifference);
+
+            if (!gradientRequested)
+            {
+                continue;
+            }
+
+            if (priorDifference > 0.0)
+            {
+                grad[i] += m_prior_coefficient;
+            }
+            else if (priorDifference < 0.0)
+            {
+                grad[i] -= m_prior_coefficient;
+            }
+        }
+    }
+
+    m_telemetry.priorTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 2: Contact point-to-point distance and normal anti-alignment
+
+    termStart = SolveTelemetry::now();
+
+    double contactDistanceError = 0.0;
+    double contactNormalError = 0.0;
+
+    double contactDistanceCoefficient =
+        m_contact_coefficient * m_contact_distance_coefficient;
+    double contactNormalCoefficient =
+        m_contact_coefficient * m_contact_normal_coefficient;
+
+    int numContacts =
+        m_correspondences ? m_correspondences->getNumContacts() : 0;
+
+    for (int i = 0; i < numContacts; i++)
+    {
+        const int *vertices = m_correspondences->getContactVertices(i);
+        const double *weights = m_correspondences->getContactWeights(i);
+        int numVertices = m_correspondences->getContactVertexCount(i);
+
+        const double *target = m_correspondences->getContactTarget(i);
+        const double *targetNormal =
+            m_correspondences->getContactTargetNormal(i);
+
+        m_skinning.computePoint(m_pose, vertices, weights, numVertices,
+                                position, normal);
+
+        double offset[3] = {position[0] - target[0], position[1] - target[1],
+                            position[2] - target[2]};
+
+        double distance = sqrt(offset[0] * offset[0] + offset[1] * offset[1] +
+                               offset[2] * offset[2]);
+
+        contactDistanceError += distance;
+        contactNormalError +=
+            1.0 + (targetNormal[0] * normal[0] + targetNormal[1] * normal[1] +
+                   targetNormal[2] * normal[2]);
+
+        if (!gradientRequested)
+        {
+            continue;
+        }
+
+        double positionWeight[3] = {0.0, 0.0, 0.0};
+        double normalWeight[3];
+
+        for (int c = 0; c < 3; c++)
+        {
+            if (distance > 0.0)
+            {
+                positionWeight[c] =
+                    offset[c] * (contactDistanceCoefficient / distance);
+            }
+
+            normalWeight[c] = targetNormal[c] * contactNormalCoefficient;
+        }
+
+        m_skinning.accumulatePointGradient(
+            m_kinematics, m_pose, m_dof_axes, m_dof_pivots, vertices, weights,
+            numVertices, positionWeight, normalWeight, grad);
+    }
+
+    double contactError =
+        m_contact_distance_coefficient * contactDistanceError +
+        m_contact_normal_coefficient * contactNormalError;
+
+    m_telemetry.contactTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 3: Marker point-to-marker distance
+
+    termStart = SolveTelemetry::now();
+
+    double markerError = 0.0;
+
+    int numMarkers = m_correspondences ? m_correspondences->getNumMarkers() : 0;
+
+    for (int i = 0; i < numMarkers; i++)
+    {
+        const int *vertices = m_correspondences->getMarkerVertices(i);
+        const double *weights = m_correspondences->getMarkerWeights(i);
+        int numVertices = m_correspondences->getMarkerVertexCount(i);
+
+        const double *target = m_correspondences->getMarkerTarget(i);
+
+        m_skinning.computePoint(m_pose, vertices, weights, numVertices,
+                                position, normal);
+
+        double offset[3] = {position[0] - target[0], position[1] - target[1],
+                            position[2] - target[2]};
+
+        double distance = sqrt(offset[0] * offset[0] + offset[1] * offset[1] +
+                               offset[2] * offset[2]);
+
+        markerError += distance;
+
+        if (!gradientRequested || distance <= 0.0)
+        {
+            continue;
+        }
+
+        double positionWeight[3];
+
+        for (int c = 0; c < 3; c++)
+        {
+            positionWeight[c] = offset[c] * (m_marker_coefficient / distance);
+        }
+
+        m_skinning.accumulatePointGradient(
+            m_kinematics, m_pose, m_dof_axes, m_dof_pivots, vertices, weights,
+            numVertices, positionWeight, noNormalWeight, grad);
+    }
+
+    m_telemetry.markerTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 4: Table and object intersection, only penetrating vertices
+    // contribute
+
+    termStart = SolveTelemetry::now();
+
+    double intersectionError = 0.0;
+
+    if (m_intersection_coefficient > 0.0 &&
+        (m_table_enabled || getObjectInverse()))
+    {
+        intersectionError = computeIntersectionError(gradientRequested, grad);
+    }
+
+    m_telemetry.intersectionTime += SolveTelemetry::secondsSince(termStart);
+
+    // Step 5: Total weighted errors
+
+    m_weighted_marker_error = m_marker_coefficient * markerError;
+    m_weighted_contact_error = m_contact_coefficient * contactError;
+    m_weighted_intersection_error =
+        m_intersection_coefficient * intersectionError;
+    m_weighted_prior_error = m_prior_coefficient * priorError;
+
+    return m_weighted_marker_error + m_weighted_contact_error +
+           m_weighted_intersection_error + m_weighted_prior_error;
+}
+
+// The terms of computeTerms for any scalar type, with every hand vertex
+// tested for intersection. Field distances are evaluated in double precision
+// and chained into the scalar type through their gradients.
+template <typename Scalar>
+Scalar FrameObjective::evaluateObjective(const vector<Scalar> &dofs,
+                                         ScalarHandPose<Scalar> &pose) const
+{
+    int numDofs = m_kinematics.getNumDofs();
+
+    m_kinematics.computePose(dofs, pose);
+
+    Scalar position[3];
+    Scalar normal[3];
+
+    // Step 1: L1 prior, without base movement
+
+    Scalar priorError = 0.0;
+
+    for (int i = 6; i < numDofs; i++)
+    {
+        priorError += abs(dofs[i] - m_prior_dofs[i]);
+    }
+
+    // Step 2: Contact point-to-point distance and normal anti-alignment
+
+    Scalar contactDistanceError = 0.0;
+    Scalar contactNormalError = 0.0;
+
+    int numContacts =
+        m_correspondences ? m_correspondences->getNumContacts() : 0;
+
+    for (int i = 0; i < numContacts; i++)
+    {
+        const double *target = m_correspondences->getContactTarget(i);
+        const double *targetNormal =
+            m_correspondences->getContactTargetNormal(i);
+
+        m_skinning.computePoint(pose, m_correspondences->getContactVertices(i),
+                                m_correspondences->getContactWeights(i),
+                                m_correspondences->getContactVertexCount(i),
+                                position, normal);
+
+        Scalar offset[3] = {position[0] - target[0], position[1] - target[1],
+                            position[2] - target[2]};
+
+        contactDistanceError += sqrt(offset[0] * offset[0] +
+                                     offset[1] * offset[1] +
+                                     offset[2] * offset[2]);
+        contactNormalError +=
+            1.0 + (targetNormal[0] * normal[0] + targetNormal[1] * normal[1] +
+                   targetNormal[2] * normal[2]);
+    }
+
+    Scalar contactError =
+        m_contact_distance_coefficient * contactDistanceError +
+        m_contact_normal_coefficient * contactNormalError;
+
+    // Step 3: Marker point-to-marker distance
+
+    Scalar markerError = 0.0;
+
+    int numMarkers = m_correspondences ? m_correspondences->getNumMarkers() : 0;
+
+    for (int i = 0; i < numMarkers; i++)
+    {
+        const double *target = m_correspondences->getMarkerTarget(i);
+
+        m_skinning.computePoint(pose, m_correspondences->getMarkerVertices(i),
+                                m_correspondences->getMarkerWeights(i),
+                                m_correspondences->getMarkerVertexCount(i),
+                                position, normal);
+
+        Scalar offset[3] = {position[0] - target[0], position[1] - target[1],
+                            position[2] - target[2]};
+
+        markerError += sqrt(offset[0] * offset[0] + offset[1] * offset[1] +
+                            offset[2] * offset[2]);
+    }
+
+    // Step 4: Table and object intersection
+
+    Scalar intersectionError = 0.0;
+
+    const double *objectInverse = getObjectInverse();
+
+    if (m_intersection_coefficient > 0.0 && (m_table_enabled || objectInverse))
+    {
+        int numVertices = m_skinning.getNumVertices();
+
+        for (int v = 0; v < numVertices; v++)
+        {
+            Scalar point[3];
+
+            m_skinning.computeVertexPositions(pose, &v, 1, &point[0],
+                                              &point[1], &point[2]);
+
+            double pointValue[3] = {getDualValue(point[0]),
+                                    getDualValue(point[1]),
+                                    getDualValue(point[2])};
+            double sdfGradient[3];
+
+            if (m_table_enabled)
+            {
+                double distance =
+                    m_table.computeDistance(pointValue, sdfGradient);
+
+                if (distance < 0.0)
+                {
+                    intersectionError -=
+                        chainDualField(distance, sdfGradient, point);
+                }
+            }
+
+            if (objectInverse)
+            {
+                double distance = m_object_sdf->computeDistance(
+                    objectInverse, pointValue, sdfGradient);
+
+                if (distance < 0.0)
+                {
+                    intersectionError -=
+                        chainDualField(distance, sdfGradient, point);
+                }
+            }
+        }
+    }
+
+    // Step 5: Total weighted errors
+
+    return m_marker_coefficient * markerError +
+           m_contact_coefficient * contactError +
+           m_intersection_coefficient * intersectionError +
+           m_prior_coefficient * priorError;
+}
+
+// Field 0 is the table and field 1 the object. Returns whether either can be
+// reached.
+bool FrameObjective::findReachedFields(int bone, bool *reached) const
+{
+    const double *objectInverse = getObjectInverse();
+
+    double boundsMin[3];
+    double boundsMax[3];
+
+    bool bounded =
+        m_skinning.computeBoneBounds(m_pose, bone, boundsMin, boundsMax);
+
+    reached[0] = m_table_enabled &&
+                 (!bounded || m_table.overlapsBounds(boundsMin, boundsMax));
+    reached[1] = objectInverse &&
+                 (!bounded || m_object_sdf->overlapsBounds(
+                                  objectInverse, boundsMin, boundsMax));
+
+    return reached[0] || reached[1];
+}
+
+// Null unless there is an object grid and the frame carries the object pose
+const double *FrameObjective::getObjectInverse() const
+{
+    if (!m_object_sdf || !m_correspondences)
+    {
+        return nullptr;
+    }
+
+    return m_correspondences->getObjectInverse();
+}
@@ -0,0 +1,130 @@
+#ifndef FRAMEOBJECTIVE_H
+#define FRAMEOBJECTIVE_H
+
+#include "boxSDF.hpp"
+#include "frameCorrespondences.hpp"
+#include "handSkinning.hpp"
+#include "objectSDF.hpp"
+#include "solveTelemetry.hpp"
+
+#include <limits>
+
+// Smallest residual magnitude used when reweighting the L1 style terms
+#define REWEIGHT_EPSILON 1e-3
+
+// Not a Maya context - the fused objective of a single frame (Eq 3 of the
+// paper) and its analytic gradient, evaluated entirely on native kinematics
+// and skinning. Holds its own pose scratch so that one instance per thread
+// can share the same rig. The same terms are also templated on the scalar
+// type, and evaluated with dual numbers for an exact reference gradient.
+class FrameObjective
+{
+public:
+    FrameObjective(const HandKinematics &kinematics,
+                   const HandSkinning &skinning);
+    virtual ~FrameObjective();
+
+    double computeDualGradient(const vector<double> &dofs,
+                               vector<double> &grad);
+    double computeNormalEquations(const vector<double> &dofs,
+                                  vector<double> &hessian,
+                                  vector<double> &gradient);
+    double computeObjective(const vector<double> &dofs, vector<double> &grad);
+    double computeReferenceObjective(const vector<double> &dofs) const;
+
+    const HandPose &getPose() const;
+    const FrameTelemetry &getTelemetry() const;
+    void getWeightedErrors(double &markerError, double &contactError,
+                           double &intersectionError,
+                           double &priorError) const;
+
+    void resetTelemetry();
+
+    void setCoefficients(double contactDistance, double contactNormal,
+                         double marker, double contact, double intersection,
+                         double prior);
+    void setCorrespondences(const FrameCorrespondences *correspondences);
+    void setObjectSDF(const ObjectSDF *objectSDF);
+    void setPriorDofs(const vector<double> &priorDofs);
+    void setTable(const double *tableInverse, const double *tableHalfDims);
+
+    static double optimizerWrapper(const vector<double> &x,
+                                   vector<double> &grad, void *data);
+
+private:
+    void accumulateResidualRows(const int *vertices, const double *weights,
+                                int numVertices, const double *rowDirections,
+                                int numRows, bool normalRows,
+                                const double *residuals, double residualWeight,
+                                vector<double> &hessian,
+                                vector<double> &gradient);
+    double computeBonePenetration(int bone, bool gradientRequested,
+                                  vector<double> &grad);
+    double computeFieldDistance(bool object, const double *point,
+                                double *gradient) const;
+    double computeFieldPenetration(bool object, int numVertices,
+                                   vector<int> *penetratingVertices) const;
+    double computeIntersectionError(bool gradientRequested,
+                                    vector<double> &grad);
+    double computeTerms(const vector<double> &dofs, vector<double> &grad);
+    template <typename Scalar>
+    Scalar evaluateObjective(const vector<Scalar> &dofs,
+                             ScalarHandPose<Scalar> &pose) const;
+    bool findReachedFields(int bone, bool *reached) const;
+    const double *getObjectInverse() const;
+
+    const HandKinematics &m_kinematics;
+    const HandSkinning &m_skinning;
+
+    // Frame vars
+
+    const FrameCorrespondences *m_correspondences;
+    vector<double> m_prior_dofs;
+
+    // Table vars
+
+    bool m_table_enabled;
+    BoxSDF m_table;
+
+    // Object vars
+
+    const ObjectSDF *m_object_sdf; // Shared, posed by the correspondences
+
+    // Coefficient vars
+
+    double m_contact_distance_coefficient;
+    double m_contact_normal_coefficient;
+    double m_marker_coefficient;
+    double m_contact_coefficient;
+    double m_intersection_coefficient;
+    double m_prior_coefficient;
+
+    // Scratch vars
+
+    HandPose m_pose;
+    vector<double> m_dof_axes;
+    vector<double> m_dof_pivots;
+    vector<double> m_vertex_xs;
+    vector<double> m_vertex_ys;
+    vector<double> m_vertex_zs;
+    vector<int> m_penetrating_vertices;
+    vector<double> m_jacobian_row;   // Dense, kept zeroed between rows
+    vector<double> m_block_jacobian; // Rows over m_block_dofs
+    vector<int> m_block_dofs;
+
+    // Dual number scratch
+
+    DualHandPose m_dual_pose;
+    vector<DofDual> m_dual_dofs;
+
+    // Last evaluation
+
+    double m_weighted_marker_error;
+    double m_weighted_contact_error;
+    double m_weighted_intersection_error;
+    double m_weighted_prior_error;
+
+    FrameTelemetry m_telemetry; // Since the last reset
+};
+
+#endif // FRAMEOBJECTIVE_H
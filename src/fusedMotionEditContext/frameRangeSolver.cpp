@@ -0,0 +1,228 @@
+#include "frameRangeSolver.hpp"
+
+FusedSolveSettings::FusedSolveSettings()
+    : contactDistanceCoefficient(1.0), contactNormalCoefficient(1.0),
+      markerCoefficient(1.0), contactCoefficient(1.0),
+      intersectionCoefficient(1.0), priorCoefficient(50.0),
+      numIterations(100), leastSquares(false), warmStartChunkSize(1),
+      temporalWarmStart(false), tableEnabled(false)
+{
+    fill(tableInverse, tableInverse + MATRIX_SIZE, 0.0);
+    fill(tableHalfDims, tableHalfDims + 3, 0.0);
+}
+
+FrameRangeSolver::FrameRangeSolver(const HandKinematics &kinematics,
+                                   const HandSkinning &skinning,
+                                   const ObjectSDF &objectSDF)
+    : m_kinematics(kinematics), m_skinning(skinning), m_object_sdf(objectSDF)
+{
+}
+
+FrameRangeSolver::~FrameRangeSolver() {}
+
+void FrameRangeSolver::setDofLimits(const vector<double> &lowerLimits,
+                                    const vector<double> &upperLimits)
+{
+    m_dof_lower_limits = lowerLimits;
+    m_dof_upper_limits = upperLimits;
+}
+
+void FrameRangeSolver::setSettings(const FusedSolveSettings &settings)
+{
+    m_settings = settings;
+}
+
+// Frames that fail keep their input dofs. Returns the number of failures.
+// Scene times already in frameTelemetry are kept.
+int FrameRangeSolver::solve(
+    int numThreads, int frameStart,
+    const vector<FrameCorrespondences> &frameCorrespondences,
+    const vector<vector<double>> &frameDofs,
+    vector<vector<double>> &frameSolutions,
+    vector<FrameTelemetry> &frameTelemetry,
+    vector<int> &frameIterations) const
+{
+    int numFrames = frameDofs.size();
+    int numDofs = m_kinematics.getNumDofs();
+
+    frameSolutions.assign(numFrames, vector<double>());
+    frameTelemetry.resize(numFrames);
+    frameIterations.assign(numFrames, 0);
+
+    if (numFrames == 0)
+    {
+        return 0;
+    }
+
+    // Step 1: Per-thread objectives and optimizers. Both vectors are sized
+    // up front since nlopt keeps pointers into them.
+
+    TaskPool pool(numThreads);
+    numThreads = pool.getNumThreads();
+
+    vector<FrameObjective> objectives;
+    objectives.reserve(numThreads);
+
+    vector<nlopt::opt> optimizers;
+    optimizers.reserve(numThreads);
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        objectives.emplace_back(m_kinematics, m_skinning);
+
+        configureObjective(m_settings, m_object_sdf, objectives[t]);
+    }
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        optimizers.emplace_back(nlopt::LD_MMA, numDofs);
+        optimizers[t].set_min_objective(&FrameObjective::optimizerWrapper,
+                                        (void *)&objectives[t]);
+
+        optimizers[t].set_xtol_rel(1e-4);
+        optimizers[t].set_maxeval(m_settings.numIterations);
+    }
+
+    // Step 2: Solve. Frames within a chunk start from the previous frame's
+    // solution, or its constant velocity extrapolation, but stay anchored to
+    // their own prior.
+
+    int chunkSize = max(m_settings.warmStartChunkSize, 1);
+    int numChunks = (numFrames + chunkSize - 1) / chunkSize;
+
+    vector<int> frameFailures(numFrames, 0);
+
+    // Extrapolations are clamped to the joint limits
+    bool extrapolate = m_settings.temporalWarmStart &&
+                       (int)m_dof_lower_limits.size() == numDofs &&
+                       (int)m_dof_upper_limits.size() == numDofs;
+
+    pool.run(numChunks,
+             [&](int worker, int chunk)
+             {
+                 FrameObjective &objective = objectives[worker];
+                 nlopt::opt &optim = optimizers[worker];
+
+                 LevenbergMarquardt solver(objective);
+                 solver.setMaxIterations(m_settings.numIterations);
+
+                 int chunkStart = chunk * chunkSize;
+                 int chunkEnd = min(chunkStart + chunkSize, numFrames);
+
+                 for (int i = chunkStart; i < chunkEnd; i++)
+                 {
+                     objective.setCorrespondences(&frameCorrespondences[i]);
+                     objective.setPriorDofs(frameDofs[i]);
+
+                     vector<double> x = (i > chunkStart) ? frameSolutions[i - 1]
+                                                         : frameDofs[i];
+                     double minf = 0.0;
+                     int resultCode;
+
+                     if (extrapolate && i > chunkStart + 1)
+                     {
+                         extrapolateDofs(frameSolutions[i - 1],
+                                         frameSolutions[i - 2],
+                                         m_dof_lower_limits,
+                                         m_dof_upper_limits, x);
+                     }
+
+                     objective.resetTelemetry();
+
+                     TelemetryClock solveStart = SolveTelemetry::now();
+
+                     try
+                     {
+                         if (m_settings.leastSquares)
+                         {
+                             frameIterations[i] = solver.solve(x, minf);
+                             resultCode = solver.getResult();
+                         }
+                         else
+                         {
+                             resultCode = optim.optimize(x, minf);
+                             frameIterations[i] =
+                                 objective.getTelemetry()
+                                     .numObjectiveEvaluations;
+                         }
+                     }
+                     catch (exception &)
+                     {
+                         // Same as a sequential failure - keep the input
+                         x = frameDofs[i];
+                         frameFailures[i] = 1;
+
+                         if (m_settings.leastSquares)
+                         {
+                             resultCode = nlopt::FAILURE;
+                             minf = numeric_limits<double>::quiet_NaN();
+                         }
+                         else
+                         {
+                             resultCode = optim.last_optimize_result();
+                             minf = optim.last_optimum_value();
+                         }
+                     }
+
+                     double solveTime = SolveTelemetry::secondsSince(solveStart);
+                     double sceneTime = frameTelemetry[i].sceneTime;
+
+                     frameTelemetry[i] = objective.getTelemetry();
+                     frameTelemetry[i].frame = frameStart + i;
+                     frameTelemetry[i].sceneTime = sceneTime;
+                     frameTelemetry[i].solveTime = solveTime;
+                     frameTelemetry[i].resultCode = resultCode;
+                     frameTelemetry[i].finalObjective = minf;
+
+                     frameSolutions[i] = x;
+                 }
+             });
+
+    int numFailures = 0;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        numFailures += frameFailures[i];
+    }
+
+    return numFailures;
+}
+
+void FrameRangeSolver::configureObjective(const FusedSolveSettings &settings,
+                                          const ObjectSDF &objectSDF,
+                                          FrameObjective &objective)
+{
+    objective.setCoefficients(
+        settings.contactDistanceCoefficient, settings.contactNormalCoefficient,
+        settings.markerCoefficient, settings.contactCoefficient,
+        settings.intersectionCoefficient, settings.priorCoefficient);
+
+    objective.setObjectSDF(objectSDF.isEmpty() ? nullptr : &objectSDF);
+
+    if (settings.tableEnabled)
+    {
+        objective.setTable(settings.tableInverse, settings.tableHalfDims);
+    }
+    else
+    {
+        objective.setTable(nullptr, nullptr);
+    }
+}
+
+// Constant velocity prediction from the last two solved frames, clamped to the
+// joint limits
+void FrameRangeSolver::extrapolateDofs(const vector<double> &lastDofs,
+                                       const vector<double> &secondLastDofs,
+                                       const vector<double> &lowerLimits,
+                                       const vector<double> &upperLimits,
+                                       vector<double> &x)
+{
+    int numDofs = x.size();
+
+    for (int i = 0; i < numDofs; i++)
+    {
+        double predicted = 2.0 * lastDofs[i] - secondLastDofs[i];
+
+        x[i] = min(max(predicted, lowerLimits[i]), upperLimits[i]);
+    }
+}
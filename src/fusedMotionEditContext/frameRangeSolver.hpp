@@ -0,0 +1,72 @@
+#ifndef FRAMERANGESOLVER_H
+#define FRAMERANGESOLVER_H
+
+#include "frameObjective.hpp"
+#include "levenbergMarquardt.hpp"
+#include "taskPool.hpp"
+
+#include <nlopt.hpp>
+
+// Coefficients and solver options of a fused solve
+struct FusedSolveSettings
+{
+    FusedSolveSettings();
+
+    double contactDistanceCoefficient;
+    double contactNormalCoefficient;
+    double markerCoefficient;
+    double contactCoefficient;
+    double intersectionCoefficient;
+    double priorCoefficient;
+
+    int numIterations;
+    bool leastSquares;      // Levenberg-Marquardt instead of MMA
+    int warmStartChunkSize; // Contiguous frames chained per thread
+    bool temporalWarmStart; // Constant velocity initial guess
+
+    bool tableEnabled;
+    double tableInverse[MATRIX_SIZE]; // Column vector layout, as BoxSDF
+    double tableHalfDims[3];
+};
+
+// Not a Maya context - solves the frames of a range independently on worker
+// threads, each starting from the previous frame of its chunk. Shared by the
+// plugin's parallel bulk solve and fused_solve, so both give the same keys.
+class FrameRangeSolver
+{
+public:
+    FrameRangeSolver(const HandKinematics &kinematics,
+                     const HandSkinning &skinning, const ObjectSDF &objectSDF);
+    virtual ~FrameRangeSolver();
+
+    void setDofLimits(const vector<double> &lowerLimits,
+                      const vector<double> &upperLimits);
+    void setSettings(const FusedSolveSettings &settings);
+
+    int solve(int numThreads, int frameStart,
+              const vector<FrameCorrespondences> &frameCorrespondences,
+              const vector<vector<double>> &frameDofs,
+              vector<vector<double>> &frameSolutions,
+              vector<FrameTelemetry> &frameTelemetry,
+              vector<int> &frameIterations) const;
+
+    static void configureObjective(const FusedSolveSettings &settings,
+                                   const ObjectSDF &objectSDF,
+                                   FrameObjective &objective);
+    static void extrapolateDofs(const vector<double> &lastDofs,
+                                const vector<double> &secondLastDofs,
+                                const vector<double> &lowerLimits,
+                                const vector<double> &upperLimits,
+                                vector<double> &x);
+
+private:
+    const HandKinematics &m_kinematics;
+    const HandSkinning &m_skinning;
+    const ObjectSDF &m_object_sdf;
+
+    FusedSolveSettings m_settings;
+    vector<double> m_dof_lower_limits; // Unlimited dofs are +-HUGE_VAL
+    vector<double> m_dof_upper_limits;
+};
+
+#endif // FRAMERANGESOLVER_H
@@ -0,0 +1,166 @@
+#include "frameSolutionMatrix.hpp"
+
+FrameSolutionMatrix::FrameSolutionMatrix()
+    : m_frame_start(0), m_frame_end(-1), m_num_dofs(0)
+{
+}
+
+FrameSolutionMatrix::~FrameSolutionMatrix() {}
+
+// Full pass over the range. Clears any pending edits.
+void FrameSolutionMatrix::computeAccelerationErrors()
+{
+    for (int frame = m_frame_start; frame <= m_frame_end; frame++)
+    {
+        computeFrameErrors(frame);
+    }
+
+    for (int frame : m_dirty_frames)
+    {
+        m_dirty[frame - m_frame_start + 1] = 0;
+    }
+
+    m_dirty_frames.clear();
+}
+
+bool FrameSolutionMatrix::containsFrame(int frame) const
+{
+    return frame >= m_frame_start - 1 && frame <= m_frame_end + 1;
+}
+
+// Returns the frame's dofs for writing, or null outside the padded range
+double *FrameSolutionMatrix::editFrame(int frame)
+{
+    if (!containsFrame(frame))
+    {
+        return nullptr;
+    }
+
+    int row = frame - m_frame_start + 1;
+
+    if (!m_dirty[row])
+    {
+        m_dirty[row] = 1;
+        m_dirty_frames.push_back(frame);
+    }
+
+    return &m_solutions[m_num_dofs * row];
+}
+
+// Branch free count first, since most frames have no violations
+int FrameSolutionMatrix::findViolations(int frame, double epsilon,
+                                        vector<int> &violationIndices) const
+{
+    violationIndices.clear();
+
+    const double *errors = getAccelerationErrors(frame);
+
+    int numViolations = 0;
+
+    for (int i = 0; i < m_num_dofs; i++)
+    {
+        numViolations += errors[i] > epsilon;
+    }
+
+    if (numViolations == 0)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < m_num_dofs; i++)
+    {
+        if (errors[i] > epsilon)
+        {
+            violationIndices.push_back(i);
+        }
+    }
+
+    return numViolations;
+}
+
+const double *FrameSolutionMatrix::getAccelerationErrors(int frame) const
+{
+    return &m_errors[m_num_dofs * (frame - m_frame_start)];
+}
+
+int FrameSolutionMatrix::getFrameEnd() const { return m_frame_end; }
+
+int FrameSolutionMatrix::getFrameStart() const { return m_frame_start; }
+
+int FrameSolutionMatrix::getNumDofs() const { return m_num_dofs; }
+
+bool FrameSolutionMatrix::isEmpty() const
+{
+    return m_frame_end < m_frame_start;
+}
+
+void FrameSolutionMatrix::reset(int frameStart, int frameEnd, int numDofs)
+{
+    m_frame_start = frameStart;
+    m_frame_end = max(frameEnd, frameStart - 1);
+    m_num_dofs = numDofs;
+
+    int numFrames = m_frame_end - m_frame_start + 1;
+
+    m_solutions.assign((numFrames + 2) * m_num_dofs, 0.0);
+    m_errors.assign(numFrames * m_num_dofs, 0.0);
+    m_dof_scales.assign(m_num_dofs, 1.0);
+
+    m_dirty_frames.clear();
+    m_dirty.assign(numFrames + 2, 0);
+}
+
+void FrameSolutionMatrix::setDofScales(const vector<double> &scales)
+{
+    m_dof_scales = scales;
+}
+
+// Recomputes the accelerations of edited frames and their neighbours, and
+// returns those frames in increasing order
+void FrameSolutionMatrix::updateAccelerationErrors(vector<int> &updatedFrames)
+{
+    updatedFrames.clear();
+
+    for (int frame : m_dirty_frames)
+    {
+        m_dirty[frame - m_frame_start + 1] = 0;
+
+        for (int center = frame - 1; center <= frame + 1; center++)
+        {
+            if (center >= m_frame_start && center <= m_frame_end)
+            {
+                updatedFrames.push_back(center);
+            }
+        }
+    }
+
+    m_dirty_frames.clear();
+
+    sort(updatedFrames.begin(), updatedFrames.end());
+    updatedFrames.erase(unique(updatedFrames.begin(), updatedFrames.end()),
+                        updatedFrames.end());
+
+    for (int frame : updatedFrames)
+    {
+        computeFrameErrors(frame);
+    }
+}
+
+// Magnitude of the change in velocity across the frame, in scaled units
+void FrameSolutionMatrix::computeFrameErrors(int frame)
+{
+    int row = frame - m_frame_start + 1;
+
+    const double *previous = &m_solutions[m_num_dofs * (row - 1)];
+    const double *current = &m_solutions[m_num_dofs * row];
+    const double *next = &m_solutions[m_num_dofs * (row + 1)];
+    const double *scales = m_dof_scales.data();
+
+    double *errors = &m_errors[m_num_dofs * (row - 1)];
+
+    for (int i = 0; i < m_num_dofs; i++)
+    {
+        errors[i] = abs(scales[i] *
+                        ((next[i] - current[i]) - (current[i] - previous[i])));
+    }
+}
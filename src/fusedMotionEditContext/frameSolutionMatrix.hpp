@@ -0,0 +1,58 @@
+#ifndef FRAMESOLUTIONMATRIX_H
+#define FRAMESOLUTIONMATRIX_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+// Not a Maya context - dof solutions of a frame range stored as one dense
+// frames x dofs matrix, padded by a frame on either side, together with the
+// finite difference acceleration of every dof at every frame in the range.
+// Edited frames are tracked so that only the accelerations they touch are
+// recomputed.
+class FrameSolutionMatrix
+{
+public:
+    FrameSolutionMatrix();
+    virtual ~FrameSolutionMatrix();
+
+    void computeAccelerationErrors();
+
+    bool containsFrame(int frame) const;
+
+    double *editFrame(int frame);
+
+    int findViolations(int frame, double epsilon,
+                       vector<int> &violationIndices) const;
+
+    const double *getAccelerationErrors(int frame) const;
+    int getFrameEnd() const;
+    int getFrameStart() const;
+    int getNumDofs() const;
+
+    bool isEmpty() const;
+
+    void reset(int frameStart, int frameEnd, int numDofs);
+
+    void setDofScales(const vector<double> &scales);
+
+    void updateAccelerationErrors(vector<int> &updatedFrames);
+
+private:
+    void computeFrameErrors(int frame);
+
+    int m_frame_start;
+    int m_frame_end;
+    int m_num_dofs;
+
+    vector<double> m_solutions; // Row per frame, from m_frame_start - 1
+    vector<double> m_errors;    // Row per frame, from m_frame_start
+    vector<double> m_dof_scales; // Units per second, applied before abs
+
+    vector<int> m_dirty_frames;
+    vector<char> m_dirty; // Per padded row
+};
+
+#endif // FRAMESOLUTIONMATRIX_H
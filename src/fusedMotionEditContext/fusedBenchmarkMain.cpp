@@ -0,0 +1,644 @@
+#include "frameRangeSolver.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+
+#define BENCHMARK_NUM_FINGERS 5
+#define BENCHMARK_NUM_SEGMENTS 3     // Joints per finger, as MANO
+#define BENCHMARK_SEGMENT_RINGS 6    // Vertex rings along each finger bone
+#define BENCHMARK_RING_VERTICES 8    // Vertices around each ring
+#define BENCHMARK_NUM_VERTICES 778   // As MANO, the rest go on the palm
+#define BENCHMARK_SPHERE_RINGS 16    // Object mesh latitude bands
+#define BENCHMARK_SPHERE_SEGMENTS 24 // Object mesh longitude bands
+
+#define BENCHMARK_OBJECTIVE_REPETITIONS 1000
+#define BENCHMARK_FRAME_REPETITIONS 50
+#define BENCHMARK_BULK_REPETITIONS 3
+
+// Synthetic stand-in for a captured sequence - a MANO-sized rig (16 joints,
+// 51 dofs, 778 vertices), a sphere object on a table and, per frame, the
+// correspondences of a known pose with the noisy pose as the prior
+struct BenchmarkScene
+{
+    HandKinematics kinematics;
+    HandSkinning skinning;
+    ObjectSDF objectSDF;
+    FusedSolveSettings settings;
+
+    vector<int> contactFaces; // 3 hand vertices per contact
+    vector<double> contactCoords;
+    vector<int> markerVertices;
+
+    vector<FrameCorrespondences> frameCorrespondences;
+    vector<vector<double>> frameDofs;
+};
+
+// Timings of one benchmark, in seconds per repetition
+struct BenchmarkResult
+{
+    string name;
+    int numThreads;
+    int numFrames;
+    int repetitions;
+    double meanTime;
+    double minTime;
+    double maxTime;
+    double meanIterations; // Per frame, 1 for single evaluations
+};
+
+// Cylinders of vertex rings along every finger bone, blended into the parent
+// joint near the knuckle, and an ellipsoid of vertices on the palm
+static void buildHand(BenchmarkScene &scene)
+{
+    HandKinematics &kinematics = scene.kinematics;
+    HandSkinning &skinning = scene.skinning;
+
+    double identity[MATRIX_SIZE] = {1, 0, 0, 0, 0, 1, 0, 0,
+                                     0, 0, 1, 0, 0, 0, 0, 1};
+    int rotationSequence[3] = {0, 1, 2};
+    double zero[3] = {0.0, 0.0, 0.0};
+
+    // Centimetres, wrist at the origin with the fingers along +x and the palm
+    // facing -y
+    double fingerBases[BENCHMARK_NUM_FINGERS][3] = {
+        {2.5, -0.5, 3.0}, {9.0, 0.0, 3.0}, {9.5, 0.0, 1.0},
+        {9.0, 0.0, -1.0}, {8.0, 0.0, -3.0}};
+    double fingerDirections[BENCHMARK_NUM_FINGERS][3] = {
+        {0.6, 0.0, 0.8}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0}};
+    double segmentLengths[BENCHMARK_NUM_FINGERS][BENCHMARK_NUM_SEGMENTS] = {
+        {3.5, 3.0, 2.5}, {4.0, 2.5, 2.0}, {4.5, 3.0, 2.0},
+        {4.0, 2.8, 2.0}, {3.2, 2.2, 1.8}};
+    double segmentRadii[BENCHMARK_NUM_SEGMENTS] = {1.0, 0.9, 0.8};
+
+    // Step 1: Joints. Rotations are zero at bind, so every post matrix is a
+    // plain offset from the parent.
+
+    kinematics.addJoint(-1, identity, identity, rotationSequence, zero, zero,
+                        true);
+
+    for (int f = 0; f < BENCHMARK_NUM_FINGERS; f++)
+    {
+        int parent = 0;
+
+        for (int s = 0; s < BENCHMARK_NUM_SEGMENTS; s++)
+        {
+            double post[MATRIX_SIZE];
+            copy(identity, identity + MATRIX_SIZE, post);
+
+            for (int a = 0; a < 3; a++)
+            {
+                post[12 + a] = (s == 0) ? fingerBases[f][a]
+                                        : fingerDirections[f][a] *
+                                              segmentLengths[f][s - 1];
+            }
+
+            parent = kinematics.addJoint(parent, identity, post,
+                                         rotationSequence, zero, zero, false);
+        }
+    }
+
+    // Root rotation and translation first, then 3 rotations per finger joint
+    for (int j = 0; j < kinematics.getNumJoints(); j++)
+    {
+        int numJointDofs = (j == 0) ? 6 : 3;
+
+        for (int d = 0; d < numJointDofs; d++)
+        {
+            kinematics.addDof(j, d);
+        }
+    }
+
+    HandPose bindPose;
+    kinematics.computePose(vector<double>(kinematics.getNumDofs(), 0.0),
+                           bindPose);
+
+    // Step 2: Finger skin
+
+    for (int f = 0; f < BENCHMARK_NUM_FINGERS; f++)
+    {
+        const double *direction = fingerDirections[f];
+
+        // Ring basis, perpendicular to the bone
+        double u[3] = {-direction[2], 0.0, direction[0]};
+        double v[3] = {u[1] * direction[2] - u[2] * direction[1],
+                       u[2] * direction[0] - u[0] * direction[2],
+                       u[0] * direction[1] - u[1] * direction[0]};
+
+        for (int s = 0; s < BENCHMARK_NUM_SEGMENTS; s++)
+        {
+            int joint = 1 + BENCHMARK_NUM_SEGMENTS * f + s;
+            int parent = kinematics.getJointParent(joint);
+
+            const double *jointWorld =
+                &bindPose.m_world_matrices[MATRIX_SIZE * joint + 12];
+            const double *parentWorld =
+                &bindPose.m_world_matrices[MATRIX_SIZE * parent + 12];
+
+            for (int r = 0; r < BENCHMARK_SEGMENT_RINGS; r++)
+            {
+                double t = (r + 0.5) / BENCHMARK_SEGMENT_RINGS;
+                double blend = max(0.3 - t, 0.0) / 0.3 * 0.5;
+
+                for (int k = 0; k < BENCHMARK_RING_VERTICES; k++)
+                {
+                    double angle = 2.0 * M_PI * k / BENCHMARK_RING_VERTICES;
+                    double normal[3];
+                    double position[3];
+
+                    for (int a = 0; a < 3; a++)
+                    {
+                        normal[a] = cos(angle) * u[a] + sin(angle) * v[a];
+                        position[a] = jointWorld[a] +
+                                      direction[a] * t *
+                                          segmentLengths[f][s] +
+                                      segmentRadii[s] * normal[a];
+                    }
+
+                    double local[3];
+                    double parentLocal[3];
+
+                    for (int a = 0; a < 3; a++)
+                    {
+                        local[a] = position[a] - jointWorld[a];
+                        parentLocal[a] = position[a] - parentWorld[a];
+                    }
+
+                    skinning.addInfluence(joint, 1.0 - blend, local, normal);
+
+                    if (blend > 0.0)
+                    {
+                        skinning.addInfluence(parent, blend, parentLocal,
+                                              normal);
+                    }
+
+                    skinning.addVertex();
+                }
+
+                // Two triangles per quad towards the next ring
+                if (r == BENCHMARK_SEGMENT_RINGS - 1)
+                {
+                    continue;
+                }
+
+                int ringStart = skinning.getNumVertices() -
+                                BENCHMARK_RING_VERTICES;
+
+                for (int k = 0; k < BENCHMARK_RING_VERTICES; k++)
+                {
+                    int next = (k + 1) % BENCHMARK_RING_VERTICES;
+
+                    int face[3] = {ringStart + k, ringStart + next,
+                                   ringStart + BENCHMARK_RING_VERTICES + k};
+
+                    if (s == BENCHMARK_NUM_SEGMENTS - 1)
+                    {
+                        scene.contactFaces.insert(scene.contactFaces.end(),
+                                                  face, face + 3);
+                    }
+                }
+            }
+        }
+    }
+
+    // Step 3: Palm skin, Fibonacci points on an ellipsoid
+
+    int numPalmVertices = BENCHMARK_NUM_VERTICES - skinning.getNumVertices();
+    double palmCentre[3] = {4.5, 0.0, 0.0};
+    double palmRadii[3] = {5.0, 1.5, 4.5};
+
+    for (int i = 0; i < numPalmVertices; i++)
+    {
+        double y = 1.0 - 2.0 * (i + 0.5) / numPalmVertices;
+        double ring = sqrt(1.0 - y * y);
+        double angle = M_PI * (3.0 - sqrt(5.0)) * i;
+
+        double sphere[3] = {ring * cos(angle), y, ring * sin(angle)};
+        double position[3];
+        double normal[3];
+        double length = 0.0;
+
+        for (int a = 0; a < 3; a++)
+        {
+            position[a] = palmCentre[a] + palmRadii[a] * sphere[a];
+            normal[a] = sphere[a] / palmRadii[a];
+            length += normal[a] * normal[a];
+        }
+
+        for (int a = 0; a < 3; a++)
+        {
+            normal[a] /= sqrt(length);
+        }
+
+        skinning.addInfluence(0, 1.0, position, normal);
+        skinning.addVertex();
+    }
+
+    skinning.setSkinMatrix(identity);
+    skinning.buildBoneBounds(kinematics);
+}
+
+// UV sphere in object space, posed by the correspondences
+static void buildObject(double radius, BenchmarkScene &scene)
+{
+    vector<double> vertices = {0.0, radius, 0.0};
+    vector<int> triangles;
+
+    for (int r = 1; r < BENCHMARK_SPHERE_RINGS; r++)
+    {
+        double polar = M_PI * r / BENCHMARK_SPHERE_RINGS;
+
+        for (int s = 0; s < BENCHMARK_SPHERE_SEGMENTS; s++)
+        {
+            double azimuth = 2.0 * M_PI * s / BENCHMARK_SPHERE_SEGMENTS;
+
+            vertices.push_back(radius * sin(polar) * cos(azimuth));
+            vertices.push_back(radius * cos(polar));
+            vertices.push_back(radius * sin(polar) * sin(azimuth));
+        }
+    }
+
+    vertices.insert(vertices.end(), {0.0, -radius, 0.0});
+
+    int bottom = vertices.size() / 3 - 1;
+    int lastRing = 1 + (BENCHMARK_SPHERE_RINGS - 2) * BENCHMARK_SPHERE_SEGMENTS;
+
+    for (int s = 0; s < BENCHMARK_SPHERE_SEGMENTS; s++)
+    {
+        int next = (s + 1) % BENCHMARK_SPHERE_SEGMENTS;
+
+        triangles.insert(triangles.end(), {0, 1 + next, 1 + s});
+        triangles.insert(triangles.end(),
+                         {bottom, lastRing + s, lastRing + next});
+
+        for (int r = 0; r < BENCHMARK_SPHERE_RINGS - 2; r++)
+        {
+            int a = 1 + r * BENCHMARK_SPHERE_SEGMENTS;
+            int b = a + BENCHMARK_SPHERE_SEGMENTS;
+
+            triangles.insert(triangles.end(), {a + s, a + next, b + s});
+            triangles.insert(triangles.end(), {a + next, b + next, b + s});
+        }
+    }
+
+    scene.objectSDF.build(vertices, triangles);
+}
+
+// Smooth random motion around a relaxed grasp. Each frame pairs the skin of
+// the known pose with contacts and markers, and starts from the noisy pose.
+static void buildFrames(int numFrames, int numContacts, int numMarkers,
+                        unsigned seed, BenchmarkScene &scene)
+{
+    mt19937 generator(seed);
+    uniform_real_distribution<double> uniform(-1.0, 1.0);
+    normal_distribution<double> noise(0.0, 1.0);
+
+    int numDofs = scene.kinematics.getNumDofs();
+    int numVertices = scene.skinning.getNumVertices();
+    int numFaces = scene.contactFaces.size() / 3;
+
+    // Step 1: Fixed picks of hand points, so every frame has the same terms
+
+    scene.contactCoords.clear();
+    scene.markerVertices.clear();
+
+    vector<int> faces(numContacts);
+
+    for (int c = 0; c < numContacts; c++)
+    {
+        faces[c] = generator() % numFaces;
+
+        double a = 0.5 * (uniform(generator) + 1.0);
+        double b = 0.5 * (uniform(generator) + 1.0) * (1.0 - a);
+
+        scene.contactCoords.insert(scene.contactCoords.end(),
+                                   {a, b, 1.0 - a - b});
+    }
+
+    for (int m = 0; m < numMarkers; m++)
+    {
+        scene.markerVertices.push_back(generator() % numVertices);
+    }
+
+    // Step 2: Trajectory per dof - root rotations, root translations, then
+    // finger flexion, abduction and twist
+
+    vector<double> bases(numDofs);
+    vector<double> amplitudes(numDofs);
+    vector<double> phases(numDofs);
+
+    for (int i = 0; i < numDofs; i++)
+    {
+        int dofIndex = scene.kinematics.getDofIndex(i);
+        bool root = scene.kinematics.getDofJoint(i) == 0;
+
+        double amplitude = root ? (dofIndex > 2 ? 1.0 : 0.1)
+                                : (dofIndex == 2 ? 0.4 : 0.1);
+
+        bases[i] = (!root && dofIndex == 2) ? 0.5 : 0.0;
+        amplitudes[i] = amplitude * (0.5 + 0.5 * uniform(generator));
+        phases[i] = M_PI * uniform(generator);
+    }
+
+    // Object in front of the palm, table below it. Both inverses use the
+    // column vector layout.
+    double objectInverse[MATRIX_SIZE] = {1, 0, 0, -6.0, 0, 1, 0, 4.5,
+                                         0, 0, 1, 0.0,  0, 0, 0, 1};
+
+    FusedSolveSettings &settings = scene.settings;
+    double tableInverse[MATRIX_SIZE] = {1, 0, 0, -6.0, 0, 1, 0, 12.0,
+                                        0, 0, 1, 0.0,  0, 0, 0, 1};
+
+    settings.tableEnabled = true;
+    copy(tableInverse, tableInverse + MATRIX_SIZE, settings.tableInverse);
+    settings.tableHalfDims[0] = settings.tableHalfDims[2] = 30.0;
+    settings.tableHalfDims[1] = 2.0;
+
+    // Step 3: Frames
+
+    scene.frameCorrespondences.assign(numFrames, FrameCorrespondences());
+    scene.frameDofs.assign(numFrames, vector<double>(numDofs));
+
+    vector<double> dofs(numDofs);
+    HandPose pose;
+
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        double time = 2.0 * M_PI * frame / 120.0;
+
+        for (int i = 0; i < numDofs; i++)
+        {
+            dofs[i] = bases[i] + amplitudes[i] * sin(time + phases[i]);
+
+            bool translation = scene.kinematics.getDofIndex(i) > 2;
+            double sigma = translation ? 0.5 : 0.05;
+
+            scene.frameDofs[frame][i] = dofs[i] + sigma * noise(generator);
+        }
+
+        scene.kinematics.computePose(dofs, pose);
+
+        FrameCorrespondences &correspondences =
+            scene.frameCorrespondences[frame];
+
+        for (int c = 0; c < numContacts; c++)
+        {
+            const int *face = &scene.contactFaces[3 * faces[c]];
+            const double *coords = &scene.contactCoords[3 * c];
+
+            double position[3];
+            double normal[3];
+
+            scene.skinning.computePoint(pose, face, coords, 3, position,
+                                        normal);
+
+            for (int a = 0; a < 3; a++)
+            {
+                normal[a] = -normal[a];
+            }
+
+            correspondences.addContact(vector<int>(face, face + 3),
+                                       vector<double>(coords, coords + 3),
+                                       position, normal);
+        }
+
+        for (int m = 0; m < numMarkers; m++)
+        {
+            double position[3];
+            double normal[3];
+
+            scene.skinning.computeVertex(pose, scene.markerVertices[m],
+                                         position, normal);
+
+            for (int a = 0; a < 3; a++)
+            {
+                position[a] += 0.1 * noise(generator);
+            }
+
+            correspondences.addMarker(vector<int>(1, scene.markerVertices[m]),
+                                      vector<double>(), position);
+        }
+
+        correspondences.setObjectInverse(objectInverse);
+    }
+}
+
+// Runs the benchmark once to warm caches, then times every repetition. The
+// run returns its mean iterations per frame.
+static BenchmarkResult timeBenchmark(const string &name, int numThreads,
+                                     int numFrames, int repetitions,
+                                     const function<double()> &run)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.numThreads = numThreads;
+    result.numFrames = numFrames;
+    result.repetitions = repetitions;
+    result.meanTime = 0.0;
+    result.minTime = HUGE_VAL;
+    result.maxTime = 0.0;
+    result.meanIterations = 0.0;
+
+    run();
+
+    for (int i = 0; i < repetitions; i++)
+    {
+        TelemetryClock start = SolveTelemetry::now();
+
+        result.meanIterations += run();
+
+        double time = SolveTelemetry::secondsSince(start);
+
+        result.meanTime += time;
+        result.minTime = min(result.minTime, time);
+        result.maxTime = max(result.maxTime, time);
+    }
+
+    result.meanTime /= repetitions;
+    result.meanIterations /= repetitions;
+
+    return result;
+}
+
+static void writeResults(const vector<BenchmarkResult> &results,
+                         int numContacts, int numMarkers, unsigned seed,
+                         ostream &out)
+{
+    out << "benchmark,threads,frames,contacts,markers,seed,repetitions,"
+           "mean_time,min_time,max_time,mean_iterations"
+        << endl;
+
+    for (const BenchmarkResult &result : results)
+    {
+        out << result.name << "," << result.numThreads << ","
+            << result.numFrames << "," << numContacts << "," << numMarkers
+            << "," << seed << "," << result.repetitions << ","
+            << result.meanTime << "," << result.minTime << ","
+            << result.maxTime << "," << result.meanIterations << endl;
+    }
+}
+
+// Times the fused objective and solvers on a synthetic scene, for tracking
+// regressions in the hot path. Seeded, so runs with the same options solve
+// the same frames. Writes CSV to stdout, or to the output file.
+int main(int argc, char **argv)
+{
+    int numContacts = 10;
+    int numMarkers = 20;
+    int numFrames = 1000;
+    unsigned seed = 1;
+    bool leastSquares = false;
+    string outputFilename;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(argv[i], "-contacts") == 0 && hasValue)
+        {
+            numContacts = max(atoi(argv[++i]), 0);
+        }
+        else if (strcmp(argv[i], "-markers") == 0 && hasValue)
+        {
+            numMarkers = max(atoi(argv[++i]), 0);
+        }
+        else if (strcmp(argv[i], "-frames") == 0 && hasValue)
+        {
+            numFrames = max(atoi(argv[++i]), 1);
+        }
+        else if (strcmp(argv[i], "-seed") == 0 && hasValue)
+        {
+            seed = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "-output") == 0 && hasValue)
+        {
+            outputFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "-leastsquares") == 0)
+        {
+            leastSquares = true;
+        }
+        else
+        {
+            cerr << "Usage: fused_benchmark [-contacts n] [-markers n] "
+                    "[-frames n] [-seed n] [-leastsquares] [-output file]"
+                 << endl;
+            return 1;
+        }
+    }
+
+    BenchmarkScene scene;
+
+    buildHand(scene);
+    buildObject(3.5, scene);
+    buildFrames(numFrames, numContacts, numMarkers, seed, scene);
+
+    scene.settings.leastSquares = leastSquares;
+
+    int numDofs = scene.kinematics.getNumDofs();
+
+    cerr << "Rig: " << scene.kinematics.getNumJoints() << " joints, "
+         << numDofs << " dofs, " << scene.skinning.getNumVertices()
+         << " vertices" << endl;
+
+    vector<BenchmarkResult> results;
+
+    // Step 1: Single evaluations and solves of the first frame
+
+    FrameObjective objective(scene.kinematics, scene.skinning);
+    FrameRangeSolver::configureObjective(scene.settings, scene.objectSDF,
+                                         objective);
+    objective.setCorrespondences(&scene.frameCorrespondences[0]);
+    objective.setPriorDofs(scene.frameDofs[0]);
+
+    const vector<double> &prior = scene.frameDofs[0];
+    vector<double> noGradient;
+    vector<double> gradient(numDofs);
+
+    results.push_back(timeBenchmark(
+        "objective", 1, 1, BENCHMARK_OBJECTIVE_REPETITIONS,
+        [&]()
+        {
+            objective.computeObjective(prior, noGradient);
+            return 1.0;
+        }));
+
+    results.push_back(timeBenchmark(
+        "gradient", 1, 1, BENCHMARK_OBJECTIVE_REPETITIONS,
+        [&]()
+        {
+            objective.computeObjective(prior, gradient);
+            return 1.0;
+        }));
+
+    FrameRangeSolver solver(scene.kinematics, scene.skinning, scene.objectSDF);
+    solver.setSettings(scene.settings);
+
+    vector<FrameCorrespondences> firstCorrespondences(
+        1, scene.frameCorrespondences[0]);
+    vector<vector<double>> firstDofs(1, prior);
+
+    vector<vector<double>> frameSolutions;
+    vector<FrameTelemetry> frameTelemetry;
+    vector<int> frameIterations;
+
+    results.push_back(timeBenchmark(
+        "frame_solve", 1, 1, BENCHMARK_FRAME_REPETITIONS,
+        [&]()
+        {
+            solver.solve(1, 0, firstCorrespondences, firstDofs,
+                         frameSolutions, frameTelemetry, frameIterations);
+            return (double)frameIterations[0];
+        }));
+
+    // Step 2: Bulk solves of every frame
+
+    int threadCounts[] = {1, 2, 4, 8, 16};
+
+    for (int numThreads : threadCounts)
+    {
+        results.push_back(timeBenchmark(
+            "bulk_solve", numThreads, numFrames, BENCHMARK_BULK_REPETITIONS,
+            [&]()
+            {
+                solver.solve(numThreads, 0, scene.frameCorrespondences,
+                             scene.frameDofs, frameSolutions, frameTelemetry,
+                             frameIterations);
+
+                double totalIterations = 0.0;
+
+                for (int iterations : frameIterations)
+                {
+                    totalIterations += iterations;
+                }
+
+                return totalIterations / numFrames;
+            }));
+
+        cerr << "Solved " << numFrames << " frames on " << numThreads
+             << " threads" << endl;
+    }
+
+    if (outputFilename.empty())
+    {
+        writeResults(results, numContacts, numMarkers, seed, cout);
+
+        return 0;
+    }
+
+    ofstream file(outputFilename);
+
+    writeResults(results, numContacts, numMarkers, seed, file);
+
+    if (!file.good())
+    {
+        cerr << "Could not write results to " << outputFilename << endl;
+        return 1;
+    }
+
+    return 0;
+}
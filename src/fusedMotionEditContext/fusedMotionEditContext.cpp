@@ -3,12 +3,21 @@
 // Setup and Teardown
 
 FusedMotionEditContext::FusedMotionEditContext()
-    : m_num_opt_iterations(100), m_contact_distance_penalty_coefficient(1.0),
+    : m_solve_undo_sequence(-1), m_correspondence_frame(-1),
+      m_frame_objective(m_hand_kinematics, m_hand_skinning),
+      m_reference_gradient_enabled(false),
+      m_optimization_visualization_enabled(false),
+      m_optimization_progress_rate(DEFAULT_PROGRESS_RATE),
+      m_least_squares_enabled(false), m_num_opt_iterations(100),
+      m_contact_distance_penalty_coefficient(1.0),
       m_contact_normal_penalty_coefficient(1.0),
       m_marker_penalty_coefficient(1.0), m_contact_penalty_coefficient(1.0),
       m_intersection_penalty_coefficient(1.0),
-      m_prior_penalty_coefficient(50.0),
-      m_optimization_visualization_enabled(false), m_acceleration_epsilon(500.0)
+      m_prior_penalty_coefficient(50.0), m_num_solver_threads(1),
+      m_warm_start_chunk_size(1), m_temporal_warm_start_enabled(false),
+      m_num_restarts(0), m_restart_time_budget(0.0),
+      m_num_solver_iterations(0), m_acceleration_epsilon(500.0),
+      m_acceleration_penalty_coefficient(1.0), m_space_time_window_size(0)
 {
     m_rng = default_random_engine{};
 
@@ -36,7 +45,16 @@ void FusedMotionEditContext::toolOnSetup(MEvent &event)
     m_rig_joints.clear();
     m_dof_vector.clear();
     m_dof_vec_mappings.clear();
+    m_dof_lower_limits.clear();
+    m_dof_upper_limits.clear();
     m_joint_names.clear();
+    m_joint_rig_indices.clear();
+
+    m_frame_correspondences.clear();
+    m_correspondence_frame = -1;
+
+    m_recent_solutions.clear();
+    m_telemetry.clear();
 
     MAnimControl animCtrl;
     MTime time = animCtrl.currentTime();
@@ -53,12 +71,21 @@ void FusedMotionEditContext::toolOnSetup(MEvent &event)
     status = loadTable();
     CHECK_MSTATUS(status);
 
+    status = loadObjectSDF();
+    CHECK_MSTATUS(status);
+
     status = loadAllVirtualMarkers();
     CHECK_MSTATUS(status);
 
     status = parseKinematicTree();
     CHECK_MSTATUS(status);
 
+    status = buildHandKinematics();
+    CHECK_MSTATUS(status);
+
+    status = loadSkinWeights();
+    CHECK_MSTATUS(status);
+
     status = redrawContactVisualizations();
     CHECK_MSTATUS(status);
 
@@ -98,8 +125,6 @@ MStatus FusedMotionEditContext::computeAccelerationErrors(int frameStart,
 {
     MStatus status;
 
-    MSelectionList selectionList;
-
     MGlobal::displayInfo("Computing...");
 
     // Load all solutions and acceleration errors
@@ -107,135 +132,171 @@ MStatus FusedMotionEditContext::computeAccelerationErrors(int frameStart,
     status = storeExistingFrameSolutions(frameStart, frameEnd);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    vector<MPointArray> accelerationErrors;
+    m_frame_solutions.computeAccelerationErrors();
 
-    m_acceleration_violations.clear();
+    vector<int> frames;
 
-    for (int rigDofIndex = 0; rigDofIndex < m_rig_n_dofs; rigDofIndex++)
+    for (int frame = frameStart; frame <= frameEnd; frame++)
     {
-        accelerationErrors.push_back(MPointArray());
+        frames.push_back(frame);
     }
 
-    for (int frame = frameStart; frame <= frameEnd; frame++)
-    {
-        MDoubleArray currentFrameSolutions = m_existing_frame_solutions[frame];
-        MDoubleArray priorFrameSolutions =
-            m_existing_frame_solutions[frame - 1];
-        MDoubleArray nextFrameSolutions = m_existing_frame_solutions[frame + 1];
+    m_acceleration_violations.clear();
 
-        for (int rigDofIndex = 0; rigDofIndex < m_rig_n_dofs; rigDofIndex++)
-        {
-            pair<int, int> indices = m_dof_vec_mappings.at(rigDofIndex);
-            int jointDofIndex = indices.second;
+    status = updateAccelerationViolations(frames);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-            double currentDofValue = currentFrameSolutions[rigDofIndex];
-            double priorDofValue = priorFrameSolutions[rigDofIndex];
-            double nextDofValue = nextFrameSolutions[rigDofIndex];
+    status = jumpToFrame(frameStart, true);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-            // Convert rotations to degrees for better scale consistency
-            if (jointDofIndex < 3)
-            {
-                currentDofValue *= 180.0 / M_PI;
-                priorDofValue *= 180.0 / M_PI;
-                nextDofValue *= 180.0 / M_PI;
-            }
+    status = plotAccelerationErrors();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-            double incomingVelocity =
-                (currentDofValue - priorDofValue) / m_realtime_delta;
-            double outgoingVelocity =
-                (nextDofValue - currentDofValue) / m_realtime_delta;
+    MGlobal::displayInfo("Done");
 
-            // Via finite acceleration metric
-            double accelerationError = abs(outgoingVelocity - incomingVelocity);
+    return MS::kSuccess;
+}
 
-            status = accelerationErrors[rigDofIndex].append(
-                MPoint(frame, accelerationError));
-            CHECK_MSTATUS_AND_RETURN_IT(status);
+// CSV unless the file ends in .json
+MStatus FusedMotionEditContext::dumpTelemetry(MString &filename)
+{
+    string telemetryFilename = filename.asChar();
 
-            if (accelerationError > m_acceleration_epsilon)
-            {
-                if (m_acceleration_violations.contains(frame))
-                {
-                    status =
-                        m_acceleration_violations[frame].append(rigDofIndex);
-                    CHECK_MSTATUS_AND_RETURN_IT(status);
-                }
-                else
-                {
-                    m_acceleration_violations[frame] =
-                        MIntArray(1, rigDofIndex);
-                }
-            }
-        }
+    bool written = (fs::path(telemetryFilename).extension() == ".json")
+                       ? m_telemetry.writeJson(telemetryFilename)
+                       : m_telemetry.writeCsv(telemetryFilename);
+
+    if (!written)
+    {
+        MGlobal::displayError("Could not write telemetry to " + filename);
+        return MS::kFailure;
     }
 
-    status = jumpToFrame(frameStart, true);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    MGlobal::displayInfo(
+        "Wrote telemetry for " +
+        MString(to_string(m_telemetry.getNumFrames()).c_str()) +
+        " frames to " + filename);
 
-    // Plot
+    return MS::kSuccess;
+}
 
-    status = MGlobal::getSelectionListByName(ACCELERATION_ERROR_LINES_GROUP,
-                                             selectionList);
+MStatus FusedMotionEditContext::enableLeastSquaresSolver(bool enable)
+{
+    m_least_squares_enabled = enable;
 
-    if (status == MS::kSuccess)
+    if (m_least_squares_enabled)
     {
-        MObject existingSplineGroup;
-        status = selectionList.getDependNode(0, existingSplineGroup);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-
-        status = MGlobal::deleteNode(existingSplineGroup);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+        MGlobal::displayInfo("Levenberg-Marquardt solver enabled");
+    }
+    else
+    {
+        MGlobal::displayInfo("MMA solver enabled");
     }
 
-    MFnTransform fnTransform;
-    MObject splineGroup = fnTransform.create();
-
-    MFnTransform fnSplineGroupTransform(splineGroup, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    return MS::kSuccess;
+}
 
-    fnSplineGroupTransform.setName(ACCELERATION_ERROR_LINES_GROUP, false,
-                                   &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+MStatus
+FusedMotionEditContext::enableOptimizationProgressVisualization(bool enable)
+{
+    m_optimization_visualization_enabled = enable;
 
-    for (int rigDofIndex = 0; rigDofIndex < m_rig_n_dofs; rigDofIndex++)
+    if (m_optimization_visualization_enabled)
     {
-        MFnNurbsCurve fnSplineGenerator;
-
-        MPointArray controlPoints = accelerationErrors[rigDofIndex];
+        MGlobal::displayInfo("Optimization visualization progress enabled");
+    }
+    else
+    {
+        MGlobal::displayInfo("Optimization visualization progress disabled");
+    }
 
-        MObject splineDofCurve = fnSplineGenerator.createWithEditPoints(
-            controlPoints, 1, MFnNurbsCurve::kOpen, false, true, true,
-            splineGroup, &status);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    return MS::kSuccess;
+}
 
-        MString splineName = ACCELERATION_ERROR_SPLINE_DOF_PREFIX + rigDofIndex;
+MStatus FusedMotionEditContext::enableReferenceGradient(bool enable)
+{
+    m_reference_gradient_enabled = enable;
 
-        fnSplineGenerator.setName(splineName, false, &status);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (m_reference_gradient_enabled)
+    {
+        MGlobal::displayInfo("Reference gradient enabled");
+    }
+    else
+    {
+        MGlobal::displayInfo("Analytic gradient enabled");
     }
 
-    status = redrawAccelerationViolationCutoff(frameStart, frameEnd);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    return MS::kSuccess;
+}
 
-    MGlobal::displayInfo("Done");
+MStatus FusedMotionEditContext::enableTemporalWarmStart(bool enable)
+{
+    m_temporal_warm_start_enabled = enable;
+
+    if (m_temporal_warm_start_enabled)
+    {
+        MGlobal::displayInfo("Temporal warm start enabled");
+    }
+    else
+    {
+        MGlobal::displayInfo("Temporal warm start disabled");
+    }
 
     return MS::kSuccess;
 }
 
-MStatus
-FusedMotionEditContext::enableOptimizationProgressVisualization(bool enable)
+// Everything fused_solve needs to solve the range without Maya. The keyed
+// dofs of each frame are its prior.
+MStatus FusedMotionEditContext::exportProblem(int frameStart, int frameEnd,
+                                              MString &filename)
 {
-    m_optimization_visualization_enabled = enable;
+    MStatus status;
 
-    if (m_optimization_visualization_enabled)
+    MGlobal::displayInfo("Exporting problem...");
+
+    // fused_solve only has the native skinning to evaluate the hand with
+    if (m_hand_skinning.isEmpty())
     {
-        MGlobal::displayInfo("Optimization visualization progress enabled");
+        MGlobal::displayError("Exporting a problem requires a skinned hand");
+        return MS::kFailure;
     }
-    else
+
+    int initialFrame = m_frame;
+
+    FusedProblem problem;
+    problem.kinematics = m_hand_kinematics;
+    problem.skinning = m_hand_skinning;
+    problem.objectSDF = m_object_sdf;
+    problem.dofLowerLimits = m_dof_lower_limits;
+    problem.dofUpperLimits = m_dof_upper_limits;
+    problem.frameStart = frameStart;
+
+    status = getSolveSettings(problem.settings);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    vector<FrameTelemetry> frameTelemetry;
+
+    status = snapshotFrameRange(frameStart, frameEnd,
+                                problem.frameCorrespondences,
+                                problem.frameDofs, frameTelemetry);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = jumpToFrame(initialFrame);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = initializeDofSolution();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (!problem.write(filename.asChar()))
     {
-        MGlobal::displayInfo("Optimization visualization progress disabled");
+        MGlobal::displayError("Could not write problem to " + filename);
+        return MS::kFailure;
     }
 
+    MGlobal::displayInfo(
+        "Wrote " + MString(to_string(problem.frameDofs.size()).c_str()) +
+        " frames to " + filename);
+
     return MS::kSuccess;
 }
 
@@ -388,12 +449,77 @@ MStatus FusedMotionEditContext::finalizeOmissionIndices(int frameStart,
     return MS::kSuccess;
 }
 
+// Keys a dof matrix written by fused_solve. The keys it replaces are kept as
+// the undo state.
+MStatus FusedMotionEditContext::importDofMatrix(MString &filename)
+{
+    MStatus status;
+
+    MGlobal::displayInfo("Importing dof matrix...");
+
+    int frameStart;
+    vector<vector<double>> frameSolutions;
+
+    if (!FusedProblem::readDofMatrix(filename.asChar(), frameStart,
+                                     frameSolutions))
+    {
+        MGlobal::displayError("Could not read dof matrix from " + filename);
+        return MS::kFailure;
+    }
+
+    int numFrames = frameSolutions.size();
+
+    if (numFrames > 0 && (int)frameSolutions[0].size() != m_rig_n_dofs)
+    {
+        MGlobal::displayError("Dof matrix does not match the rig dofs");
+        return MS::kFailure;
+    }
+
+    int initialFrame = m_frame;
+
+    vector<vector<double>> frameDofs(numFrames,
+                                     vector<double>(m_rig_n_dofs, 0.0));
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        status = jumpToFrame(frameStart + i, true);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = initializeDofSolution();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        for (int j = 0; j < m_rig_n_dofs; j++)
+        {
+            frameDofs[i][j] = m_dof_vector[j];
+        }
+    }
+
+    // Solutions from an earlier pass may no longer match the scene
+    m_recent_solutions.clear();
+
+    status = keyframeSolutions(frameStart, frameDofs, frameSolutions);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = jumpToFrame(initialFrame);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = initializeDofSolution();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MGlobal::displayInfo("Keyed " + MString(to_string(numFrames).c_str()) +
+                         " frames from " + filename);
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::jumpToFrame(int frame,
                                             bool suppressVisualization)
 {
     MStatus status;
 
     m_frame = frame;
+    m_correspondence_frame = -1;
+    m_solve_undo_sequence = -1;
 
     MAnimControl animCtrl;
     MTime newFrame((double)m_frame, m_framerate);
@@ -424,13 +550,24 @@ MStatus FusedMotionEditContext::keyframeRig()
 
     MGlobal::displayInfo("Keyframing rig...");
 
-    for (int i = 0; i < m_joint_names.length(); i++)
-    {
-        MString jointName = m_joint_names[i];
+    // Like setKeyframe, keys the pose at the current time, which the user
+    // may have scrubbed to since the last solve. Only rig dof channels are
+    // keyed.
+    MAnimControl animCtrl;
+    int frame = (int)animCtrl.currentTime().as(m_framerate);
 
-        MString saveCommand = "setKeyframe { \"" + jointName + "\" }";
-        status = MGlobal::executeCommand(saveCommand);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    m_keyframe_sink.clear();
+
+    status = m_keyframe_sink.addFrame(frame, m_framerate);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = m_keyframe_sink.commit();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Undoing the solve now has to remove the key as well
+    if (frame == m_frame)
+    {
+        m_undo_history.markKeyed(m_solve_undo_sequence);
     }
 
     MGlobal::displayInfo("Done");
@@ -458,39 +595,78 @@ MStatus FusedMotionEditContext::keyframeRigBulk(int frameStart, int frameEnd,
     status = clearVisualizations();
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-#ifdef RUN_OPTIMIZATION_TIMER
-    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
-#endif
+    TelemetryClock bulkStart = SolveTelemetry::now();
 
-    nlopt::opt opt = initializeOptimization();
+    // Solutions from an earlier pass may no longer match the scene
+    m_recent_solutions.clear();
 
-    for (int frame = frameStart; frame <= frameEnd; frame++)
+    if (!saveKeysOnly)
     {
-        status = jumpToFrame(frame, true);
+        m_telemetry.clear();
+    }
+
+    // Threads need the native objective and gradient
+    bool parallelSolve = !saveKeysOnly && m_num_solver_threads > 1 &&
+                         !m_hand_skinning.isEmpty() &&
+                         !m_reference_gradient_enabled;
+
+    if (parallelSolve)
+    {
+        status = solveFramesParallel(frameStart, frameEnd);
         CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+    else
+    {
+        nlopt::opt opt = initializeOptimization();
 
-        MGlobal::displayInfo(to_string(m_frame).c_str());
+        m_keyframe_sink.clear();
 
-        if (!saveKeysOnly)
+        int totalIterations = 0;
+
+        for (int frame = frameStart; frame <= frameEnd; frame++)
         {
-            status = initializeDofSolution();
+            status = jumpToFrame(frame, true);
             CHECK_MSTATUS_AND_RETURN_IT(status);
 
-            status = runOptimization(opt);
+            MGlobal::displayInfo(to_string(m_frame).c_str());
+
+            if (!saveKeysOnly)
+            {
+                status = initializeDofSolution();
+                CHECK_MSTATUS_AND_RETURN_IT(status);
+
+                status = runOptimization(opt);
+                CHECK_MSTATUS_AND_RETURN_IT(status);
+
+                totalIterations += m_num_solver_iterations;
+
+                storeFrameSolution(m_frame);
+
+                m_undo_history.markKeyed(m_solve_undo_sequence);
+            }
+
+            status = m_keyframe_sink.addFrame(m_frame, m_framerate);
             CHECK_MSTATUS_AND_RETURN_IT(status);
         }
 
-        status = keyframeRig();
+        // Keys are written once the whole range is solved
+        status = m_keyframe_sink.commit();
         CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        if (!saveKeysOnly && frameEnd >= frameStart)
+        {
+            double meanIterations =
+                (double)totalIterations / (frameEnd - frameStart + 1);
+
+            MGlobal::displayInfo("Mean iterations per frame: " +
+                                 MString(to_string(meanIterations).c_str()));
+        }
     }
 
-#ifdef RUN_OPTIMIZATION_TIMER
-    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    double bulkTime = SolveTelemetry::secondsSince(bulkStart);
 
-    cout << "Time taken to execute = "
-         << chrono::duration_cast<chrono::milliseconds>(end - begin).count()
-         << "[ms]" << endl;
-#endif
+    MGlobal::displayInfo("Time taken: " +
+                         MString(to_string(bulkTime).c_str()) + " s");
 
     status = redrawContactVisualizations();
     CHECK_MSTATUS_AND_RETURN_IT(status);
@@ -549,6 +725,30 @@ MStatus FusedMotionEditContext::resolveAccelerationErrors(int frameStart,
 
     nlopt::opt opt = initializeOptimization();
 
+    // Always re-read the scene, since keys may have been edited by hand or
+    // keyed from single-frame solves since the last compute. Iterations below
+    // only update the frames they solve.
+    status = storeExistingFrameSolutions(frameStart, frameEnd);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    m_frame_solutions.computeAccelerationErrors();
+
+    vector<int> frames;
+
+    for (int frame = frameStart; frame <= frameEnd; frame++)
+    {
+        frames.push_back(frame);
+    }
+
+    m_acceleration_violations.clear();
+
+    status = updateAccelerationViolations(frames);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Joint solves need the native objective
+    bool spaceTime =
+        m_space_time_window_size > 0 && !m_hand_skinning.isEmpty();
+
     int iteration = 0;
 
     for (; iteration < maxIterations; iteration++)
@@ -596,17 +796,24 @@ MStatus FusedMotionEditContext::resolveAccelerationErrors(int frameStart,
             }
         }
 
-        status = keyframeRigBulk(frameStart, frameEnd, true);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+        if (spaceTime)
+        {
+            status = resolveViolationWindows(frameStart, frameEnd);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        status = wipeContactPairingLines();
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+            status = updateAccelerationErrors();
+            CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        status = wipeMarkerPairingLines();
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+            status = jumpToFrame(frameStart);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        status = clearVisualizations();
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+            continue;
+        }
+
+        // Wiped frames start from their interpolated values. Keys are only
+        // written once all of them are solved, so no re-keying is needed.
+        m_keyframe_sink.clear();
+        m_recent_solutions.clear();
 
         for (const auto &entry : m_acceleration_violations)
         {
@@ -623,11 +830,18 @@ MStatus FusedMotionEditContext::resolveAccelerationErrors(int frameStart,
             status = runOptimization(opt);
             CHECK_MSTATUS_AND_RETURN_IT(status);
 
-            status = keyframeRig();
+            status = m_keyframe_sink.addFrame(m_frame, m_framerate);
             CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            storeFrameSolution(m_frame);
+
+            m_undo_history.markKeyed(m_solve_undo_sequence);
         }
 
-        status = computeAccelerationErrors(frameStart, frameEnd);
+        status = m_keyframe_sink.commit();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = updateAccelerationErrors();
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
         status = jumpToFrame(frameStart);
@@ -639,6 +853,9 @@ MStatus FusedMotionEditContext::resolveAccelerationErrors(int frameStart,
         cout << "Exhausted all iterations" << endl;
     }
 
+    status = plotAccelerationErrors();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     cout << "Remaining violations:" << endl;
 
     for (const auto &entry : m_acceleration_violations)
@@ -674,6 +891,17 @@ MStatus FusedMotionEditContext::resolveAccelerationErrors(int frameStart,
     return MS::kSuccess;
 }
 
+MStatus FusedMotionEditContext::setAccelerationPenaltyCoefficient(
+    double coefficient)
+{
+    MGlobal::displayInfo("Adjusting acceleration penalty coefficient to: " +
+                         MString(to_string(coefficient).c_str()));
+
+    m_acceleration_penalty_coefficient = coefficient;
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::setAccelerationViolationEpsilon(int frameStart,
                                                                 int frameEnd,
                                                                 double epsilon)
@@ -758,19 +986,95 @@ FusedMotionEditContext::setCoefficientPriorError(double priorCoefficient)
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::setNumOptIterations(int numIterations)
+MStatus FusedMotionEditContext::setMultiStartRestarts(int numRestarts)
 {
-    MGlobal::displayInfo("Adjusting optimization iterations to: " +
-                         MString(to_string(numIterations).c_str()));
+    MGlobal::displayInfo("Adjusting multi-start restarts to: " +
+                         MString(to_string(numRestarts).c_str()));
 
-    m_num_opt_iterations = numIterations;
+    m_num_restarts = max(numRestarts, 0);
 
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::storeAccelerationErrors()
+MStatus FusedMotionEditContext::setMultiStartTimeBudget(double seconds)
 {
-    MStatus status;
+    MGlobal::displayInfo("Adjusting multi-start time budget to: " +
+                         MString(to_string(seconds).c_str()) + " s");
+
+    m_restart_time_budget = max(seconds, 0.0);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setNumOptIterations(int numIterations)
+{
+    MGlobal::displayInfo("Adjusting optimization iterations to: " +
+                         MString(to_string(numIterations).c_str()));
+
+    m_num_opt_iterations = numIterations;
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setNumSolverThreads(int numThreads)
+{
+    // 0 uses every available core
+    if (numThreads <= 0)
+    {
+        numThreads = max((int)thread::hardware_concurrency(), 1);
+    }
+
+    MGlobal::displayInfo("Adjusting bulk solver threads to: " +
+                         MString(to_string(numThreads).c_str()));
+
+    m_num_solver_threads = numThreads;
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setOptimizationProgressRate(double rate)
+{
+    MGlobal::displayInfo("Adjusting optimization progress rate to: " +
+                         MString(to_string(rate).c_str()) + " Hz");
+
+    m_optimization_progress_rate = max(rate, 0.0);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setSpaceTimeWindowSize(int windowSize)
+{
+    MGlobal::displayInfo("Adjusting space-time window size to: " +
+                         MString(to_string(windowSize).c_str()));
+
+    m_space_time_window_size = max(windowSize, 0);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setUndoMemoryCap(int megabytes)
+{
+    MGlobal::displayInfo("Adjusting undo memory cap to: " +
+                         MString(to_string(megabytes).c_str()) + " MB");
+
+    m_undo_history.setMemoryCap((size_t)max(megabytes, 0) << 20);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setWarmStartChunkSize(int chunkSize)
+{
+    MGlobal::displayInfo("Adjusting warm start chunk size to: " +
+                         MString(to_string(chunkSize).c_str()));
+
+    m_warm_start_chunk_size = max(chunkSize, 1);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::storeAccelerationErrors()
+{
+    MStatus status;
 
     MGlobal::displayInfo("Storing...");
 
@@ -806,29 +1110,53 @@ MStatus FusedMotionEditContext::storeAccelerationErrors()
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::undoOptimization()
+MStatus FusedMotionEditContext::undoFrameOptimization(int frame)
 {
     MStatus status;
 
-    MGlobal::displayInfo("Undoing last optimization...");
+    MGlobal::displayInfo("Undoing last optimization of frame " +
+                         MString(to_string(frame).c_str()) + "...");
 
-    if (m_last_dof_vectors.size() > 0)
-    {
-        m_dof_vector = m_last_dof_vectors.top();
-        m_last_dof_vectors.pop();
+    DofDelta delta;
 
-        status = loadDofSolutionFull();
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    // Sequences of undone entries can be handed out again
+    m_solve_undo_sequence = -1;
 
-        status = redrawContactVisualizations();
+    if (m_undo_history.popFrame(frame, delta))
+    {
+        status = restoreDofDelta(delta);
         CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+    else
+    {
+        MGlobal::displayInfo("No optimization of this frame in undo history - "
+                             "did nothing");
+    }
 
-        status = redrawMarkerVisualizations();
+    MGlobal::displayInfo("Done");
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::undoOptimization()
+{
+    MStatus status;
+
+    MGlobal::displayInfo("Undoing last optimization...");
+
+    DofDelta delta;
+
+    m_solve_undo_sequence = -1;
+
+    if (m_undo_history.popLatest(delta))
+    {
+        status = restoreDofDelta(delta);
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
     else
     {
-        MGlobal::displayInfo("Optimization undo stack is empty - did nothing");
+        MGlobal::displayInfo(
+            "Optimization undo history is empty - did nothing");
     }
 
     MGlobal::displayInfo("Done");
@@ -836,6 +1164,100 @@ MStatus FusedMotionEditContext::undoOptimization()
     return MS::kSuccess;
 }
 
+MStatus FusedMotionEditContext::validateGradient()
+{
+    MStatus status;
+
+    MGlobal::displayInfo("Validating analytic gradient...");
+
+    m_correspondence_frame = -1;
+
+    status = initializeDofSolution();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MDoubleArray existingDofs = MDoubleArray(m_dof_vector);
+
+    double currentObj = computeObjective(existingDofs, true);
+
+    vector<double> analyticGrad(m_rig_n_dofs, 0.0);
+
+    status = computeObjectiveGradient(existingDofs, analyticGrad);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Exact gradient of the templated objective, independent of step size
+    vector<double> dualGrad(m_rig_n_dofs, 0.0);
+
+    status = computeObjectiveGradient(existingDofs, dualGrad, true);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    vector<double> dofs(m_rig_n_dofs);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        dofs[i] = m_dof_vector[i];
+    }
+
+    double templatedObj = m_frame_objective.computeReferenceObjective(dofs);
+
+    MGlobal::displayInfo(
+        "Templated objective error: " +
+        MString(to_string(abs(templatedObj - currentObj)).c_str()));
+
+    // Native forward kinematics should reproduce the scene joint positions
+    status = updateHandPose();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    double maxJointError = 0.0;
+
+    for (int i = 0; i < m_rig_joints.length(); i++)
+    {
+        MMatrix jointMatrix = m_rig_joints[i].inclusiveMatrix(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        const double *world = &m_hand_pose.m_world_matrices[MATRIX_SIZE * i];
+
+        MPoint nativePosition(world[12], world[13], world[14]);
+        MPoint scenePosition = MPoint::origin * jointMatrix;
+
+        maxJointError =
+            max(maxJointError, nativePosition.distanceTo(scenePosition));
+    }
+
+    MGlobal::displayInfo("Max forward kinematics joint error: " +
+                         MString(to_string(maxJointError).c_str()));
+
+    double maxAbsError = 0.0;
+    double maxDualError = 0.0;
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        // Central differences so the L1 prior has a zero subgradient here
+        double forwardGrad = computeDofGradient(
+            existingDofs, FINITE_DIFFERENCE_STEP, currentObj, i);
+        double backwardGrad = computeDofGradient(
+            existingDofs, -FINITE_DIFFERENCE_STEP, currentObj, i);
+
+        double numericGrad = 0.5 * (forwardGrad + backwardGrad);
+        double absError = abs(analyticGrad[i] - numericGrad);
+        double dualError = abs(analyticGrad[i] - dualGrad[i]);
+
+        maxAbsError = max(maxAbsError, absError);
+        maxDualError = max(maxDualError, dualError);
+
+        // Easier to look up in command line
+        cout << i << " analytic " << analyticGrad[i] << " numeric "
+             << numericGrad << " error " << absError << " dual "
+             << dualGrad[i] << " error " << dualError << endl;
+    }
+
+    MGlobal::displayInfo("Max absolute gradient error: " +
+                         MString(to_string(maxAbsError).c_str()));
+    MGlobal::displayInfo("Max dual number gradient error: " +
+                         MString(to_string(maxDualError).c_str()));
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::wipeRigKeyframe(int frameStart, int frameEnd)
 {
     MStatus status;
@@ -893,6 +1315,131 @@ void FusedMotionEditContext::completeAction()
 
 // Core Context Setup
 
+MStatus FusedMotionEditContext::buildHandKinematics()
+{
+    MStatus status;
+
+    m_hand_kinematics.clear();
+
+    double preValues[4][4];
+    double postValues[4][4];
+    double rotationValues[4][4];
+
+    for (int i = 0; i < m_rig_joints.length(); i++)
+    {
+        MDagPath joint = m_rig_joints[i];
+
+        MFnIkJoint fnJoint(joint, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        double rotation[3];
+        MTransformationMatrix::RotationOrder order;
+
+        status = fnJoint.getRotation(rotation, order);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        int rotationSequence[3];
+
+        switch (order)
+        {
+        case MTransformationMatrix::kYZX:
+            rotationSequence[0] = 1;
+            rotationSequence[1] = 2;
+            rotationSequence[2] = 0;
+            break;
+        case MTransformationMatrix::kZXY:
+            rotationSequence[0] = 2;
+            rotationSequence[1] = 0;
+            rotationSequence[2] = 1;
+            break;
+        case MTransformationMatrix::kXZY:
+            rotationSequence[0] = 0;
+            rotationSequence[1] = 2;
+            rotationSequence[2] = 1;
+            break;
+        case MTransformationMatrix::kYXZ:
+            rotationSequence[0] = 1;
+            rotationSequence[1] = 0;
+            rotationSequence[2] = 2;
+            break;
+        case MTransformationMatrix::kZYX:
+            rotationSequence[0] = 2;
+            rotationSequence[1] = 1;
+            rotationSequence[2] = 0;
+            break;
+        default:
+            rotationSequence[0] = 0;
+            rotationSequence[1] = 1;
+            rotationSequence[2] = 2;
+            break;
+        }
+
+        MTransformationMatrix tf = fnJoint.transformation(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        // Joint local matrix is [S] * [RO] * [R] * [JO] * [IS] * [T], so
+        // everything before the rotation is constant during optimization
+        MMatrix preMatrix =
+            tf.asScaleMatrix() * tf.rotationOrientation().asMatrix();
+
+        HandKinematics::computeRotationMatrix(rotationSequence, rotation,
+                                              &rotationValues[0][0]);
+
+        MMatrix rotationMatrix(rotationValues);
+
+        int parent = -1;
+        MMatrix parentMatrix;
+
+        MDagPath parentPath(joint);
+        parentPath.pop();
+
+        string parentPathChar = parentPath.fullPathName().asChar();
+
+        if (i > 0 && m_joint_rig_indices.contains(parentPathChar))
+        {
+            parent = m_joint_rig_indices[parentPathChar];
+
+            parentMatrix = m_rig_joints[parent].inclusiveMatrix(&status);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+
+        MMatrix jointMatrix = joint.inclusiveMatrix(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        // Everything after the rotation, including any welded joints between
+        // this joint and its rig parent (and the rig's own parent for the
+        // root)
+        MMatrix postMatrix = (preMatrix * rotationMatrix).inverse() *
+                             jointMatrix * parentMatrix.inverse();
+
+        status = preMatrix.get(preValues);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = postMatrix.get(postValues);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MVector vTrans = fnJoint.getTranslation(MSpace::kWorld, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        double translation[3] = {vTrans.x, vTrans.y, vTrans.z};
+
+        // Root translation dofs are set in world space
+        bool worldTranslation = i == 0;
+
+        m_hand_kinematics.addJoint(parent, &preValues[0][0], &postValues[0][0],
+                                   rotationSequence, rotation, translation,
+                                   worldTranslation);
+    }
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        pair<int, int> indices = m_dof_vec_mappings.at(i);
+        m_hand_kinematics.addDof(indices.first, indices.second);
+    }
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::loadAllGeometries()
 {
     MStatus status;
@@ -1029,87 +1576,444 @@ MStatus FusedMotionEditContext::loadMarkerPatchPairing(MString &markerPatchName)
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::loadTable()
+// Signed distance grid of the object mesh in object space. Grids are cached
+// next to the scene under the hash of the mesh, so reopening the tool or the
+// scene skips the build.
+MStatus FusedMotionEditContext::loadObjectSDF()
 {
     MStatus status;
 
-    MSelectionList selectionList;
-
-    status = MGlobal::getSelectionListByName(TABLE_NAME, selectionList);
+    MFnMesh fnObjectMesh(m_object_geometry, &status);
 
     if (status != MS::kSuccess)
     {
-        MGlobal::displayInfo("Table not found - skipping transform loading");
-        m_table_transform_inv[3][3] = -1;
+        MGlobal::displayInfo("Object mesh not found - skipping object SDF");
+        m_object_sdf.clear();
         return MS::kSuccess;
     }
 
-    MDagPath tableDag;
-    status = selectionList.getDagPath(0, tableDag);
+    MPointArray objectPoints;
+    status = fnObjectMesh.getPoints(objectPoints, MSpace::kObject);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    MFnTransform fnTableTransform(tableDag, &status);
+    MIntArray triangleCounts;
+    MIntArray triangleVertices;
+    status = fnObjectMesh.getTriangles(triangleCounts, triangleVertices);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    double scale[3];
-    status = fnTableTransform.getScale(scale);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    int numPoints = objectPoints.length();
+    int numTriangleVertices = triangleVertices.length();
 
-    MVector boxDims(scale[0], scale[1], scale[2]);
-    boxDims *= 0.5;
-    m_table_box_dims = boxDims;
+    vector<double> vertices(3 * numPoints);
+    vector<int> triangles(numTriangleVertices);
 
-    MTransformationMatrix tfTable = fnTableTransform.transformation(&status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    for (int i = 0; i < numPoints; i++)
+    {
+        vertices[3 * i] = objectPoints[i].x;
+        vertices[3 * i + 1] = objectPoints[i].y;
+        vertices[3 * i + 2] = objectPoints[i].z;
+    }
 
-    double unitScale[3] = {1, 1, 1};
-    status = tfTable.setScale(unitScale, MSpace::kTransform);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    for (int i = 0; i < numTriangleVertices; i++)
+    {
+        triangles[i] = triangleVertices[i];
+    }
 
-    // Maya apparently transposes the conventional matrix
-    m_table_transform_inv = tfTable.asMatrix().transpose().inverse();
+    uint64_t meshHash = ObjectSDF::computeMeshHash(vertices, triangles);
 
-    return MS::kSuccess;
-}
+    if (!m_object_sdf.isEmpty() && m_object_sdf.getMeshHash() == meshHash)
+    {
+        return MS::kSuccess;
+    }
 
-MStatus FusedMotionEditContext::parseKinematicTree()
-{
-    MStatus status;
+    // Untitled scenes are not cached
 
-    MItDag itList(MItDag::TraversalType::kDepthFirst, MFn::kJoint, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    fs::path scenePath(MFileIO::currentFile().asChar());
+    string cacheFilename;
 
-    if (itList.isDone())
+    if (fs::is_regular_file(scenePath))
     {
-        MGlobal::displayInfo(
-            "No joints found - skipping kinematic tree parsing");
-        return MS::kSuccess;
+        stringstream cacheName;
+        cacheName << scenePath.stem().string() << "_object_" << hex
+                  << meshHash << ".sdf";
+
+        cacheFilename = (scenePath.parent_path() / cacheName.str()).string();
     }
 
-    for (; !itList.isDone(); itList.next())
+    if (!cacheFilename.empty() && m_object_sdf.load(cacheFilename, meshHash))
     {
-        MDagPath jointPath;
-        status = itList.getPath(jointPath);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+        MGlobal::displayInfo("Loaded object SDF from " +
+                             MString(cacheFilename.c_str()));
+        return MS::kSuccess;
+    }
 
-        MGlobal::displayInfo("Found root joint " + jointPath.partialPathName());
+    TelemetryClock buildStart = SolveTelemetry::now();
 
-        m_rig_base = jointPath;
-        break;
+    m_object_sdf.build(vertices, triangles);
+
+    MGlobal::displayInfo(
+        "Built object SDF in " +
+        MString(to_string(SolveTelemetry::secondsSince(buildStart)).c_str()) +
+        "s");
+
+    if (!cacheFilename.empty() && !m_object_sdf.save(cacheFilename))
+    {
+        MGlobal::displayWarning("Could not cache object SDF to " +
+                                MString(cacheFilename.c_str()));
     }
 
-    int nDofs = 0;
-    int numJoints = 0;
+    return MS::kSuccess;
+}
 
-    stack<MDagPath> stack;
-    stack.push(m_rig_base);
+MStatus FusedMotionEditContext::loadSkinWeights()
+{
+    MStatus status;
 
-    while (!stack.empty())
-    {
-        MDagPath dp = stack.top();
-        stack.pop();
+    m_hand_skinning.clear();
 
-        // Ignore everything except joints
+    MObject handMeshNode = m_hand_geometry.node(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MItDependencyGraph itGraph(handMeshNode, MFn::kSkinClusterFilter,
+                               MItDependencyGraph::kUpstream,
+                               MItDependencyGraph::kDepthFirst,
+                               MItDependencyGraph::kNodeLevel, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (itGraph.isDone())
+    {
+        MGlobal::displayInfo("No skin cluster found on hand mesh - falling "
+                             "back to scene evaluation");
+        return MS::kSuccess;
+    }
+
+    MObject skinClusterNode = itGraph.currentItem(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnSkinCluster fnSkinCluster(skinClusterNode, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int numVertices = fnHandMesh.numVertices();
+    int numRigJoints = m_rig_joints.length();
+
+    // Step 1: Bind pose geometry (the undeformed skin cluster input)
+
+    MPlug geomMatrixPlug = fnSkinCluster.findPlug("geomMatrix", true, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnMatrixData fnGeomMatrixData(geomMatrixPlug.asMObject(), &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MMatrix geomMatrix = fnGeomMatrixData.matrix(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MObjectArray inputGeometries;
+    status = fnSkinCluster.getInputGeometry(inputGeometries);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MPointArray bindPoints;
+    MFloatVectorArray bindNormals;
+
+    bool bindGeometryAvailable = false;
+
+    if (inputGeometries.length() > 0)
+    {
+        MFnMesh fnBindMesh(inputGeometries[0], &status);
+
+        if (status == MS::kSuccess && fnBindMesh.numVertices() == numVertices)
+        {
+            status = fnBindMesh.getPoints(bindPoints, MSpace::kObject);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            status =
+                fnBindMesh.getVertexNormals(false, bindNormals, MSpace::kObject);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            bindGeometryAvailable = true;
+        }
+    }
+
+    // Without it, treat the current pose as the bind pose
+    MPointArray scenePoints;
+    MFloatVectorArray sceneNormals;
+
+    status = fnHandMesh.getPoints(scenePoints, MSpace::kWorld);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = fnHandMesh.getVertexNormals(false, sceneNormals, MSpace::kWorld);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MMatrix skinMatrix = m_hand_geometry.inclusiveMatrix(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MMatrix skinMatrixInverse = skinMatrix.inverse();
+
+    // Step 2: Influence bind transforms, mapped onto the rig joints
+
+    MDagPathArray influencePaths;
+    int numInfluences = fnSkinCluster.influenceObjects(influencePaths, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MPlug bindPreMatrixArrayPlug =
+        fnSkinCluster.findPlug("bindPreMatrix", true, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Influences outside of the rig never move during optimization
+    vector<int> influenceRigIndices(numInfluences, STATIC_INFLUENCE);
+    vector<MMatrix> influenceBindMatrices(numInfluences);
+
+    for (int i = 0; i < numInfluences; i++)
+    {
+        string influencePathChar = influencePaths[i].fullPathName().asChar();
+
+        if (m_joint_rig_indices.contains(influencePathChar))
+        {
+            influenceRigIndices[i] = m_joint_rig_indices[influencePathChar];
+        }
+
+        unsigned int logicalIndex =
+            fnSkinCluster.indexForInfluenceObject(influencePaths[i], &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MPlug bindPreMatrixPlug =
+            bindPreMatrixArrayPlug.elementByLogicalIndex(logicalIndex, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MFnMatrixData fnBindPreMatrixData(bindPreMatrixPlug.asMObject(),
+                                          &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MMatrix bindPreMatrix = fnBindPreMatrixData.matrix(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MMatrix influenceMatrix = influencePaths[i].inclusiveMatrix(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        influenceBindMatrices[i] = geomMatrix * bindPreMatrix * influenceMatrix;
+    }
+
+    vector<MMatrix> rigJointInverses(numRigJoints);
+
+    for (int j = 0; j < numRigJoints; j++)
+    {
+        rigJointInverses[j] = m_rig_joints[j].inclusiveMatrixInverse(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    // Step 3: Per vertex influence rows, expressed in rig joint space
+
+    MFnSingleIndexedComponent fnVertexComponent;
+    MObject vertexComponent =
+        fnVertexComponent.create(MFn::kMeshVertComponent, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = fnVertexComponent.setCompleteData(numVertices);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MDoubleArray weights;
+    unsigned int numWeightsPerVertex;
+
+    status = fnSkinCluster.getWeights(m_hand_geometry, vertexComponent,
+                                      weights, numWeightsPerVertex);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Last slot collects the static influences
+    vector<double> slotWeights(numRigJoints + 1);
+    vector<MVector> slotPositions(numRigJoints + 1);
+    vector<MVector> slotNormals(numRigJoints + 1);
+
+    for (int v = 0; v < numVertices; v++)
+    {
+        fill(slotWeights.begin(), slotWeights.end(), 0.0);
+        fill(slotPositions.begin(), slotPositions.end(), MVector::zero);
+        fill(slotNormals.begin(), slotNormals.end(), MVector::zero);
+
+        for (int i = 0; i < numWeightsPerVertex; i++)
+        {
+            double weight = weights[v * numWeightsPerVertex + i];
+
+            if (weight <= 0.0)
+            {
+                continue;
+            }
+
+            MPoint influencePosition;
+            MVector influenceNormal;
+
+            if (bindGeometryAvailable)
+            {
+                influencePosition = bindPoints[v] * influenceBindMatrices[i];
+                influenceNormal =
+                    MVector(bindNormals[v]) * influenceBindMatrices[i];
+            }
+            else
+            {
+                influencePosition = scenePoints[v] * skinMatrixInverse;
+                influenceNormal = MVector(sceneNormals[v]) * skinMatrixInverse;
+            }
+
+            influenceNormal.normalize();
+
+            int rigJointIndex = influenceRigIndices[i];
+            int slot = numRigJoints;
+
+            if (rigJointIndex != STATIC_INFLUENCE)
+            {
+                slot = rigJointIndex;
+
+                influencePosition *= rigJointInverses[rigJointIndex];
+                influenceNormal = influenceNormal * rigJointInverses[rigJointIndex];
+            }
+
+            slotWeights[slot] += weight;
+            slotPositions[slot] += MVector(influencePosition) * weight;
+            slotNormals[slot] += influenceNormal * weight;
+        }
+
+        for (int slot = 0; slot <= numRigJoints; slot++)
+        {
+            if (slotWeights[slot] <= 0.0)
+            {
+                continue;
+            }
+
+            int joint = slot < numRigJoints ? slot : STATIC_INFLUENCE;
+
+            double localPosition[3] = {slotPositions[slot].x,
+                                       slotPositions[slot].y,
+                                       slotPositions[slot].z};
+            double localNormal[3] = {slotNormals[slot].x, slotNormals[slot].y,
+                                     slotNormals[slot].z};
+
+            m_hand_skinning.addInfluence(joint, slotWeights[slot],
+                                         localPosition, localNormal);
+        }
+
+        m_hand_skinning.addVertex();
+    }
+
+    double skinValues[4][4];
+
+    status = skinMatrix.get(skinValues);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    m_hand_skinning.setSkinMatrix(&skinValues[0][0]);
+
+    m_hand_skinning.buildBoneBounds(m_hand_kinematics);
+
+    // Step 4: Native result should reproduce the scene at setup
+
+    status = updateHandPose();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    double maxVertexError = 0.0;
+
+    double position[3];
+    double normal[3];
+
+    for (int v = 0; v < numVertices; v++)
+    {
+        m_hand_skinning.computeVertex(m_hand_pose, v, position, normal);
+
+        MPoint nativePoint(position[0], position[1], position[2]);
+
+        maxVertexError =
+            max(maxVertexError, nativePoint.distanceTo(scenePoints[v]));
+    }
+
+    MGlobal::displayInfo(
+        "Native skinning loaded for " +
+        MString(to_string(numVertices).c_str()) +
+        " hand vertices. Max vertex error: " +
+        MString(to_string(maxVertexError).c_str()));
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::loadTable()
+{
+    MStatus status;
+
+    MSelectionList selectionList;
+
+    status = MGlobal::getSelectionListByName(TABLE_NAME, selectionList);
+
+    if (status != MS::kSuccess)
+    {
+        MGlobal::displayInfo("Table not found - skipping transform loading");
+        m_table_transform_inv[3][3] = -1;
+        return MS::kSuccess;
+    }
+
+    MDagPath tableDag;
+    status = selectionList.getDagPath(0, tableDag);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnTransform fnTableTransform(tableDag, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    double scale[3];
+    status = fnTableTransform.getScale(scale);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MVector boxDims(scale[0], scale[1], scale[2]);
+    boxDims *= 0.5;
+    m_table_box_dims = boxDims;
+
+    MTransformationMatrix tfTable = fnTableTransform.transformation(&status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    double unitScale[3] = {1, 1, 1};
+    status = tfTable.setScale(unitScale, MSpace::kTransform);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Maya apparently transposes the conventional matrix
+    m_table_transform_inv = tfTable.asMatrix().transpose().inverse();
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::parseKinematicTree()
+{
+    MStatus status;
+
+    MItDag itList(MItDag::TraversalType::kDepthFirst, MFn::kJoint, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (itList.isDone())
+    {
+        MGlobal::displayInfo(
+            "No joints found - skipping kinematic tree parsing");
+        return MS::kSuccess;
+    }
+
+    for (; !itList.isDone(); itList.next())
+    {
+        MDagPath jointPath;
+        status = itList.getPath(jointPath);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MGlobal::displayInfo("Found root joint " + jointPath.partialPathName());
+
+        m_rig_base = jointPath;
+        break;
+    }
+
+    int nDofs = 0;
+    int numJoints = 0;
+
+    stack<MDagPath> stack;
+    stack.push(m_rig_base);
+
+    while (!stack.empty())
+    {
+        MDagPath dp = stack.top();
+        stack.pop();
+
+        // Ignore everything except joints
         if (!dp.hasFn(MFn::kJoint))
         {
             continue;
@@ -1133,27 +2037,27 @@ MStatus FusedMotionEditContext::parseKinematicTree()
         status = fnJoint.getRotation(jointRotations, rOrder);
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        if (freeX)
-        {
-            pair<int, int> xRotDof = make_pair(numJoints, 0);
-            m_dof_vec_mappings.push_back(xRotDof);
-            m_dof_vector.append(jointRotations[0]);
-            numJointDofs++;
-            nDofs++;
-        }
-        if (freeY)
-        {
-            pair<int, int> yRotDof = make_pair(numJoints, 1);
-            m_dof_vec_mappings.push_back(yRotDof);
-            m_dof_vector.append(jointRotations[1]);
-            numJointDofs++;
-            nDofs++;
-        }
-        if (freeZ)
+        bool freeAxes[3] = {freeX, freeY, freeZ};
+
+        for (int axis = 0; axis < 3; axis++)
         {
-            pair<int, int> zRotDof = make_pair(numJoints, 2);
-            m_dof_vec_mappings.push_back(zRotDof);
-            m_dof_vector.append(jointRotations[2]);
+            if (!freeAxes[axis])
+            {
+                continue;
+            }
+
+            double lowerLimit;
+            double upperLimit;
+
+            status =
+                getJointRotationLimits(fnJoint, axis, lowerLimit, upperLimit);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            pair<int, int> rotDof = make_pair(numJoints, axis);
+            m_dof_vec_mappings.push_back(rotDof);
+            m_dof_vector.append(jointRotations[axis]);
+            m_dof_lower_limits.push_back(lowerLimit);
+            m_dof_upper_limits.push_back(upperLimit);
             numJointDofs++;
             nDofs++;
         }
@@ -1179,15 +2083,39 @@ MStatus FusedMotionEditContext::parseKinematicTree()
             m_dof_vector.append(vTrans[1]);
             m_dof_vector.append(vTrans[2]);
 
+            for (int axis = 0; axis < 3; axis++)
+            {
+                m_dof_lower_limits.push_back(-HUGE_VAL);
+                m_dof_upper_limits.push_back(HUGE_VAL);
+            }
+
             nDofs += 3;
         }
 
+        string jointPathChar = dp.fullPathName().asChar();
+
         // Ignore all welded joints
         if (numJointDofs > 0)
         {
+            m_joint_rig_indices[jointPathChar] = numJoints;
+
             m_rig_joints.append(dp);
             numJoints++;
         }
+        else
+        {
+            // Welded joints move rigidly with their nearest rig ancestor
+            MDagPath parentPath(dp);
+            parentPath.pop();
+
+            string parentPathChar = parentPath.fullPathName().asChar();
+
+            if (m_joint_rig_indices.contains(parentPathChar))
+            {
+                m_joint_rig_indices[jointPathChar] =
+                    m_joint_rig_indices[parentPathChar];
+            }
+        }
 
         MString jointName = dp.partialPathName();
         m_joint_names.append(jointName);
@@ -1254,6 +2182,8 @@ MStatus FusedMotionEditContext::parseKinematicTree()
              << value << endl;
     }
 
+    m_keyframe_sink.setRig(m_rig_joints, m_dof_vec_mappings);
+
     return MS::kSuccess;
 }
 
@@ -1551,27 +2481,80 @@ MStatus FusedMotionEditContext::redrawMarkerVisualizations()
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::visualizeAllContacts()
+// Poses the scene at the best dofs of the running solve, refreshes the view
+// and then restores the dofs being evaluated
+MStatus FusedMotionEditContext::redrawOptimizationProgress()
 {
     MStatus status;
 
-    MSelectionList selectionList;
-
-    MString frameStringSuffix = MString(to_string(m_frame).c_str());
-
-    MString allContactsGroupName = CONTACT_GROUP_PREFIX + frameStringSuffix;
-
-    status =
-        MGlobal::getSelectionListByName(allContactsGroupName, selectionList);
+    const vector<double> &bestDofs = m_progress_snapshot.getDofs();
 
-    // No contact information available
-    if (status != MS::kSuccess)
+    if ((int)bestDofs.size() != m_rig_n_dofs)
     {
         return MS::kSuccess;
     }
 
-    MFnMesh fnObjectMesh(m_object_geometry, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    MDoubleArray evaluatedDofs = MDoubleArray(m_dof_vector);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        m_dof_vector[i] = bestDofs[i];
+    }
+
+    status = loadDofSolutionFull();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    m_view.refresh(false, true);
+
+    m_dof_vector = evaluatedDofs;
+
+    status = loadDofSolutionFull();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    double weightedMarkerError;
+    double weightedContactError;
+    double weightedIntersectionError;
+    double weightedPriorError;
+
+    m_progress_snapshot.getWeightedErrors(
+        weightedMarkerError, weightedContactError, weightedIntersectionError,
+        weightedPriorError);
+
+    MGlobal::displayInfo(
+        "Evaluation " +
+        MString(to_string(m_progress_snapshot.getNumEvaluations()).c_str()) +
+        " - Marker: " + MString(to_string(weightedMarkerError).c_str()) +
+        " Contact: " + MString(to_string(weightedContactError).c_str()) +
+        " Intersection: " +
+        MString(to_string(weightedIntersectionError).c_str()) +
+        " Prior: " + MString(to_string(weightedPriorError).c_str()));
+
+    m_progress_snapshot.markDrawn();
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::visualizeAllContacts()
+{
+    MStatus status;
+
+    MSelectionList selectionList;
+
+    MString frameStringSuffix = MString(to_string(m_frame).c_str());
+
+    MString allContactsGroupName = CONTACT_GROUP_PREFIX + frameStringSuffix;
+
+    status =
+        MGlobal::getSelectionListByName(allContactsGroupName, selectionList);
+
+    // No contact information available
+    if (status != MS::kSuccess)
+    {
+        return MS::kSuccess;
+    }
+
+    MFnMesh fnObjectMesh(m_object_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
     MFnMesh fnHandMesh(m_hand_geometry, &status);
     CHECK_MSTATUS_AND_RETURN_IT(status);
@@ -1745,6 +2728,187 @@ MStatus FusedMotionEditContext::visualizePatch(MFnMesh &fnMesh,
 
 // Core Utils
 
+// Resolves the serialized contacts and marker patches of the current frame
+// once so that objective evaluations do not query sets or parse strings
+MStatus FusedMotionEditContext::compileFrameCorrespondences()
+{
+    MStatus status;
+
+    if (m_correspondence_frame == m_frame)
+    {
+        return MS::kSuccess;
+    }
+
+    TelemetryClock sceneStart = SolveTelemetry::now();
+
+    m_frame_correspondences.clear();
+
+    MSelectionList selectionList;
+
+    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnMesh fnObjectMesh(m_object_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    vector<int> vertexIndices;
+    vector<double> coords;
+
+    // Contacts - the object side is fixed for the frame so it is resolved now
+
+    MString objectShapeName = OBJECT_NAME + "Shape_";
+    MString handShapeName = m_hand_name + "Shape_";
+
+    MString frameStringSuffix = MString(to_string(m_frame).c_str());
+
+    MString allContactsGroupName = CONTACT_GROUP_PREFIX + frameStringSuffix;
+
+    MString objectContactGroupName =
+        CONTACT_GROUP_PREFIX + objectShapeName + frameStringSuffix;
+
+    MString handContactGroupName =
+        CONTACT_GROUP_PREFIX + handShapeName + frameStringSuffix;
+
+    status =
+        MGlobal::getSelectionListByName(allContactsGroupName, selectionList);
+
+    // Skip if no contact information available
+    if (status == MS::kSuccess)
+    {
+        MStringArray serializedObjectContactPoints;
+        MStringArray serializedHandContactPoints;
+
+        status = getSetSerializedPointsAttribute(objectContactGroupName,
+                                                 CONTACT_POINTS_ATTRIBUTE,
+                                                 serializedObjectContactPoints);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = getSetSerializedPointsAttribute(handContactGroupName,
+                                                 CONTACT_POINTS_ATTRIBUTE,
+                                                 serializedHandContactPoints);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MFloatPoint objectPointPosition;
+        MFloatVector objectPointNormal;
+
+        int numContactPoints = serializedObjectContactPoints.length();
+
+        for (int cpi = 0; cpi < numContactPoints; cpi++)
+        {
+            MString serializedObjectContactPoint =
+                serializedObjectContactPoints[cpi];
+            MString serializedHandContactPoint =
+                serializedHandContactPoints[cpi];
+
+            vertexIndices.clear();
+            coords.clear();
+
+            status = parseSerializedPoint(fnObjectMesh,
+                                          serializedObjectContactPoint,
+                                          vertexIndices, coords);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            status = interpolateSerializedPoint(
+                fnObjectMesh, vertexIndices, coords, objectPointPosition,
+                objectPointNormal);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            vertexIndices.clear();
+            coords.clear();
+
+            status = parseSerializedPoint(
+                fnHandMesh, serializedHandContactPoint, vertexIndices, coords);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            double objectPosition[3] = {objectPointPosition.x,
+                                        objectPointPosition.y,
+                                        objectPointPosition.z};
+            double objectNormal[3] = {objectPointNormal.x, objectPointNormal.y,
+                                      objectPointNormal.z};
+
+            if (!m_frame_correspondences.addContact(
+                    vertexIndices, coords, objectPosition, objectNormal))
+            {
+                return MS::kFailure;
+            }
+        }
+    }
+
+    // Markers
+
+    for (auto const &entry : m_paired_marker_patches)
+    {
+        string markerPatchNameChar = entry.first;
+        MString mocapMarkerName = entry.second;
+
+        MString markerPatchName = MString(markerPatchNameChar.c_str());
+
+        MStringArray serializedMarkerMatchPoints;
+        status = getSetSerializedPointsAttribute(markerPatchName,
+                                                 MARKER_POINTS_ATTRIBUTE,
+                                                 serializedMarkerMatchPoints);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MDagPath mocapMarkerDag;
+        status = getMocapMarker(mocapMarkerName, mocapMarkerDag);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MFnTransform fnMocapTransform(mocapMarkerDag, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MTransformationMatrix tfmocap =
+            fnMocapTransform.transformation(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MPoint mocapMarkerPoint = MPoint::origin;
+
+        mocapMarkerPoint *= tfmocap.asMatrix();
+
+        double markerPosition[3] = {mocapMarkerPoint.x, mocapMarkerPoint.y,
+                                    mocapMarkerPoint.z};
+
+        int numPoints = serializedMarkerMatchPoints.length();
+
+        for (int i = 0; i < numPoints; i++)
+        {
+            vertexIndices.clear();
+            coords.clear();
+
+            MString serializedMarkerMatchPoint = serializedMarkerMatchPoints[i];
+
+            status = parseSerializedPoint(fnHandMesh, serializedMarkerMatchPoint,
+                                          vertexIndices, coords);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            if (!m_frame_correspondences.addMarker(vertexIndices, coords,
+                                                   markerPosition))
+            {
+                return MS::kFailure;
+            }
+        }
+    }
+
+    // Object pose, for the object penetration term
+
+    if (!m_object_sdf.isEmpty())
+    {
+        MMatrix objectMatrix = m_object_geometry.inclusiveMatrix(&status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        double objectInverse[4][4];
+
+        status = objectMatrix.transpose().inverse().get(objectInverse);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        m_frame_correspondences.setObjectInverse(&objectInverse[0][0]);
+    }
+
+    m_correspondence_frame = m_frame;
+
+    m_frame_telemetry.sceneTime += SolveTelemetry::secondsSince(sceneStart);
+
+    return MS::kSuccess;
+}
 MStatus FusedMotionEditContext::computePairedMarkerPatchLocations(
     vector<MPointArray> &pointLocations)
 {
@@ -1819,91 +2983,281 @@ MStatus FusedMotionEditContext::computePairedMarkerPatchLocations(
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::computeTableSDF(MPoint &queryPoint,
-                                                double &signedDistance)
+// Fallback for unskinned hands - reads the deformed scene mesh, so the rig
+// must already carry the candidate dofs
+MStatus FusedMotionEditContext::computeSceneObjectiveErrors(
+    const MDoubleArray &existingDofs, double &weightedMarkerError,
+    double &weightedContactError, double &weightedIntersectionError,
+    double &weightedPriorError)
 {
     MStatus status;
 
-    if (m_table_transform_inv[3][3] == -1)
+    double contactDistanceError = 0.0;
+    double contactNormalError = 0.0;
+
+    double markerError = 0.0;
+    double intersectionError = 0.0;
+    double priorError = 0.0;
+
+    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Step 1: Compute prior error
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
     {
-        MGlobal::displayError(
-            "Error: Table does not exist - cannot compute SDF.");
-        return MS::kFailure;
+        // Do not include base movement in prior error
+        if (i > 5)
+        {
+            priorError += abs(existingDofs[i] - m_dof_vector[i]);
+        }
     }
 
-    MPoint relativeQueryPoint = m_table_transform_inv * queryPoint;
+    // Step 2: Compute contact point-to-point distance and normal error
+
+    MFloatPoint handPointPosition;
+    MFloatVector handPointNormal;
+
+    int numContactPoints = m_frame_correspondences.getNumContacts();
 
-    MVector absVec(abs(relativeQueryPoint.x), abs(relativeQueryPoint.y),
-                   abs(relativeQueryPoint.z));
+    for (int i = 0; i < numContactPoints; i++)
+    {
+        status = interpolateHandPoint(
+            fnHandMesh, m_frame_correspondences.getContactVertices(i),
+            m_frame_correspondences.getContactWeights(i),
+            m_frame_correspondences.getContactVertexCount(i),
+            handPointPosition, handPointNormal);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    MVector q = absVec - m_table_box_dims;
+        const double *target = m_frame_correspondences.getContactTarget(i);
+        const double *targetNormal =
+            m_frame_correspondences.getContactTargetNormal(i);
 
-    MVector maxVec(max(q.x, 0.0), max(q.y, 0.0), max(q.z, 0.0));
+        MPoint objectPoint(target[0], target[1], target[2]);
+        MVector objectNormal(targetNormal[0], targetNormal[1], targetNormal[2]);
 
-    signedDistance = maxVec.length() + min(max(q.x, max(q.y, q.z)), 0.0);
+        MPoint handPoint(handPointPosition);
+        MVector handNormal(handPointNormal);
 
-    return MS::kSuccess;
-}
+        // Distance error
 
-MStatus FusedMotionEditContext::generateHandTestPoints(
-    vector<pair<MFloatPoint, MFloatVector>> &handPoints)
-{
-    MStatus status;
+        double distance = objectPoint.distanceTo(handPoint);
+        contactDistanceError += distance;
 
-    MFnMesh fnHandMesh(m_hand_geometry, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+        // Normal error
 
-    MPoint vPoint;
-    MVector vNormal;
+        double normalAntiAlignment = 1 + (objectNormal * handNormal);
+        contactNormalError += normalAntiAlignment;
+    }
 
-    handPoints.clear();
+    double contactError =
+        m_contact_distance_penalty_coefficient * contactDistanceError +
+        m_contact_normal_penalty_coefficient * contactNormalError;
 
-    for (int i = 0; i < fnHandMesh.numVertices(); i++)
-    {
-        status = fnHandMesh.getPoint(i, vPoint, MSpace::kWorld);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    // Step 3: Compute marker point-to-marker distance error
 
-        status = fnHandMesh.getVertexNormal(i, false, vNormal, MSpace::kWorld);
+    int numMarkerPoints = m_frame_correspondences.getNumMarkers();
+
+    for (int i = 0; i < numMarkerPoints; i++)
+    {
+        status = interpolateHandPoint(
+            fnHandMesh, m_frame_correspondences.getMarkerVertices(i),
+            m_frame_correspondences.getMarkerWeights(i),
+            m_frame_correspondences.getMarkerVertexCount(i),
+            handPointPosition, handPointNormal);
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        MFloatPoint srcP(vPoint);
-        MFloatVector srcV(vNormal);
+        const double *target = m_frame_correspondences.getMarkerTarget(i);
 
-        pair<MFloatPoint, MFloatVector> rayPoint = make_pair(srcP, srcV);
+        MPoint p1(handPointPosition);
+        MPoint p2(target[0], target[1], target[2]);
 
-        handPoints.push_back(rayPoint);
+        double distance = p1.distanceTo(p2);
+        markerError += distance;
     }
 
-    return MS::kSuccess;
-}
+    // Step 4: Compute table and object intersection error
 
-MStatus FusedMotionEditContext::getMocapMarker(MString &mocapMarkerName,
-                                               MDagPath &mocapMarkerDag)
-{
-    MStatus status;
+    bool tableExists = m_table_transform_inv[3][3] != -1;
 
-    MSelectionList selectionList;
-    status = MGlobal::getSelectionListByName(mocapMarkerName, selectionList);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    const double *objectInverse = m_frame_correspondences.getObjectInverse();
 
-    MObject mocapMarker;
-    status = selectionList.getDependNode(0, mocapMarker);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (m_intersection_penalty_coefficient > 0.0 &&
+        (tableExists || objectInverse))
+    {
+        MPointArray handVertexPositions;
 
-    MFnDagNode mocapMarkerDagNode(mocapMarker, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+        status = fnHandMesh.getPoints(handVertexPositions, MSpace::kWorld);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = mocapMarkerDagNode.getPath(mocapMarkerDag);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+        int numVertices = handVertexPositions.length();
 
-    return MS::kSuccess;
-}
+        vector<double> xs(numVertices);
+        vector<double> ys(numVertices);
+        vector<double> zs(numVertices);
 
-MStatus
-FusedMotionEditContext::getOmissionIndicesAttribute(MString &contactGroupName,
-                                                    MIntArray &omissionIndices)
-{
-    MStatus status;
+        for (int i = 0; i < numVertices; i++)
+        {
+            MPoint queryPoint = handVertexPositions[i];
+
+            xs[i] = queryPoint.x;
+            ys[i] = queryPoint.y;
+            zs[i] = queryPoint.z;
+        }
+
+        if (tableExists)
+        {
+            double tableInverse[4][4];
+            double tableHalfDims[3] = {m_table_box_dims.x, m_table_box_dims.y,
+                                       m_table_box_dims.z};
+
+            status = m_table_transform_inv.get(tableInverse);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            BoxSDF tableSDF;
+            tableSDF.setBox(&tableInverse[0][0], tableHalfDims);
+
+            intersectionError += tableSDF.computePenetration(
+                xs.data(), ys.data(), zs.data(), numVertices, nullptr);
+        }
+
+        if (objectInverse)
+        {
+            intersectionError += m_object_sdf.computePenetration(
+                objectInverse, xs.data(), ys.data(), zs.data(), numVertices,
+                nullptr);
+        }
+    }
+
+    // Step 5: Compute total weighted errors
+
+    weightedMarkerError = m_marker_penalty_coefficient * markerError;
+    weightedContactError = m_contact_penalty_coefficient * contactError;
+    weightedIntersectionError =
+        m_intersection_penalty_coefficient * intersectionError;
+    weightedPriorError = m_prior_penalty_coefficient * priorError;
+
+    return MS::kSuccess;
+}
+
+// Shared settings only - correspondences and prior dofs are per frame
+MStatus FusedMotionEditContext::configureFrameObjective(FrameObjective &objective)
+{
+    MStatus status;
+
+    FusedSolveSettings settings;
+
+    status = getSolveSettings(settings);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    FrameRangeSolver::configureObjective(settings, m_object_sdf, objective);
+
+    return MS::kSuccess;
+}
+
+void FusedMotionEditContext::extrapolateDofSolution(
+    const vector<double> &lastDofs, const vector<double> &secondLastDofs,
+    vector<double> &x) const
+{
+    FrameRangeSolver::extrapolateDofs(lastDofs, secondLastDofs,
+                                      m_dof_lower_limits, m_dof_upper_limits,
+                                      x);
+}
+
+MStatus FusedMotionEditContext::generateHandTestPoints(
+    vector<pair<MFloatPoint, MFloatVector>> &handPoints)
+{
+    MStatus status;
+
+    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MPoint vPoint;
+    MVector vNormal;
+
+    handPoints.clear();
+
+    for (int i = 0; i < fnHandMesh.numVertices(); i++)
+    {
+        status = fnHandMesh.getPoint(i, vPoint, MSpace::kWorld);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = fnHandMesh.getVertexNormal(i, false, vNormal, MSpace::kWorld);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MFloatPoint srcP(vPoint);
+        MFloatVector srcV(vNormal);
+
+        pair<MFloatPoint, MFloatVector> rayPoint = make_pair(srcP, srcV);
+
+        handPoints.push_back(rayPoint);
+    }
+
+    return MS::kSuccess;
+}
+
+// Rotation limits are in radians. Unlimited sides come back as +-HUGE_VAL.
+MStatus FusedMotionEditContext::getJointRotationLimits(MFnIkJoint &fnJoint,
+                                                       int axis,
+                                                       double &lowerLimit,
+                                                       double &upperLimit)
+{
+    MStatus status;
+
+    const MFnTransform::LimitType minLimits[3] = {MFnTransform::kRotateMinX,
+                                                  MFnTransform::kRotateMinY,
+                                                  MFnTransform::kRotateMinZ};
+    const MFnTransform::LimitType maxLimits[3] = {MFnTransform::kRotateMaxX,
+                                                  MFnTransform::kRotateMaxY,
+                                                  MFnTransform::kRotateMaxZ};
+
+    lowerLimit = -HUGE_VAL;
+    upperLimit = HUGE_VAL;
+
+    if (fnJoint.isLimited(minLimits[axis], &status))
+    {
+        lowerLimit = fnJoint.limitValue(minLimits[axis], &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (fnJoint.isLimited(maxLimits[axis], &status))
+    {
+        upperLimit = fnJoint.limitValue(maxLimits[axis], &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::getMocapMarker(MString &mocapMarkerName,
+                                               MDagPath &mocapMarkerDag)
+{
+    MStatus status;
+
+    MSelectionList selectionList;
+    status = MGlobal::getSelectionListByName(mocapMarkerName, selectionList);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MObject mocapMarker;
+    status = selectionList.getDependNode(0, mocapMarker);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnDagNode mocapMarkerDagNode(mocapMarker, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mocapMarkerDagNode.getPath(mocapMarkerDag);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
+MStatus
+FusedMotionEditContext::getOmissionIndicesAttribute(MString &contactGroupName,
+                                                    MIntArray &omissionIndices)
+{
+    MStatus status;
 
     MSelectionList selectionList;
 
@@ -2120,6 +3474,45 @@ MStatus FusedMotionEditContext::getSetSerializedPointsAttribute(
     return MS::kSuccess;
 }
 
+MStatus FusedMotionEditContext::getSolveSettings(FusedSolveSettings &settings)
+{
+    MStatus status;
+
+    settings.contactDistanceCoefficient =
+        m_contact_distance_penalty_coefficient;
+    settings.contactNormalCoefficient = m_contact_normal_penalty_coefficient;
+    settings.markerCoefficient = m_marker_penalty_coefficient;
+    settings.contactCoefficient = m_contact_penalty_coefficient;
+    settings.intersectionCoefficient = m_intersection_penalty_coefficient;
+    settings.priorCoefficient = m_prior_penalty_coefficient;
+
+    settings.numIterations = m_num_opt_iterations;
+    settings.leastSquares = m_least_squares_enabled;
+    settings.warmStartChunkSize = m_warm_start_chunk_size;
+    settings.temporalWarmStart = m_temporal_warm_start_enabled;
+
+    settings.tableEnabled = m_table_transform_inv[3][3] != -1;
+
+    if (!settings.tableEnabled)
+    {
+        return MS::kSuccess;
+    }
+
+    double tableInverse[4][4];
+
+    status = m_table_transform_inv.get(tableInverse);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    copy(&tableInverse[0][0], &tableInverse[0][0] + MATRIX_SIZE,
+         settings.tableInverse);
+
+    settings.tableHalfDims[0] = m_table_box_dims.x;
+    settings.tableHalfDims[1] = m_table_box_dims.y;
+    settings.tableHalfDims[2] = m_table_box_dims.z;
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::initializeDofSolution()
 {
     MStatus status;
@@ -2178,6 +3571,39 @@ nlopt::opt FusedMotionEditContext::initializeOptimization()
     return opt;
 }
 
+// Scene mesh counterpart of the native FrameCorrespondences interpolation
+MStatus FusedMotionEditContext::interpolateHandPoint(
+    MFnMesh &fnHandMesh, const int *vertices, const double *weights,
+    int numVertices, MFloatPoint &position, MFloatVector &normal)
+{
+    MStatus status;
+
+    MPoint pointPosition = MPoint(0.0, 0.0, 0.0);
+    MVector pointNormal = MVector::zero;
+
+    for (int k = 0; k < numVertices; k++)
+    {
+        MPoint vPos;
+        status = fnHandMesh.getPoint(vertices[k], vPos, MSpace::kWorld);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MVector vNorm;
+        status = fnHandMesh.getVertexNormal(vertices[k], false, vNorm,
+                                            MSpace::kWorld);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        pointPosition += MVector(vPos) * weights[k];
+        pointNormal += vNorm * weights[k];
+    }
+
+    position = pointPosition;
+    normal = pointNormal;
+
+    normal.normalize();
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::interpolateSerializedPoint(
     MFnMesh &fnMesh, vector<int> &vertexIndices, vector<double> &coords,
     MFloatPoint &position, MFloatVector &normal)
@@ -2290,6 +3716,47 @@ MStatus FusedMotionEditContext::interpolateSerializedPoint(
     return MS::kSuccess;
 }
 
+// Records undo and keys every frame in one pass - poses are staged on the
+// joints and keyed in bulk, so time does not need to move
+MStatus FusedMotionEditContext::keyframeSolutions(
+    int frameStart, const vector<vector<double>> &priorDofs,
+    const vector<vector<double>> &solutions)
+{
+    MStatus status;
+
+    int numFrames = solutions.size();
+
+    m_keyframe_sink.clear();
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        MDoubleArray frameSolution(m_rig_n_dofs);
+
+        for (int i = 0; i < m_rig_n_dofs; i++)
+        {
+            frameSolution[i] = solutions[f][i];
+        }
+
+        m_undo_history.record(frameStart + f, priorDofs[f], solutions[f],
+                              true);
+
+        m_dof_vector = frameSolution;
+
+        status = loadDofSolutionFull();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_keyframe_sink.addFrame(frameStart + f, m_framerate);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        storeFrameSolution(frameStart + f);
+    }
+
+    status = m_keyframe_sink.commit();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
 MStatus FusedMotionEditContext::loadDofSolutionFull()
 {
     MStatus status;
@@ -2307,6 +3774,8 @@ MStatus FusedMotionEditContext::loadDofSolutionSingle(int index)
 {
     MStatus status;
 
+    TelemetryClock sceneStart = SolveTelemetry::now();
+
     double value = m_dof_vector[index];
     pair<int, int> indices = m_dof_vec_mappings.at(index);
 
@@ -2342,6 +3811,8 @@ MStatus FusedMotionEditContext::loadDofSolutionSingle(int index)
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    m_frame_telemetry.sceneTime += SolveTelemetry::secondsSince(sceneStart);
+
     return MS::kSuccess;
 }
 
@@ -2406,70 +3877,608 @@ MStatus FusedMotionEditContext::parseSerializedPoint(MFnMesh &fnMesh,
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::runOptimization(nlopt::opt &optim)
+MStatus FusedMotionEditContext::plotAccelerationErrors()
 {
     MStatus status;
 
-    MGlobal::displayInfo("Running optimization, please wait....");
+    MSelectionList selectionList;
 
-    double minf;
-    vector<double> x(m_rig_n_dofs);
+    status = MGlobal::getSelectionListByName(ACCELERATION_ERROR_LINES_GROUP,
+                                             selectionList);
 
-    for (int i = 0; i < m_rig_n_dofs; i++)
+    if (status == MS::kSuccess)
     {
-        x[i] = m_dof_vector[i];
+        MObject existingSplineGroup;
+        status = selectionList.getDependNode(0, existingSplineGroup);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = MGlobal::deleteNode(existingSplineGroup);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
-    try
-    {
-        m_last_dof_vectors.push(MDoubleArray(m_dof_vector));
+    MFnTransform fnTransform;
+    MObject splineGroup = fnTransform.create();
 
-        nlopt::result result = optim.optimize(x, minf);
+    MFnTransform fnSplineGroupTransform(splineGroup, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        for (int i = 0; i < m_rig_n_dofs; i++)
+    fnSplineGroupTransform.setName(ACCELERATION_ERROR_LINES_GROUP, false,
+                                   &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    int frameStart = m_frame_solutions.getFrameStart();
+    int frameEnd = m_frame_solutions.getFrameEnd();
+
+    for (int rigDofIndex = 0; rigDofIndex < m_frame_solutions.getNumDofs();
+         rigDofIndex++)
+    {
+        MPointArray controlPoints;
+
+        for (int frame = frameStart; frame <= frameEnd; frame++)
         {
-            m_dof_vector[i] = x[i];
+            double accelerationError =
+                m_frame_solutions.getAccelerationErrors(frame)[rigDofIndex];
+
+            status = controlPoints.append(MPoint(frame, accelerationError));
+            CHECK_MSTATUS_AND_RETURN_IT(status);
         }
 
-        status = loadDofSolutionFull();
+        MFnNurbsCurve fnSplineGenerator;
+
+        MObject splineDofCurve = fnSplineGenerator.createWithEditPoints(
+            controlPoints, 1, MFnNurbsCurve::kOpen, false, true, true,
+            splineGroup, &status);
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        string minfVal = to_string(minf);
-        MGlobal::displayInfo(MString("Completed. Found minimum at: ") +
-                             minfVal.c_str());
-    }
-    catch (exception &e)
-    {
-        MGlobal::displayInfo("NLOPT failed");
-        MGlobal::displayInfo(e.what());
+        MString splineName = ACCELERATION_ERROR_SPLINE_DOF_PREFIX + rigDofIndex;
+
+        fnSplineGenerator.setName(splineName, false, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    status = redrawAccelerationViolationCutoff(frameStart, frameEnd);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::setContactAttribute(
-    MString &contactGroupName, MStringArray &serializedContactPoints)
+// Initial guess for the current frame from the solutions of the two frames
+// before it. With only the previous frame solved, that solution is reused.
+bool FusedMotionEditContext::predictDofSolution(vector<double> &x) const
 {
-    MStatus status;
+    const vector<double> *lastDofs = nullptr;
+    const vector<double> *secondLastDofs = nullptr;
 
-    MSelectionList selectionList;
-    status = MGlobal::getSelectionListByName(contactGroupName, selectionList);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    for (const auto &entry : m_recent_solutions)
+    {
+        if (entry.first == m_frame - 1)
+        {
+            lastDofs = &entry.second;
+        }
+        else if (entry.first == m_frame - 2)
+        {
+            secondLastDofs = &entry.second;
+        }
+    }
 
-    MObject contactSet;
-    status = selectionList.getDependNode(0, contactSet);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (!lastDofs)
+    {
+        return false;
+    }
 
-    MFnSet fnContactSet(contactSet, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (!secondLastDofs)
+    {
+        x = *lastDofs;
+        return true;
+    }
 
-    bool hasAttribute =
-        fnContactSet.hasAttribute(CONTACT_POINTS_ATTRIBUTE, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    extrapolateDofSolution(*lastDofs, *secondLastDofs, x);
 
-    MObject attrObj;
+    return true;
+}
 
-    if (!hasAttribute)
+void FusedMotionEditContext::recordDofSolution(const vector<double> &x)
+{
+    // Re-solving a frame replaces its old solution
+    for (auto it = m_recent_solutions.begin(); it != m_recent_solutions.end();
+         it++)
+    {
+        if (it->first == m_frame)
+        {
+            m_recent_solutions.erase(it);
+            break;
+        }
+    }
+
+    m_recent_solutions.emplace_back(m_frame, x);
+
+    if (m_recent_solutions.size() > 2)
+    {
+        m_recent_solutions.pop_front();
+    }
+}
+
+// Windows of consecutive frames around each violation are solved jointly.
+// Overlapping windows merge into spans, which a window slides through so
+// that each window starts against the solution of the one before it.
+MStatus FusedMotionEditContext::resolveViolationWindows(int frameStart,
+                                                        int frameEnd)
+{
+    MStatus status;
+
+    int halfWindow = m_space_time_window_size / 2;
+
+    vector<pair<int, int>> spans;
+
+    for (const auto &entry : m_acceleration_violations)
+    {
+        int spanStart = max(frameStart, entry.first - halfWindow);
+        int spanEnd = min(frameEnd, entry.first + halfWindow);
+
+        if (!spans.empty() && spanStart <= spans.back().second + 1)
+        {
+            spans.back().second = max(spans.back().second, spanEnd);
+        }
+        else
+        {
+            spans.push_back(make_pair(spanStart, spanEnd));
+        }
+    }
+
+    // Windows slide by half their size, so frames at the edge of one window
+    // are solved again inside the next, coupled to frames on both sides
+    int windowStride = max(m_space_time_window_size / 2, 1);
+
+    MAnimControl animCtrl;
+
+    for (const auto &span : spans)
+    {
+        // Wiped keys are interpolated and become the prior. They are baked
+        // up front, so keying one window does not move the next one's prior.
+        m_keyframe_sink.clear();
+
+        for (int frame = span.first; frame <= span.second; frame++)
+        {
+            MTime newFrame((double)frame, m_framerate);
+
+            status = animCtrl.setCurrentTime(newFrame);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            status = m_keyframe_sink.addFrame(frame, m_framerate);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+
+        status = m_keyframe_sink.commit();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        for (int windowStart = span.first;; windowStart += windowStride)
+        {
+            int windowEnd =
+                min(windowStart + m_space_time_window_size - 1, span.second);
+
+            status = solveSpaceTimeWindow(windowStart, windowEnd);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            if (windowEnd >= span.second)
+            {
+                break;
+            }
+        }
+    }
+
+    return MS::kSuccess;
+}
+
+// Puts back the dofs the run changed on top of the frame's current pose, and
+// rewrites the frame's keys if the run had keyed it
+MStatus FusedMotionEditContext::restoreDofDelta(const DofDelta &delta)
+{
+    MStatus status;
+
+    if (delta.frame != m_frame)
+    {
+        status = jumpToFrame(delta.frame, true);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    status = initializeDofSolution();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    for (int i = 0; i < delta.dofIndices.size(); i++)
+    {
+        m_dof_vector[delta.dofIndices[i]] = delta.dofValues[i];
+    }
+
+    m_recent_solutions.clear();
+
+    status = loadDofSolutionFull();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    if (delta.keyed)
+    {
+        m_keyframe_sink.clear();
+
+        status = m_keyframe_sink.addFrame(delta.frame, m_framerate);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_keyframe_sink.commit();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        storeFrameSolution(delta.frame);
+    }
+
+    status = redrawContactVisualizations();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = redrawMarkerVisualizations();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::runOptimization(nlopt::opt &optim)
+{
+    MStatus status;
+
+    MGlobal::displayInfo("Running optimization, please wait....");
+
+    // Contacts or marker pairings may have been edited since the last run
+    m_correspondence_frame = -1;
+    m_solve_undo_sequence = -1;
+
+    double minf;
+    vector<double> x(m_rig_n_dofs);
+    vector<double> priorDofs(m_rig_n_dofs);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        x[i] = m_dof_vector[i];
+        priorDofs[i] = m_dof_vector[i];
+    }
+
+    // Only the start point moves - m_dof_vector stays the prior
+    if (m_temporal_warm_start_enabled && predictDofSolution(x))
+    {
+        MGlobal::displayInfo("Warm starting from previous frames");
+    }
+
+    // Least squares needs the native Jacobian
+    bool leastSquares = m_least_squares_enabled && !m_hand_skinning.isEmpty();
+
+    // Threads need the native objective and gradient
+    bool multiStart = m_num_restarts > 0 && !m_hand_skinning.isEmpty() &&
+                      !m_reference_gradient_enabled;
+
+    m_num_solver_iterations = 0;
+
+    m_frame_telemetry = FrameTelemetry();
+    m_frame_telemetry.frame = m_frame;
+    m_frame_objective.resetTelemetry();
+
+    m_progress_snapshot.reset();
+
+    TelemetryClock solveStart = SolveTelemetry::now();
+
+    try
+    {
+        if (multiStart)
+        {
+            status = runMultiStart(x, minf);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+        else if (leastSquares)
+        {
+            status = runLeastSquares(x, minf);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            // Evaluations go straight to the native objective
+            const FrameTelemetry &objectiveTelemetry =
+                m_frame_objective.getTelemetry();
+
+            m_frame_telemetry.numObjectiveEvaluations =
+                objectiveTelemetry.numObjectiveEvaluations;
+            m_frame_telemetry.numGradientEvaluations =
+                objectiveTelemetry.numGradientEvaluations;
+        }
+        else
+        {
+            nlopt::result result = optim.optimize(x, minf);
+
+            m_num_solver_iterations = m_frame_telemetry.numObjectiveEvaluations;
+            m_frame_telemetry.resultCode = result;
+        }
+
+        m_frame_telemetry.finalObjective = minf;
+
+        recordDofSolution(x);
+
+        m_solve_undo_sequence =
+            m_undo_history.record(m_frame, priorDofs, x, false);
+
+        for (int i = 0; i < m_rig_n_dofs; i++)
+        {
+            m_dof_vector[i] = x[i];
+        }
+
+        status = loadDofSolutionFull();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        string minfVal = to_string(minf);
+        MGlobal::displayInfo(MString("Completed. Found minimum at: ") +
+                             minfVal.c_str());
+
+        MGlobal::displayInfo(
+            "Frame " + MString(to_string(m_frame).c_str()) + ": " +
+            MString(to_string(m_num_solver_iterations).c_str()) +
+            " iterations");
+    }
+    catch (exception &e)
+    {
+        MGlobal::displayInfo("NLOPT failed");
+        MGlobal::displayInfo(e.what());
+
+        // Only the sequential path leaves its state in optim
+        if (multiStart || leastSquares)
+        {
+            m_frame_telemetry.resultCode = nlopt::FAILURE;
+            m_frame_telemetry.finalObjective =
+                numeric_limits<double>::quiet_NaN();
+        }
+        else
+        {
+            m_frame_telemetry.resultCode = optim.last_optimize_result();
+            m_frame_telemetry.finalObjective = optim.last_optimum_value();
+        }
+    }
+
+    m_frame_telemetry.solveTime = SolveTelemetry::secondsSince(solveStart);
+    m_frame_telemetry.addTermTimes(m_frame_objective.getTelemetry());
+
+    m_telemetry.addFrame(m_frame_telemetry);
+
+    return MS::kSuccess;
+}
+
+// Starts from x. The current dofs are the prior.
+MStatus FusedMotionEditContext::runLeastSquares(vector<double> &x,
+                                                double &minf)
+{
+    MStatus status;
+
+    status = compileFrameCorrespondences();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = configureFrameObjective(m_frame_objective);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    vector<double> priorDofs(m_rig_n_dofs);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        priorDofs[i] = m_dof_vector[i];
+    }
+
+    m_frame_objective.setCorrespondences(&m_frame_correspondences);
+    m_frame_objective.setPriorDofs(priorDofs);
+
+    LevenbergMarquardt solver(m_frame_objective);
+    solver.setMaxIterations(m_num_opt_iterations);
+
+    m_num_solver_iterations = solver.solve(x, minf);
+
+    m_frame_telemetry.resultCode = solver.getResult();
+
+    return MS::kSuccess;
+}
+
+// Solves from x and from m_num_restarts perturbations of it concurrently,
+// and keeps the lowest objective. Perturbations are drawn on this thread so
+// that runs are reproducible. The current dofs are the prior.
+MStatus FusedMotionEditContext::runMultiStart(vector<double> &x, double &minf)
+{
+    MStatus status;
+
+    status = compileFrameCorrespondences();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    vector<double> priorDofs(m_rig_n_dofs);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        priorDofs[i] = m_dof_vector[i];
+    }
+
+    // Step 1: Starting points. Root dofs are kept, the rest are drawn within
+    // the joint limits around the start.
+
+    int numStarts = m_num_restarts + 1;
+
+    vector<vector<double>> starts(numStarts, x);
+
+    for (int s = 1; s < numStarts; s++)
+    {
+        for (int i = 6; i < m_rig_n_dofs; i++)
+        {
+            double lower =
+                max(m_dof_lower_limits[i], x[i] - MULTI_START_PERTURBATION);
+            double upper =
+                min(m_dof_upper_limits[i], x[i] + MULTI_START_PERTURBATION);
+
+            if (lower < upper)
+            {
+                uniform_real_distribution<double> distribution(lower, upper);
+                starts[s][i] = distribution(m_rng);
+            }
+        }
+    }
+
+    // Step 2: Per-thread objectives and optimizers, as in parallel solves
+
+    TaskPool pool(min(max(m_num_solver_threads, 1), numStarts));
+    int numThreads = pool.getNumThreads();
+
+    vector<FrameObjective> objectives;
+    objectives.reserve(numThreads);
+
+    vector<nlopt::opt> optimizers;
+    optimizers.reserve(numThreads);
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        objectives.emplace_back(m_hand_kinematics, m_hand_skinning);
+
+        status = configureFrameObjective(objectives[t]);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        objectives[t].setCorrespondences(&m_frame_correspondences);
+        objectives[t].setPriorDofs(priorDofs);
+    }
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        optimizers.emplace_back(nlopt::LD_MMA, m_rig_n_dofs);
+        optimizers[t].set_min_objective(&FrameObjective::optimizerWrapper,
+                                        (void *)&objectives[t]);
+
+        optimizers[t].set_xtol_rel(1e-4);
+        optimizers[t].set_maxeval(m_num_opt_iterations);
+    }
+
+    // Step 3: Solve. The unperturbed start always runs, the others only
+    // start while the time budget lasts.
+
+    vector<double> startObjectives(numStarts, HUGE_VAL);
+    vector<int> startResults(numStarts, 0);
+    vector<int> startIterations(numStarts, 0);
+
+    TelemetryClock multiStartBegin = SolveTelemetry::now();
+
+    pool.run(numStarts,
+             [&](int worker, int s)
+             {
+                 double elapsed = SolveTelemetry::secondsSince(multiStartBegin);
+
+                 if (s > 0 && m_restart_time_budget > 0.0 &&
+                     elapsed >= m_restart_time_budget)
+                 {
+                     return;
+                 }
+
+                 FrameObjective &objective = objectives[worker];
+                 nlopt::opt &optim = optimizers[worker];
+
+                 double startMinf = HUGE_VAL;
+
+                 try
+                 {
+                     if (m_least_squares_enabled)
+                     {
+                         LevenbergMarquardt solver(objective);
+                         solver.setMaxIterations(m_num_opt_iterations);
+
+                         startIterations[s] =
+                             solver.solve(starts[s], startMinf);
+                         startResults[s] = solver.getResult();
+                     }
+                     else
+                     {
+                         int evaluationsBefore =
+                             objective.getTelemetry().numObjectiveEvaluations;
+
+                         if (m_restart_time_budget > 0.0)
+                         {
+                             optim.set_maxtime(
+                                 max(m_restart_time_budget - elapsed, 1e-3));
+                         }
+
+                         startResults[s] = optim.optimize(starts[s], startMinf);
+                         startIterations[s] =
+                             objective.getTelemetry().numObjectiveEvaluations -
+                             evaluationsBefore;
+                     }
+
+                     startObjectives[s] = startMinf;
+                 }
+                 catch (exception &)
+                 {
+                     // Failed starts are never picked. Only MMA leaves its
+                     // result in optim.
+                     startResults[s] = m_least_squares_enabled
+                                           ? nlopt::FAILURE
+                                           : optim.last_optimize_result();
+                 }
+             });
+
+    int bestStart = -1;
+    int numSolved = 0;
+
+    for (int s = 0; s < numStarts; s++)
+    {
+        if (startObjectives[s] < HUGE_VAL)
+        {
+            numSolved++;
+
+            if (bestStart < 0 ||
+                startObjectives[s] < startObjectives[bestStart])
+            {
+                bestStart = s;
+            }
+        }
+    }
+
+    for (int t = 0; t < numThreads; t++)
+    {
+        const FrameTelemetry &objectiveTelemetry = objectives[t].getTelemetry();
+
+        m_frame_telemetry.numObjectiveEvaluations +=
+            objectiveTelemetry.numObjectiveEvaluations;
+        m_frame_telemetry.numGradientEvaluations +=
+            objectiveTelemetry.numGradientEvaluations;
+        m_frame_telemetry.addTermTimes(objectiveTelemetry);
+    }
+
+    if (bestStart < 0)
+    {
+        throw runtime_error("Every multi-start solve failed");
+    }
+
+    MGlobal::displayInfo(
+        "Multi-start: " + MString(to_string(numSolved).c_str()) + " of " +
+        MString(to_string(numStarts).c_str()) + " starts solved, best was " +
+        MString(to_string(bestStart).c_str()));
+
+    x = starts[bestStart];
+    minf = startObjectives[bestStart];
+
+    m_num_solver_iterations = startIterations[bestStart];
+    m_frame_telemetry.resultCode = startResults[bestStart];
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setContactAttribute(
+    MString &contactGroupName, MStringArray &serializedContactPoints)
+{
+    MStatus status;
+
+    MSelectionList selectionList;
+    status = MGlobal::getSelectionListByName(contactGroupName, selectionList);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MObject contactSet;
+    status = selectionList.getDependNode(0, contactSet);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MFnSet fnContactSet(contactSet, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    bool hasAttribute =
+        fnContactSet.hasAttribute(CONTACT_POINTS_ATTRIBUTE, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MObject attrObj;
+
+    if (!hasAttribute)
     {
         MGlobal::displayInfo(CONTACT_POINTS_ATTRIBUTE +
                              " attribute not found for group " +
@@ -2484,86 +4493,309 @@ MStatus FusedMotionEditContext::setContactAttribute(
 
     MPlug attributePlug(contactSet, attrObj);
 
-    MFnStringArrayData fnStringArrayData;
+    MFnStringArrayData fnStringArrayData;
+
+    MObject stringArrayData =
+        fnStringArrayData.create(serializedContactPoints, &status);
+
+    status = attributePlug.setMObject(stringArrayData);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::setSerializedViolationsAttribute(
+    MStringArray &serializedFrameViolations)
+{
+    MStatus status;
+
+    MSelectionList selectionList;
+
+    MObject setObject;
+
+    status = MGlobal::getSelectionListByName(ACCELERATION_ERROR_STORAGE_GROUP,
+                                             selectionList);
+
+    if (status != MS::kSuccess)
+    {
+        MFnSet storageGroupGenerator;
+
+        setObject = storageGroupGenerator.create(
+            selectionList, MFnSet::Restriction::kNone, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MFnDependencyNode fnDepNode(setObject, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        fnDepNode.setName(ACCELERATION_ERROR_STORAGE_GROUP, false, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+    else
+    {
+        status = selectionList.getDependNode(0, setObject);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    MFnDependencyNode fnDepNode(setObject, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    bool hasAttribute =
+        fnDepNode.hasAttribute(ACCELERATION_ERROR_STORAGE_ATTRIBUTE, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    MObject attrObj;
+
+    if (!hasAttribute)
+    {
+        MFnTypedAttribute fnTypedAttr;
+
+        attrObj = fnTypedAttr.create(ACCELERATION_ERROR_STORAGE_ATTRIBUTE,
+                                     ACCELERATION_ERROR_STORAGE_ATTRIBUTE,
+                                     MFnData::kStringArray, MObject::kNullObj,
+                                     &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = fnDepNode.addAttribute(attrObj);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+    else
+    {
+        attrObj =
+            fnDepNode.attribute(ACCELERATION_ERROR_STORAGE_ATTRIBUTE, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    MPlug attributePlug(setObject, attrObj);
+
+    MFnStringArrayData fnStringArrayData;
+
+    MObject stringArrayData =
+        fnStringArrayData.create(serializedFrameViolations, &status);
+
+    status = attributePlug.setMObject(stringArrayData);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
+// Jumps through the range and resolves the correspondences and keyed dofs of
+// every frame. A frame's scene time is the time taken to snapshot it.
+MStatus FusedMotionEditContext::snapshotFrameRange(
+    int frameStart, int frameEnd, vector<FrameCorrespondences> &correspondences,
+    vector<vector<double>> &frameDofs, vector<FrameTelemetry> &frameTelemetry)
+{
+    MStatus status;
+
+    int numFrames = max(frameEnd - frameStart + 1, 0);
+
+    correspondences.assign(numFrames, FrameCorrespondences());
+    frameDofs.assign(numFrames, vector<double>(m_rig_n_dofs, 0.0));
+    frameTelemetry.assign(numFrames, FrameTelemetry());
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        TelemetryClock sceneStart = SolveTelemetry::now();
+
+        status = jumpToFrame(frameStart + i, true);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = initializeDofSolution();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = compileFrameCorrespondences();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        correspondences[i] = m_frame_correspondences;
+
+        for (int j = 0; j < m_rig_n_dofs; j++)
+        {
+            frameDofs[i][j] = m_dof_vector[j];
+        }
+
+        frameTelemetry[i].sceneTime = SolveTelemetry::secondsSince(sceneStart);
+    }
+
+    return MS::kSuccess;
+}
+
+// Snapshots every frame on the main thread, solves them natively on a
+// thread pool and only then writes the results back to the scene
+MStatus FusedMotionEditContext::solveFramesParallel(int frameStart,
+                                                    int frameEnd)
+{
+    MStatus status;
+
+    int numFrames = frameEnd - frameStart + 1;
+
+    if (numFrames <= 0)
+    {
+        return MS::kSuccess;
+    }
+
+    // Step 1: Snapshot the frame inputs - contacts and markers already carry
+    // the object and mocap positions of their frame
+
+    vector<FrameCorrespondences> frameCorrespondences;
+    vector<vector<double>> frameDofs;
+    vector<FrameTelemetry> frameTelemetry;
+
+    status = snapshotFrameRange(frameStart, frameEnd, frameCorrespondences,
+                                frameDofs, frameTelemetry);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    // Step 2: Solve natively, the same way fused_solve does
+
+    FusedSolveSettings settings;
+
+    status = getSolveSettings(settings);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    FrameRangeSolver solver(m_hand_kinematics, m_hand_skinning, m_object_sdf);
+    solver.setSettings(settings);
+    solver.setDofLimits(m_dof_lower_limits, m_dof_upper_limits);
+
+    MGlobal::displayInfo("Solving " + MString(to_string(numFrames).c_str()) +
+                         " frames on " +
+                         MString(to_string(m_num_solver_threads).c_str()) +
+                         " threads, please wait....");
+
+    vector<vector<double>> frameSolutions;
+    vector<int> frameIterations;
+
+    int numFailures = solver.solve(m_num_solver_threads, frameStart,
+                                   frameCorrespondences, frameDofs,
+                                   frameSolutions, frameTelemetry,
+                                   frameIterations);
+
+    int totalIterations = 0;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        totalIterations += frameIterations[i];
+
+        m_telemetry.addFrame(frameTelemetry[i]);
+
+        MGlobal::displayInfo(
+            "Frame " + MString(to_string(frameStart + i).c_str()) + ": " +
+            MString(to_string(frameIterations[i]).c_str()) + " iterations");
+    }
+
+    MGlobal::displayInfo(
+        "Mean iterations per frame: " +
+        MString(to_string((double)totalIterations / numFrames).c_str()));
+
+    if (numFailures > 0)
+    {
+        MGlobal::displayInfo("NLOPT failed on " +
+                             MString(to_string(numFailures).c_str()) +
+                             " frames - inputs kept");
+    }
 
-    MObject stringArrayData =
-        fnStringArrayData.create(serializedContactPoints, &status);
+    // Step 3: Commit everything to the scene in one pass
 
-    status = attributePlug.setMObject(stringArrayData);
+    status = keyframeSolutions(frameStart, frameDofs, frameSolutions);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
     return MS::kSuccess;
 }
 
-MStatus FusedMotionEditContext::setSerializedViolationsAttribute(
-    MStringArray &serializedFrameViolations)
+MStatus FusedMotionEditContext::solveSpaceTimeWindow(int windowStart,
+                                                     int windowEnd)
 {
     MStatus status;
 
-    MSelectionList selectionList;
+    int numFrames = windowEnd - windowStart + 1;
 
-    MObject setObject;
+    if (numFrames <= 0)
+    {
+        return MS::kSuccess;
+    }
 
-    status = MGlobal::getSelectionListByName(ACCELERATION_ERROR_STORAGE_GROUP,
-                                             selectionList);
+    // Contacts or marker pairings may have been edited since the last run
+    m_correspondence_frame = -1;
 
-    if (status != MS::kSuccess)
-    {
-        MFnSet storageGroupGenerator;
+    // Step 1: Snapshot the window frames and the fixed frames around it
 
-        setObject = storageGroupGenerator.create(
-            selectionList, MFnSet::Restriction::kNone, &status);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    vector<FrameCorrespondences> frameCorrespondences(numFrames);
+    vector<vector<double>> priorDofs(numFrames);
+    vector<vector<double>> leadingDofs(SPACE_TIME_BOUNDARY_FRAMES);
+    vector<vector<double>> trailingDofs(SPACE_TIME_BOUNDARY_FRAMES);
 
-        MFnDependencyNode fnDepNode(setObject, &status);
+    for (int frame = windowStart - SPACE_TIME_BOUNDARY_FRAMES;
+         frame <= windowEnd + SPACE_TIME_BOUNDARY_FRAMES; frame++)
+    {
+        status = jumpToFrame(frame, true);
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        fnDepNode.setName(ACCELERATION_ERROR_STORAGE_GROUP, false, &status);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-    }
-    else
-    {
-        status = selectionList.getDependNode(0, setObject);
+        status = initializeDofSolution();
         CHECK_MSTATUS_AND_RETURN_IT(status);
-    }
 
-    MFnDependencyNode fnDepNode(setObject, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+        vector<double> frameDofs(m_rig_n_dofs);
 
-    bool hasAttribute =
-        fnDepNode.hasAttribute(ACCELERATION_ERROR_STORAGE_ATTRIBUTE, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+        for (int i = 0; i < m_rig_n_dofs; i++)
+        {
+            frameDofs[i] = m_dof_vector[i];
+        }
 
-    MObject attrObj;
+        if (frame < windowStart)
+        {
+            leadingDofs[frame - windowStart + SPACE_TIME_BOUNDARY_FRAMES] =
+                frameDofs;
+        }
+        else if (frame > windowEnd)
+        {
+            trailingDofs[frame - windowEnd - 1] = frameDofs;
+        }
+        else
+        {
+            status = compileFrameCorrespondences();
+            CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    if (!hasAttribute)
-    {
-        MFnTypedAttribute fnTypedAttr;
+            frameCorrespondences[frame - windowStart] = m_frame_correspondences;
+            priorDofs[frame - windowStart] = frameDofs;
+        }
+    }
 
-        attrObj = fnTypedAttr.create(ACCELERATION_ERROR_STORAGE_ATTRIBUTE,
-                                     ACCELERATION_ERROR_STORAGE_ATTRIBUTE,
-                                     MFnData::kStringArray, MObject::kNullObj,
-                                     &status);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+    // Step 2: Solve. Accelerations are scaled like the violation metric
+    // (degrees per second squared for rotations) and by the epsilon, so a
+    // dof at the threshold costs half the coefficient.
 
-        status = fnDepNode.addAttribute(attrObj);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-    }
-    else
+    vector<double> accelerationScales(m_rig_n_dofs);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
     {
-        attrObj =
-            fnDepNode.attribute(ACCELERATION_ERROR_STORAGE_ATTRIBUTE, &status);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+        int jointDofIndex = m_dof_vec_mappings[i].second;
+
+        double unitScale = (jointDofIndex < 3) ? 180.0 / M_PI : 1.0;
+
+        accelerationScales[i] =
+            unitScale / (m_realtime_delta * m_acceleration_epsilon);
     }
 
-    MPlug attributePlug(setObject, attrObj);
+    status = configureFrameObjective(m_frame_objective);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    MFnStringArrayData fnStringArrayData;
+    SpaceTimeSolver solver(m_frame_objective);
+    solver.setAccelerationCoefficient(m_acceleration_penalty_coefficient);
+    solver.setAccelerationScales(accelerationScales);
+    solver.setBoundary(leadingDofs, trailingDofs);
+    solver.setFrames(frameCorrespondences, priorDofs);
+    solver.setMaxIterations(m_num_opt_iterations);
 
-    MObject stringArrayData =
-        fnStringArrayData.create(serializedFrameViolations, &status);
+    vector<vector<double>> windowDofs = priorDofs;
+    double minf;
 
-    status = attributePlug.setMObject(stringArrayData);
+    int iterations = solver.solve(windowDofs, minf);
+
+    MGlobal::displayInfo(
+        "Frames " + MString(to_string(windowStart).c_str()) + "-" +
+        MString(to_string(windowEnd).c_str()) + ": " +
+        MString(to_string(iterations).c_str()) + " iterations, minimum " +
+        MString(to_string(minf).c_str()));
+
+    // Step 3: Key the whole window in one pass
+
+    status = keyframeSolutions(windowStart, priorDofs, windowDofs);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
     return MS::kSuccess;
@@ -2576,9 +4808,26 @@ MStatus FusedMotionEditContext::storeExistingFrameSolutions(int frameStart,
 
     MAnimControl animCtrl;
 
-    m_existing_frame_solutions.clear();
+    m_frame_solutions.reset(frameStart, frameEnd, m_rig_n_dofs);
 
-    for (int frame = frameStart; frame <= frameEnd; frame++)
+    // Via finite acceleration metric, with rotations in degrees for better
+    // scale consistency
+    vector<double> dofScales(m_rig_n_dofs);
+
+    for (int rigDofIndex = 0; rigDofIndex < m_rig_n_dofs; rigDofIndex++)
+    {
+        pair<int, int> indices = m_dof_vec_mappings.at(rigDofIndex);
+        int jointDofIndex = indices.second;
+
+        double unitScale = (jointDofIndex < 3) ? 180.0 / M_PI : 1.0;
+
+        dofScales[rigDofIndex] = unitScale / m_realtime_delta;
+    }
+
+    m_frame_solutions.setDofScales(dofScales);
+
+    // Include the frames either side in case of using somewhere in middle
+    for (int frame = frameStart - 1; frame <= frameEnd + 1; frame++)
     {
         MTime newFrame((double)frame, m_framerate);
         status = animCtrl.setCurrentTime(newFrame);
@@ -2587,31 +4836,86 @@ MStatus FusedMotionEditContext::storeExistingFrameSolutions(int frameStart,
         status = initializeDofSolution();
         CHECK_MSTATUS_AND_RETURN_IT(status);
 
-        m_existing_frame_solutions[frame] = MDoubleArray(m_dof_vector);
+        storeFrameSolution(frame);
+    }
+
+    return MS::kSuccess;
+}
+
+// Copies the current dof vector into the stored solutions, if in range
+void FusedMotionEditContext::storeFrameSolution(int frame)
+{
+    double *frameDofs = m_frame_solutions.editFrame(frame);
+
+    if (frameDofs == nullptr)
+    {
+        return;
+    }
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        frameDofs[i] = m_dof_vector[i];
     }
+}
+
+// Only frames next to solutions stored since the last update are recomputed
+MStatus FusedMotionEditContext::updateAccelerationErrors()
+{
+    MStatus status;
+
+    vector<int> updatedFrames;
+
+    m_frame_solutions.updateAccelerationErrors(updatedFrames);
 
-    // Add extras in case of using somewhere in middle
+    status = updateAccelerationViolations(updatedFrames);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
 
-    int endFrame = frameEnd;
-    int startPriorFrame = frameStart - 1;
-    int postEndFrame = frameEnd + 1;
+MStatus
+FusedMotionEditContext::updateAccelerationViolations(const vector<int> &frames)
+{
+    MStatus status;
 
-    int extraFrameIndices[3] = {endFrame, startPriorFrame, postEndFrame};
+    vector<int> violationIndices;
 
-    for (int extraFrameIndex = 0; extraFrameIndex < 3; extraFrameIndex++)
+    for (int frame : frames)
     {
-        int extraFrame = extraFrameIndices[extraFrameIndex];
+        m_acceleration_violations.erase(frame);
 
-        MTime newFrame((double)extraFrame, m_framerate);
-        status = animCtrl.setCurrentTime(newFrame);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+        int numViolations = m_frame_solutions.findViolations(
+            frame, m_acceleration_epsilon, violationIndices);
 
-        status = initializeDofSolution();
-        CHECK_MSTATUS_AND_RETURN_IT(status);
+        if (numViolations == 0)
+        {
+            continue;
+        }
+
+        MIntArray frameViolations(numViolations);
+
+        for (int i = 0; i < numViolations; i++)
+        {
+            frameViolations[i] = violationIndices[i];
+        }
+
+        m_acceleration_violations[frame] = frameViolations;
+    }
 
-        m_existing_frame_solutions[extraFrame] = MDoubleArray(m_dof_vector);
+    return MS::kSuccess;
+}
+
+MStatus FusedMotionEditContext::updateHandPose()
+{
+    vector<double> dofs(m_rig_n_dofs);
+
+    for (int i = 0; i < m_rig_n_dofs; i++)
+    {
+        dofs[i] = m_dof_vector[i];
     }
 
+    m_hand_kinematics.computePose(dofs, m_hand_pose);
+
     return MS::kSuccess;
 }
 
@@ -2750,165 +5054,144 @@ double FusedMotionEditContext::computeDofGradient(
 
     double initVal = m_dof_vector[dofVectorIndex];
 
+    // The native skinning evaluates straight from the dof vector
+    bool sceneEvaluation = m_hand_skinning.isEmpty();
+
     m_dof_vector[dofVectorIndex] += step;
 
-    status = loadDofSolutionSingle(dofVectorIndex);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (sceneEvaluation)
+    {
+        status = loadDofSolutionSingle(dofVectorIndex);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
 
     double forwardObjective = computeObjective(existingDofs, true);
     double JthetaDof = (forwardObjective - currentObjectiveValue) / step;
 
     m_dof_vector[dofVectorIndex] = initVal;
 
-    status = loadDofSolutionSingle(dofVectorIndex);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (sceneEvaluation)
+    {
+        status = loadDofSolutionSingle(dofVectorIndex);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
 
     return JthetaDof;
 }
 
+// Native evaluations also fill grad when one is given, in the same pass
 double
 FusedMotionEditContext::computeObjective(const MDoubleArray &existingDofs,
-                                         bool suppressVisualization)
+                                         bool suppressVisualization,
+                                         vector<double> *grad)
 {
     MStatus status;
 
     bool visualizationEnabled =
         !suppressVisualization && m_optimization_visualization_enabled;
 
-    double contactDistanceError = 0.0;
-    double contactNormalError = 0.0;
-
-    double contactError = 0.0;
-    double markerError = 0.0;
-    double intersectionError = 0.0;
-    double priorError = 0.0;
+    double weightedMarkerError = 0.0;
+    double weightedContactError = 0.0;
+    double weightedIntersectionError = 0.0;
+    double weightedPriorError = 0.0;
 
-    MFnMesh fnHandMesh(m_hand_geometry, &status);
+    status = compileFrameCorrespondences();
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    MFnMesh fnObjectMesh(m_object_geometry, &status);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (m_hand_skinning.isEmpty())
+    {
+        TelemetryClock sceneStart = SolveTelemetry::now();
 
-    // Step 1: Load new candidate and compute prior error
+        status = computeSceneObjectiveErrors(
+            existingDofs, weightedMarkerError, weightedContactError,
+            weightedIntersectionError, weightedPriorError);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    for (int i = 0; i < m_rig_n_dofs; i++)
-    {
-        // Do not include base movement in prior error
-        if (i > 5)
-        {
-            priorError += abs(existingDofs[i] - m_dof_vector[i]);
-        }
+        m_frame_telemetry.sceneTime += SolveTelemetry::secondsSince(sceneStart);
     }
-
-    // To visualize progress
-    if (visualizationEnabled)
+    else
     {
-        m_view.refresh(false, true);
-    }
-
-    // Step 2: Compute contact point-to-point distance and normal error
-
-    vector<MPointArray> pairedPointLocations;
-    vector<MVectorArray> pairedPointNormals;
+        status = configureFrameObjective(m_frame_objective);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status =
-        getPairedFrameContactPoints(pairedPointLocations, pairedPointNormals);
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+        vector<double> priorDofs(m_rig_n_dofs);
+        vector<double> dofs(m_rig_n_dofs);
+        vector<double> noGrad;
 
-    int numContactPoints = pairedPointLocations.size();
+        for (int i = 0; i < m_rig_n_dofs; i++)
+        {
+            priorDofs[i] = existingDofs[i];
+            dofs[i] = m_dof_vector[i];
+        }
 
-    for (int i = 0; i < numContactPoints; i++)
-    {
-        MPointArray locationPair = pairedPointLocations[i];
-        MVectorArray normalPair = pairedPointNormals[i];
+        m_frame_objective.setCorrespondences(&m_frame_correspondences);
+        m_frame_objective.setPriorDofs(priorDofs);
 
-        MPoint objectPoint = locationPair[0];
-        MVector objectNormal = normalPair[0];
+        m_frame_objective.computeObjective(dofs, grad ? *grad : noGrad);
 
-        MPoint handPoint = locationPair[1];
-        MVector handNormal = normalPair[1];
+        m_frame_objective.getWeightedErrors(
+            weightedMarkerError, weightedContactError,
+            weightedIntersectionError, weightedPriorError);
+    }
 
-        // Distance error
+    double objValue = weightedMarkerError + weightedContactError +
+                      weightedIntersectionError + weightedPriorError;
 
-        double distance = objectPoint.distanceTo(handPoint);
-        contactDistanceError += distance;
+    // Drawn at a fixed rate by computeOptimization, not per evaluation
+    if (visualizationEnabled)
+    {
+        vector<double> dofs(m_rig_n_dofs);
 
-        // Normal error
+        for (int i = 0; i < m_rig_n_dofs; i++)
+        {
+            dofs[i] = m_dof_vector[i];
+        }
 
-        double normalAntiAlignment = 1 + (objectNormal * handNormal);
-        contactNormalError += normalAntiAlignment;
+        m_progress_snapshot.publish(dofs, weightedMarkerError,
+                                    weightedContactError,
+                                    weightedIntersectionError,
+                                    weightedPriorError);
     }
 
-    double weightedContactDistanceError =
-        m_contact_distance_penalty_coefficient * contactDistanceError;
-    double weightedContactNormalError =
-        m_contact_normal_penalty_coefficient * contactNormalError;
-
-    contactError = weightedContactDistanceError + weightedContactNormalError;
+    return objValue;
+}
 
-    // Step 3: Compute marker point-to-marker distance error
+// Analytic, or exact by dual numbers for reference
+MStatus
+FusedMotionEditContext::computeObjectiveGradient(const MDoubleArray &existingDofs,
+                                                 vector<double> &grad,
+                                                 bool dualNumbers)
+{
+    MStatus status;
 
-    vector<MPointArray> pointLocations;
+    status = compileFrameCorrespondences();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    status = computePairedMarkerPatchLocations(pointLocations);
+    status = configureFrameObjective(m_frame_objective);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
-    int numMarkerPoints = pointLocations.size();
+    vector<double> priorDofs(m_rig_n_dofs);
+    vector<double> dofs(m_rig_n_dofs);
 
-    for (int i = 0; i < numMarkerPoints; i++)
+    for (int i = 0; i < m_rig_n_dofs; i++)
     {
-        MPointArray pointLocationPair = pointLocations[i];
-
-        MPoint p1 = pointLocationPair[0];
-        MPoint p2 = pointLocationPair[1];
-
-        double distance = p1.distanceTo(p2);
-        markerError += distance;
+        priorDofs[i] = existingDofs[i];
+        dofs[i] = m_dof_vector[i];
     }
 
-    // Step 4: Compute table intersection error
-    if (m_intersection_penalty_coefficient > 0.0)
-    {
-        MItMeshVertex handVertexItList(m_hand_geometry);
-
-        double signedDistance;
-
-        for (; !handVertexItList.isDone(); handVertexItList.next())
-        {
-            MPoint queryPoint =
-                handVertexItList.position(MSpace::kWorld, &status);
-            CHECK_MSTATUS(status);
-
-            status = computeTableSDF(queryPoint, signedDistance);
-            CHECK_MSTATUS(status);
+    m_frame_objective.setCorrespondences(&m_frame_correspondences);
+    m_frame_objective.setPriorDofs(priorDofs);
 
-            double clampedDistance = min(signedDistance, 0.0);
-            intersectionError += -1.0 * clampedDistance;
-        }
+    if (dualNumbers)
+    {
+        m_frame_objective.computeDualGradient(dofs, grad);
     }
-
-    // Step 5: Compute total weighted errors
-
-    double weightedMarkerError = m_marker_penalty_coefficient * markerError;
-    double weightedContactError = m_contact_penalty_coefficient * contactError;
-    double weightedIntersectionError =
-        m_intersection_penalty_coefficient * intersectionError;
-    double weightedPriorError = m_prior_penalty_coefficient * priorError;
-
-    double objValue = weightedMarkerError + weightedContactError +
-                      weightedIntersectionError + weightedPriorError;
-
-    if (visualizationEnabled)
+    else
     {
-        MGlobal::displayInfo(
-            "Marker: " + MString(to_string(weightedMarkerError).c_str()) +
-            " Contact: " + MString(to_string(weightedContactError).c_str()) +
-            " Intersection: " +
-            MString(to_string(weightedIntersectionError).c_str()) +
-            " Prior: " + MString(to_string(weightedPriorError).c_str()));
+        m_frame_objective.computeObjective(dofs, grad);
     }
 
-    return objValue;
+    return MS::kSuccess;
 }
 
 double FusedMotionEditContext::computeOptimization(const vector<double> &x,
@@ -2918,24 +5201,48 @@ double FusedMotionEditContext::computeOptimization(const vector<double> &x,
 
     MDoubleArray existingDofs = MDoubleArray(m_dof_vector);
 
+    m_frame_telemetry.numObjectiveEvaluations++;
+
     for (int i = 0; i < m_rig_n_dofs; i++)
     {
         m_dof_vector[i] = x[i];
     }
 
-    status = loadDofSolutionFull();
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    // Without native skinning the objective reads the deformed scene mesh
+    bool sceneEvaluation = m_hand_skinning.isEmpty();
+
+    if (sceneEvaluation)
+    {
+        status = loadDofSolutionFull();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
 
-    double currentObj = computeObjective(existingDofs);
+    // The analytic gradient comes out of the same native evaluation as the
+    // value, the other gradients need passes of their own
+    bool analyticGradient =
+        grad.size() > 0 && !sceneEvaluation && !m_reference_gradient_enabled;
+
+    double currentObj = computeObjective(existingDofs, false,
+                                         analyticGradient ? &grad : nullptr);
 
     if (grad.size() > 0)
     {
-        double step = 0.001;
+        m_frame_telemetry.numGradientEvaluations++;
 
-        // EXPENSIVE!! Currently uses forward differencing
-        for (int i = 0; i < m_rig_n_dofs; i++)
+        // Both gradients need skin weights to know what each dof moves
+        if (sceneEvaluation)
+        {
+            // EXPENSIVE!! Forward differencing through the scene
+            for (int i = 0; i < m_rig_n_dofs; i++)
+            {
+                grad[i] = computeDofGradient(
+                    existingDofs, FINITE_DIFFERENCE_STEP, currentObj, i);
+            }
+        }
+        else if (m_reference_gradient_enabled)
         {
-            grad[i] = computeDofGradient(existingDofs, step, currentObj, i);
+            status = computeObjectiveGradient(existingDofs, grad, true);
+            CHECK_MSTATUS(status);
         }
     }
     else
@@ -2945,8 +5252,20 @@ double FusedMotionEditContext::computeOptimization(const vector<double> &x,
 
     m_dof_vector = existingDofs;
 
-    status = loadDofSolutionFull();
-    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (sceneEvaluation)
+    {
+        status = loadDofSolutionFull();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    // Maya only runs timer callbacks while idle, and the solve holds the
+    // main thread, so progress is redrawn from here at a fixed rate instead
+    if (m_optimization_visualization_enabled &&
+        m_progress_snapshot.isRedrawDue(m_optimization_progress_rate))
+    {
+        status = redrawOptimizationProgress();
+        CHECK_MSTATUS(status);
+    }
 
     return currentObj;
 }
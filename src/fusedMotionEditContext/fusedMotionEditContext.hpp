@@ -6,31 +6,54 @@
 #include <maya/MColor.h>
 #include <maya/MDagPath.h>
 #include <maya/MDagPathArray.h>
+#include <maya/MFileIO.h>
 #include <maya/MFloatArray.h>
 #include <maya/MFloatPointArray.h>
 #include <maya/MFloatVectorArray.h>
 #include <maya/MFnDagNode.h>
 #include <maya/MFnIkJoint.h>
 #include <maya/MFnIntArrayData.h>
+#include <maya/MFnMatrixData.h>
 #include <maya/MFnMesh.h>
 #include <maya/MFnNurbsCurve.h>
 #include <maya/MFnSet.h>
+#include <maya/MFnSingleIndexedComponent.h>
+#include <maya/MFnSkinCluster.h>
 #include <maya/MFnStringArrayData.h>
 #include <maya/MFnTransform.h>
 #include <maya/MFnTypedAttribute.h>
 #include <maya/MGlobal.h>
 #include <maya/MItDag.h>
+#include <maya/MItDependencyGraph.h>
 #include <maya/MItMeshVertex.h>
 #include <maya/MItSelectionList.h>
 #include <maya/MMatrix.h>
+#include <maya/MObjectArray.h>
 #include <maya/MPlug.h>
 #include <maya/MPointArray.h>
 #include <maya/MPxContext.h>
+#include <maya/MQuaternion.h>
 #include <maya/MSelectionList.h>
 
 #include <nlopt.hpp>
 
+#include "frameCorrespondences.hpp"
+#include "frameObjective.hpp"
+#include "dofUndoHistory.hpp"
+#include "frameRangeSolver.hpp"
+#include "frameSolutionMatrix.hpp"
+#include "fusedProblem.hpp"
+#include "handKinematics.hpp"
+#include "handSkinning.hpp"
+#include "levenbergMarquardt.hpp"
+#include "progressSnapshot.hpp"
+#include "rigKeyframeSink.hpp"
+#include "solveTelemetry.hpp"
+#include "spaceTimeSolver.hpp"
+#include "taskPool.hpp"
+
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <map>
@@ -78,11 +101,11 @@
 
 #define DEFAULT_SPHERE_SIZE 0.1f // Size of the spheres that form a patch
 
-// #define RUN_OPTIMIZATION_TIMER
+#define FINITE_DIFFERENCE_STEP 0.001
 
-#ifdef RUN_OPTIMIZATION_TIMER
-#include <chrono>
-#endif
+#define MULTI_START_PERTURBATION 0.5 // Radians either side of the start
+
+#define DEFAULT_PROGRESS_RATE 10.0 // Optimization progress redraws per second
 
 using namespace std;
 
@@ -109,10 +132,22 @@ public:
 
     MStatus computeAccelerationErrors(int frameStart, int frameEnd);
 
+    MStatus dumpTelemetry(MString &filename);
+
+    MStatus enableLeastSquaresSolver(bool enable);
+
     MStatus enableOptimizationProgressVisualization(bool enable);
 
+    MStatus enableReferenceGradient(bool enable);
+
+    MStatus enableTemporalWarmStart(bool enable);
+
+    MStatus exportProblem(int frameStart, int frameEnd, MString &filename);
+
     MStatus finalizeOmissionIndices(int frameStart, int frameEnd);
 
+    MStatus importDofMatrix(MString &filename);
+
     MStatus jumpToFrame(int frame, bool suppressVisualization = false);
 
     MStatus keyframeRig();
@@ -125,6 +160,8 @@ public:
     MStatus resolveAccelerationErrors(int frameStart, int frameEnd,
                                       int maxIterations);
 
+    MStatus setAccelerationPenaltyCoefficient(double coefficient);
+
     MStatus setAccelerationViolationEpsilon(int frameStart, int frameEnd,
                                             double epsilon);
 
@@ -141,12 +178,30 @@ public:
 
     MStatus setCoefficientPriorError(double priorCoefficient);
 
+    MStatus setMultiStartRestarts(int numRestarts);
+
+    MStatus setMultiStartTimeBudget(double seconds);
+
     MStatus setNumOptIterations(int numIterations);
 
+    MStatus setNumSolverThreads(int numThreads);
+
+    MStatus setOptimizationProgressRate(double rate);
+
+    MStatus setSpaceTimeWindowSize(int windowSize);
+
+    MStatus setUndoMemoryCap(int megabytes);
+
+    MStatus setWarmStartChunkSize(int chunkSize);
+
     MStatus storeAccelerationErrors();
 
+    MStatus undoFrameOptimization(int frame);
+
     MStatus undoOptimization();
 
+    MStatus validateGradient();
+
     MStatus wipeRigKeyframe(int frameStart, int frameEnd);
 
     // UI Event Handlers
@@ -155,12 +210,18 @@ public:
 
     // Core Context Setup
 
+    MStatus buildHandKinematics();
+
     MStatus loadAllGeometries();
 
     MStatus loadAllVirtualMarkers();
 
     MStatus loadMarkerPatchPairing(MString &markerPatchName);
 
+    MStatus loadObjectSDF();
+
+    MStatus loadSkinWeights();
+
     MStatus loadTable();
 
     MStatus parseKinematicTree();
@@ -185,6 +246,8 @@ public:
 
     MStatus redrawMarkerVisualizations();
 
+    MStatus redrawOptimizationProgress();
+
     MStatus visualizeAllContacts();
 
     MStatus visualizeAllVirtualMarkers();
@@ -194,14 +257,29 @@ public:
 
     // Core Utils
 
+    MStatus compileFrameCorrespondences();
+
     MStatus
     computePairedMarkerPatchLocations(vector<MPointArray> &pointLocations);
 
-    MStatus computeTableSDF(MPoint &queryPoint, double &signedDistance);
+    MStatus computeSceneObjectiveErrors(const MDoubleArray &existingDofs,
+                                        double &weightedMarkerError,
+                                        double &weightedContactError,
+                                        double &weightedIntersectionError,
+                                        double &weightedPriorError);
+
+    MStatus configureFrameObjective(FrameObjective &objective);
+
+    void extrapolateDofSolution(const vector<double> &lastDofs,
+                                const vector<double> &secondLastDofs,
+                                vector<double> &x) const;
 
     MStatus
     generateHandTestPoints(vector<pair<MFloatPoint, MFloatVector>> &handPoints);
 
+    MStatus getJointRotationLimits(MFnIkJoint &fnJoint, int axis,
+                                   double &lowerLimit, double &upperLimit);
+
     MStatus getMocapMarker(MString &mocapMarkerName, MDagPath &mocapMarkerDag);
 
     MStatus getOmissionIndicesAttribute(MString &contactGroupName,
@@ -215,16 +293,26 @@ public:
                                             MString attributeName,
                                             MStringArray &serializedPoints);
 
+    MStatus getSolveSettings(FusedSolveSettings &settings);
+
     MStatus initializeDofSolution();
 
     nlopt::opt initializeOptimization();
 
+    MStatus interpolateHandPoint(MFnMesh &fnHandMesh, const int *vertices,
+                                 const double *weights, int numVertices,
+                                 MFloatPoint &position, MFloatVector &normal);
+
     MStatus interpolateSerializedPoint(MFnMesh &fnMesh,
                                        vector<int> &vertexIndices,
                                        vector<double> &coords,
                                        MFloatPoint &position,
                                        MFloatVector &normal);
 
+    MStatus keyframeSolutions(int frameStart,
+                              const vector<vector<double>> &priorDofs,
+                              const vector<vector<double>> &solutions);
+
     MStatus loadDofSolutionFull();
 
     MStatus loadDofSolutionSingle(int index);
@@ -232,16 +320,47 @@ public:
     MStatus parseSerializedPoint(MFnMesh &fnMesh, MString &serializedPoint,
                                  vector<int> &vertices, vector<double> &coords);
 
+    MStatus plotAccelerationErrors();
+
+    bool predictDofSolution(vector<double> &x) const;
+
+    void recordDofSolution(const vector<double> &x);
+
+    MStatus resolveViolationWindows(int frameStart, int frameEnd);
+
+    MStatus restoreDofDelta(const DofDelta &delta);
+
     MStatus runOptimization(nlopt::opt &optim);
 
+    MStatus runLeastSquares(vector<double> &x, double &minf);
+
+    MStatus runMultiStart(vector<double> &x, double &minf);
+
     MStatus setContactAttribute(MString &contactGroupName,
                                 MStringArray &serializedContactPoints);
 
     MStatus
     setSerializedViolationsAttribute(MStringArray &serializedFrameViolations);
 
+    MStatus snapshotFrameRange(int frameStart, int frameEnd,
+                               vector<FrameCorrespondences> &correspondences,
+                               vector<vector<double>> &frameDofs,
+                               vector<FrameTelemetry> &frameTelemetry);
+
+    MStatus solveFramesParallel(int frameStart, int frameEnd);
+
+    MStatus solveSpaceTimeWindow(int windowStart, int windowEnd);
+
     MStatus storeExistingFrameSolutions(int frameStart, int frameEnd);
 
+    void storeFrameSolution(int frame);
+
+    MStatus updateAccelerationErrors();
+
+    MStatus updateAccelerationViolations(const vector<int> &frames);
+
+    MStatus updateHandPose();
+
     MStatus wipeContactPairingLines();
 
     MStatus wipeJointKeyframe(MString &jointName, int frameStart, int frameEnd);
@@ -260,7 +379,12 @@ public:
                               double currentObjectiveValue, int dofVectorIndex);
 
     double computeObjective(const MDoubleArray &existingDofs,
-                            bool suppressVisualization = false);
+                            bool suppressVisualization = false,
+                            vector<double> *grad = nullptr);
+
+    MStatus computeObjectiveGradient(const MDoubleArray &existingDofs,
+                                     vector<double> &grad,
+                                     bool dualNumbers = false);
 
     double computeOptimization(const vector<double> &x, vector<double> &grad);
 
@@ -276,6 +400,7 @@ private:
     // Object mesh vars
 
     MDagPath m_object_geometry;
+    ObjectSDF m_object_sdf; // Object space, shared by all objectives
 
     // Table mesh vars
 
@@ -294,6 +419,7 @@ private:
     double m_realtime_delta;
     MStringArray m_joint_names;
     map<MTime::Unit, double> m_fpsRealtimeConversionTable;
+    RigKeyframeSink m_keyframe_sink;
 
     // Kinematic vars
 
@@ -301,20 +427,40 @@ private:
     MDagPath m_rig_base;
     MDagPathArray m_rig_joints;
     MDoubleArray m_dof_vector;
-    stack<MDoubleArray> m_last_dof_vectors;
+    DofUndoHistory m_undo_history;
+    long m_solve_undo_sequence; // Solve of the current frame, -1 if none
     vector<pair<int, int>> m_dof_vec_mappings;
+    vector<double> m_dof_lower_limits; // Unlimited dofs are +-HUGE_VAL
+    vector<double> m_dof_upper_limits;
+    map<string, int> m_joint_rig_indices; // Joint path to nearest rig joint
+    HandKinematics m_hand_kinematics;
+    HandPose m_hand_pose;
+
+    // Skinning vars
+
+    HandSkinning m_hand_skinning; // Empty if the hand has no skin cluster
 
     // Marker pairing vars
 
     map<string, MString> m_paired_marker_patches;
 
+    // Correspondence vars
+
+    FrameCorrespondences m_frame_correspondences;
+    int m_correspondence_frame; // -1 when stale
+    FrameObjective m_frame_objective; // Native evaluation of the current frame
+
     // Visualization vars
 
     map<string, MObject> m_patch_visualization_map;
 
     // Optimization vars
 
+    bool m_reference_gradient_enabled; // Dual number instead of analytic
     bool m_optimization_visualization_enabled;
+    double m_optimization_progress_rate; // Redraws per second, 0 unlimited
+    ProgressSnapshot m_progress_snapshot; // Best of the running solve
+    bool m_least_squares_enabled; // Levenberg-Marquardt instead of MMA
     int m_num_opt_iterations;
     double m_contact_distance_penalty_coefficient;
     double m_contact_normal_penalty_coefficient;
@@ -322,12 +468,26 @@ private:
     double m_contact_penalty_coefficient;
     double m_intersection_penalty_coefficient;
     double m_prior_penalty_coefficient;
+    int m_num_solver_threads; // Bulk solves only, 1 keeps them in the scene
+    int m_warm_start_chunk_size; // Contiguous frames chained per thread
+    bool m_temporal_warm_start_enabled; // Constant velocity initial guess
+    int m_num_restarts; // Perturbed starts per frame, 0 disables multi-start
+    double m_restart_time_budget; // Seconds per frame, 0 is unbounded
+    deque<pair<int, vector<double>>> m_recent_solutions; // Last two frames
+    int m_num_solver_iterations; // Of the last solve
+
+    // Telemetry vars
+
+    SolveTelemetry m_telemetry; // Frames solved since the last bulk run
+    FrameTelemetry m_frame_telemetry; // Frame being solved
 
     // Refinement vars
 
     double m_acceleration_epsilon;
+    double m_acceleration_penalty_coefficient; // Space-time solves only
+    int m_space_time_window_size; // 0 re-solves violating frames one by one
     map<int, MIntArray> m_acceleration_violations;
-    map<int, MDoubleArray> m_existing_frame_solutions;
+    FrameSolutionMatrix m_frame_solutions; // Range of the last full compute
     default_random_engine m_rng;
 
     // View vars
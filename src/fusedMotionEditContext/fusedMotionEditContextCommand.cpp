@@ -63,6 +63,24 @@ MStatus FusedMotionEditContextCommand::appendSyntax()
                         MSyntax::kBoolean);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = mSyntax.addFlag(OPTIMIZATION_PROGRESS_RATE_FLAG,
+                             OPTIMIZATION_PROGRESS_RATE_FLAG_LONG,
+                             MSyntax::kDouble);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(REFERENCE_GRADIENT_FLAG,
+                             REFERENCE_GRADIENT_FLAG_LONG, MSyntax::kBoolean);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(LEAST_SQUARES_SOLVER_FLAG,
+                             LEAST_SQUARES_SOLVER_FLAG_LONG,
+                             MSyntax::kBoolean);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(VALIDATE_GRADIENT_FLAG,
+                             VALIDATE_GRADIENT_FLAG_LONG, MSyntax::kNoArg);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = mSyntax.addFlag(RESET_JOINTS_FLAG, RESET_JOINTS_FLAG_LONG,
                              MSyntax::kNoArg);
     CHECK_MSTATUS_AND_RETURN_IT(status);
@@ -71,6 +89,28 @@ MStatus FusedMotionEditContextCommand::appendSyntax()
                              UNDO_OPTIMIZATION_FLAG_LONG, MSyntax::kNoArg);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = mSyntax.addFlag(UNDO_FRAME_OPTIMIZATION_FLAG,
+                             UNDO_FRAME_OPTIMIZATION_FLAG_LONG,
+                             MSyntax::kUnsigned);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(UNDO_MEMORY_FLAG, UNDO_MEMORY_FLAG_LONG,
+                             MSyntax::kUnsigned);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(DUMP_TELEMETRY_FLAG, DUMP_TELEMETRY_FLAG_LONG,
+                             MSyntax::kString);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(EXPORT_PROBLEM_FLAG, EXPORT_PROBLEM_FLAG_LONG,
+                             MSyntax::kUnsigned, MSyntax::kUnsigned,
+                             MSyntax::kString);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(IMPORT_DOF_MATRIX_FLAG,
+                             IMPORT_DOF_MATRIX_FLAG_LONG, MSyntax::kString);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = mSyntax.addFlag(JUMP_FLAG, JUMP_FLAG_LONG, MSyntax::kUnsigned);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
@@ -78,6 +118,27 @@ MStatus FusedMotionEditContextCommand::appendSyntax()
                              MSyntax::kNoArg);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = mSyntax.addFlag(NUM_SOLVER_THREADS_FLAG,
+                             NUM_SOLVER_THREADS_FLAG_LONG, MSyntax::kUnsigned);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(WARM_START_CHUNK_SIZE_FLAG,
+                             WARM_START_CHUNK_SIZE_FLAG_LONG,
+                             MSyntax::kUnsigned);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(TEMPORAL_WARM_START_FLAG,
+                             TEMPORAL_WARM_START_FLAG_LONG, MSyntax::kBoolean);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(MULTI_START_FLAG, MULTI_START_FLAG_LONG,
+                             MSyntax::kUnsigned);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(MULTI_START_BUDGET_FLAG,
+                             MULTI_START_BUDGET_FLAG_LONG, MSyntax::kDouble);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = mSyntax.addFlag(KEYFRAME_RIG_BULK_FLAG,
                              KEYFRAME_RIG_BULK_FLAG_LONG, MSyntax::kUnsigned,
                              MSyntax::kUnsigned, MSyntax::kBoolean);
@@ -103,6 +164,14 @@ MStatus FusedMotionEditContextCommand::appendSyntax()
                              MSyntax::kUnsigned, MSyntax::kDouble);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
+    status = mSyntax.addFlag(ACCELERATION_PENALTY_FLAG,
+                             ACCELERATION_PENALTY_FLAG_LONG, MSyntax::kDouble);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    status = mSyntax.addFlag(SPACE_TIME_WINDOW_FLAG,
+                             SPACE_TIME_WINDOW_FLAG_LONG, MSyntax::kUnsigned);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = mSyntax.addFlag(
         RESOLVE_ACCELERATION_ERRORS_FLAG, RESOLVE_ACCELERATION_ERRORS_FLAG_LONG,
         MSyntax::kUnsigned, MSyntax::kUnsigned, MSyntax::kUnsigned);
@@ -204,6 +273,42 @@ MStatus FusedMotionEditContextCommand::doEditFlags()
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    if (argData.isFlagSet(OPTIMIZATION_PROGRESS_RATE_FLAG))
+    {
+        double rate = argData.flagArgumentDouble(
+            OPTIMIZATION_PROGRESS_RATE_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setOptimizationProgressRate(rate);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(REFERENCE_GRADIENT_FLAG))
+    {
+        bool enable =
+            argData.flagArgumentBool(REFERENCE_GRADIENT_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->enableReferenceGradient(enable);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(LEAST_SQUARES_SOLVER_FLAG))
+    {
+        bool enable =
+            argData.flagArgumentBool(LEAST_SQUARES_SOLVER_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->enableLeastSquaresSolver(enable);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(VALIDATE_GRADIENT_FLAG))
+    {
+        status = m_pContext->validateGradient();
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
     if (argData.isFlagSet(RESET_JOINTS_FLAG))
     {
         status = m_pContext->resetNonRootJoints();
@@ -216,6 +321,62 @@ MStatus FusedMotionEditContextCommand::doEditFlags()
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    if (argData.isFlagSet(UNDO_FRAME_OPTIMIZATION_FLAG))
+    {
+        int frame =
+            argData.flagArgumentInt(UNDO_FRAME_OPTIMIZATION_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->undoFrameOptimization(frame);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(UNDO_MEMORY_FLAG))
+    {
+        int megabytes = argData.flagArgumentInt(UNDO_MEMORY_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setUndoMemoryCap(megabytes);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(DUMP_TELEMETRY_FLAG))
+    {
+        MString filename =
+            argData.flagArgumentString(DUMP_TELEMETRY_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->dumpTelemetry(filename);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(EXPORT_PROBLEM_FLAG))
+    {
+        int frameStart =
+            argData.flagArgumentInt(EXPORT_PROBLEM_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        int frameEnd = argData.flagArgumentInt(EXPORT_PROBLEM_FLAG, 1, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MString filename =
+            argData.flagArgumentString(EXPORT_PROBLEM_FLAG, 2, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->exportProblem(frameStart, frameEnd, filename);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(IMPORT_DOF_MATRIX_FLAG))
+    {
+        MString filename =
+            argData.flagArgumentString(IMPORT_DOF_MATRIX_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->importDofMatrix(filename);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
     if (argData.isFlagSet(JUMP_FLAG))
     {
         int frame = argData.flagArgumentInt(JUMP_FLAG, 0, &status);
@@ -231,6 +392,56 @@ MStatus FusedMotionEditContextCommand::doEditFlags()
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    if (argData.isFlagSet(NUM_SOLVER_THREADS_FLAG))
+    {
+        int numThreads =
+            argData.flagArgumentInt(NUM_SOLVER_THREADS_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setNumSolverThreads(numThreads);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(WARM_START_CHUNK_SIZE_FLAG))
+    {
+        int chunkSize =
+            argData.flagArgumentInt(WARM_START_CHUNK_SIZE_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setWarmStartChunkSize(chunkSize);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(TEMPORAL_WARM_START_FLAG))
+    {
+        bool enable =
+            argData.flagArgumentBool(TEMPORAL_WARM_START_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->enableTemporalWarmStart(enable);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(MULTI_START_FLAG))
+    {
+        int numRestarts =
+            argData.flagArgumentInt(MULTI_START_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setMultiStartRestarts(numRestarts);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(MULTI_START_BUDGET_FLAG))
+    {
+        double seconds =
+            argData.flagArgumentDouble(MULTI_START_BUDGET_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setMultiStartTimeBudget(seconds);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
     if (argData.isFlagSet(KEYFRAME_RIG_BULK_FLAG))
     {
         int frameStart =
@@ -311,6 +522,26 @@ MStatus FusedMotionEditContextCommand::doEditFlags()
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    if (argData.isFlagSet(ACCELERATION_PENALTY_FLAG))
+    {
+        double coefficient =
+            argData.flagArgumentDouble(ACCELERATION_PENALTY_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setAccelerationPenaltyCoefficient(coefficient);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    if (argData.isFlagSet(SPACE_TIME_WINDOW_FLAG))
+    {
+        int windowSize =
+            argData.flagArgumentInt(SPACE_TIME_WINDOW_FLAG, 0, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        status = m_pContext->setSpaceTimeWindowSize(windowSize);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
     if (argData.isFlagSet(RESOLVE_ACCELERATION_ERRORS_FLAG))
     {
         int frameStart = argData.flagArgumentInt(
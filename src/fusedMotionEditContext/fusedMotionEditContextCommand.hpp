@@ -33,12 +33,39 @@
 #define OPTIMIZATION_PROGRESS_VISUALIZATION_ENABLED_FLAG "-pve"
 #define OPTIMIZATION_PROGRESS_VISUALIZATION_ENABLED_FLAG_LONG "-progvisenabled"
 
+#define OPTIMIZATION_PROGRESS_RATE_FLAG "-pvr"
+#define OPTIMIZATION_PROGRESS_RATE_FLAG_LONG "-progvisrate"
+
+#define REFERENCE_GRADIENT_FLAG "-rg"
+#define REFERENCE_GRADIENT_FLAG_LONG "-referencegradient"
+
+#define LEAST_SQUARES_SOLVER_FLAG "-lss"
+#define LEAST_SQUARES_SOLVER_FLAG_LONG "-leastsquaressolver"
+
+#define VALIDATE_GRADIENT_FLAG "-vg"
+#define VALIDATE_GRADIENT_FLAG_LONG "-validategradient"
+
 #define RESET_JOINTS_FLAG "-rj"
 #define RESET_JOINTS_FLAG_LONG "-resetjoints"
 
 #define UNDO_OPTIMIZATION_FLAG "-uo"
 #define UNDO_OPTIMIZATION_FLAG_LONG "-undoopt"
 
+#define UNDO_FRAME_OPTIMIZATION_FLAG "-uof"
+#define UNDO_FRAME_OPTIMIZATION_FLAG_LONG "-undooptframe"
+
+#define UNDO_MEMORY_FLAG "-um"
+#define UNDO_MEMORY_FLAG_LONG "-undomemory"
+
+#define DUMP_TELEMETRY_FLAG "-dt"
+#define DUMP_TELEMETRY_FLAG_LONG "-dumptelemetry"
+
+#define EXPORT_PROBLEM_FLAG "-ep"
+#define EXPORT_PROBLEM_FLAG_LONG "-exportproblem"
+
+#define IMPORT_DOF_MATRIX_FLAG "-idm"
+#define IMPORT_DOF_MATRIX_FLAG_LONG "-importdofmatrix"
+
 // Animation flags
 
 #define JUMP_FLAG "-j"
@@ -47,6 +74,21 @@
 #define KEYFRAME_RIG_FLAG "-kr"
 #define KEYFRAME_RIG_FLAG_LONG "-keyframerig"
 
+#define NUM_SOLVER_THREADS_FLAG "-nst"
+#define NUM_SOLVER_THREADS_FLAG_LONG "-numsolverthreads"
+
+#define WARM_START_CHUNK_SIZE_FLAG "-wsc"
+#define WARM_START_CHUNK_SIZE_FLAG_LONG "-warmstartchunk"
+
+#define TEMPORAL_WARM_START_FLAG "-tws"
+#define TEMPORAL_WARM_START_FLAG_LONG "-temporalwarmstart"
+
+#define MULTI_START_FLAG "-ms"
+#define MULTI_START_FLAG_LONG "-multistart"
+
+#define MULTI_START_BUDGET_FLAG "-msb"
+#define MULTI_START_BUDGET_FLAG_LONG "-multistartbudget"
+
 #define KEYFRAME_RIG_BULK_FLAG "-bkr"
 #define KEYFRAME_RIG_BULK_FLAG_LONG "-bulkkeyframerig"
 
@@ -64,6 +106,12 @@
 #define ACCELERATION_EPSILON_FLAG "-ae"
 #define ACCELERATION_EPSILON_FLAG_LONG "-accelerationepsilon"
 
+#define ACCELERATION_PENALTY_FLAG "-ap"
+#define ACCELERATION_PENALTY_FLAG_LONG "-accelerationpenalty"
+
+#define SPACE_TIME_WINDOW_FLAG "-stw"
+#define SPACE_TIME_WINDOW_FLAG_LONG "-spacetimewindow"
+
 #define RESOLVE_ACCELERATION_ERRORS_FLAG "-ra"
 #define RESOLVE_ACCELERATION_ERRORS_FLAG_LONG "-resolveaccelerationerrors"
 
@@ -0,0 +1,290 @@
+#include "fusedProblem.hpp"
+
+FusedProblem::FusedProblem() : frameStart(0) {}
+
+// Leaves the problem unusable on failure. Fails on any mismatch between the
+// frames and the rig or skin.
+bool FusedProblem::read(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+
+    readBinaryValue(file, magic);
+    readBinaryValue(file, version);
+
+    if (!file || magic != FUSED_PROBLEM_FILE_MAGIC ||
+        version != FUSED_PROBLEM_FILE_VERSION)
+    {
+        return false;
+    }
+
+    // Step 1: Settings
+
+    readBinaryValue(file, settings.contactDistanceCoefficient);
+    readBinaryValue(file, settings.contactNormalCoefficient);
+    readBinaryValue(file, settings.markerCoefficient);
+    readBinaryValue(file, settings.contactCoefficient);
+    readBinaryValue(file, settings.intersectionCoefficient);
+    readBinaryValue(file, settings.priorCoefficient);
+
+    int32_t numIterations;
+    int32_t warmStartChunkSize;
+    uint8_t leastSquares;
+    uint8_t temporalWarmStart;
+    uint8_t tableEnabled;
+
+    readBinaryValue(file, numIterations);
+    readBinaryValue(file, leastSquares);
+    readBinaryValue(file, warmStartChunkSize);
+    readBinaryValue(file, temporalWarmStart);
+    readBinaryValue(file, tableEnabled);
+
+    settings.numIterations = numIterations;
+    settings.leastSquares = leastSquares != 0;
+    settings.warmStartChunkSize = warmStartChunkSize;
+    settings.temporalWarmStart = temporalWarmStart != 0;
+    settings.tableEnabled = tableEnabled != 0;
+
+    file.read((char *)settings.tableInverse, sizeof(settings.tableInverse));
+    file.read((char *)settings.tableHalfDims, sizeof(settings.tableHalfDims));
+
+    readBinaryVector(file, dofLowerLimits);
+    readBinaryVector(file, dofUpperLimits);
+
+    // Step 2: Rig, skin and object
+
+    if (!file || !kinematics.read(file) || !skinning.read(file, kinematics))
+    {
+        return false;
+    }
+
+    uint8_t objectEnabled = 0;
+
+    readBinaryValue(file, objectEnabled);
+
+    objectSDF.clear();
+
+    if (objectEnabled != 0 && !objectSDF.read(file))
+    {
+        return false;
+    }
+
+    // Step 3: Frames
+
+    int32_t start = 0;
+    uint32_t numFrames = 0;
+
+    readBinaryValue(file, start);
+    readBinaryValue(file, numFrames);
+
+    if (!file || numFrames > BINARY_STREAM_MAX_LENGTH)
+    {
+        return false;
+    }
+
+    int numDofs = kinematics.getNumDofs();
+    int numVertices = skinning.getNumVertices();
+
+    if ((int)dofLowerLimits.size() != numDofs ||
+        (int)dofUpperLimits.size() != numDofs)
+    {
+        return false;
+    }
+
+    frameStart = start;
+    frameCorrespondences.assign(numFrames, FrameCorrespondences());
+    frameDofs.assign(numFrames, vector<double>());
+
+    for (uint32_t i = 0; i < numFrames; i++)
+    {
+        FrameCorrespondences &frame = frameCorrespondences[i];
+
+        if (!frame.read(file))
+        {
+            return false;
+        }
+
+        readBinaryVector(file, frameDofs[i]);
+
+        if (!file || (int)frameDofs[i].size() != numDofs)
+        {
+            return false;
+        }
+
+        // Hand points index the skinned mesh
+        for (int c = 0; c < frame.getNumContacts(); c++)
+        {
+            const int *vertices = frame.getContactVertices(c);
+
+            for (int k = 0; k < CORRESPONDENCE_STRIDE; k++)
+            {
+                if (vertices[k] < 0 || vertices[k] >= numVertices)
+                {
+                    return false;
+                }
+            }
+        }
+
+        for (int m = 0; m < frame.getNumMarkers(); m++)
+        {
+            const int *vertices = frame.getMarkerVertices(m);
+
+            for (int k = 0; k < CORRESPONDENCE_STRIDE; k++)
+            {
+                if (vertices[k] < 0 || vertices[k] >= numVertices)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool FusedProblem::write(const string &filename) const
+{
+    ofstream file(filename, ios::binary | ios::trunc);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    writeBinaryValue(file, (uint32_t)FUSED_PROBLEM_FILE_MAGIC);
+    writeBinaryValue(file, (uint32_t)FUSED_PROBLEM_FILE_VERSION);
+
+    // Step 1: Settings
+
+    writeBinaryValue(file, settings.contactDistanceCoefficient);
+    writeBinaryValue(file, settings.contactNormalCoefficient);
+    writeBinaryValue(file, settings.markerCoefficient);
+    writeBinaryValue(file, settings.contactCoefficient);
+    writeBinaryValue(file, settings.intersectionCoefficient);
+    writeBinaryValue(file, settings.priorCoefficient);
+
+    writeBinaryValue(file, (int32_t)settings.numIterations);
+    writeBinaryValue(file, (uint8_t)settings.leastSquares);
+    writeBinaryValue(file, (int32_t)settings.warmStartChunkSize);
+    writeBinaryValue(file, (uint8_t)settings.temporalWarmStart);
+    writeBinaryValue(file, (uint8_t)settings.tableEnabled);
+
+    file.write((const char *)settings.tableInverse,
+               sizeof(settings.tableInverse));
+    file.write((const char *)settings.tableHalfDims,
+               sizeof(settings.tableHalfDims));
+
+    writeBinaryVector(file, dofLowerLimits);
+    writeBinaryVector(file, dofUpperLimits);
+
+    // Step 2: Rig, skin and object
+
+    kinematics.write(file);
+    skinning.write(file);
+
+    writeBinaryValue(file, (uint8_t)!objectSDF.isEmpty());
+
+    if (!objectSDF.isEmpty())
+    {
+        objectSDF.write(file);
+    }
+
+    // Step 3: Frames
+
+    writeBinaryValue(file, (int32_t)frameStart);
+    writeBinaryValue(file, (uint32_t)frameDofs.size());
+
+    for (size_t i = 0; i < frameDofs.size(); i++)
+    {
+        frameCorrespondences[i].write(file);
+        writeBinaryVector(file, frameDofs[i]);
+    }
+
+    return (bool)file;
+}
+
+// One row of dofs per frame, from frameStart
+bool FusedProblem::readDofMatrix(const string &filename, int &frameStart,
+                                 vector<vector<double>> &frameDofs)
+{
+    ifstream file(filename, ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    int32_t start = 0;
+    uint32_t numFrames = 0;
+    uint32_t numDofs = 0;
+
+    readBinaryValue(file, magic);
+    readBinaryValue(file, version);
+    readBinaryValue(file, start);
+    readBinaryValue(file, numFrames);
+    readBinaryValue(file, numDofs);
+
+    if (!file || magic != DOF_MATRIX_FILE_MAGIC ||
+        version != DOF_MATRIX_FILE_VERSION ||
+        (uint64_t)numFrames * numDofs > BINARY_STREAM_MAX_LENGTH)
+    {
+        return false;
+    }
+
+    vector<vector<double>> rows(numFrames, vector<double>(numDofs));
+
+    for (uint32_t i = 0; i < numFrames; i++)
+    {
+        file.read((char *)rows[i].data(), numDofs * sizeof(double));
+    }
+
+    if (!file)
+    {
+        return false;
+    }
+
+    frameStart = start;
+    frameDofs = move(rows);
+
+    return true;
+}
+
+bool FusedProblem::writeDofMatrix(const string &filename, int frameStart,
+                                  const vector<vector<double>> &frameDofs)
+{
+    ofstream file(filename, ios::binary | ios::trunc);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    uint32_t numDofs = frameDofs.empty() ? 0 : frameDofs[0].size();
+
+    writeBinaryValue(file, (uint32_t)DOF_MATRIX_FILE_MAGIC);
+    writeBinaryValue(file, (uint32_t)DOF_MATRIX_FILE_VERSION);
+    writeBinaryValue(file, (int32_t)frameStart);
+    writeBinaryValue(file, (uint32_t)frameDofs.size());
+    writeBinaryValue(file, numDofs);
+
+    for (const vector<double> &row : frameDofs)
+    {
+        if (row.size() != numDofs)
+        {
+            return false;
+        }
+
+        file.write((const char *)row.data(), numDofs * sizeof(double));
+    }
+
+    return (bool)file;
+}
@@ -0,0 +1,46 @@
+#ifndef FUSEDPROBLEM_H
+#define FUSEDPROBLEM_H
+
+#include "frameRangeSolver.hpp"
+
+#include <fstream>
+#include <string>
+
+#define FUSED_PROBLEM_FILE_MAGIC 0x42525046 // "FPRB"
+#define FUSED_PROBLEM_FILE_VERSION 1
+
+#define DOF_MATRIX_FILE_MAGIC 0x464f4446 // "FDOF"
+#define DOF_MATRIX_FILE_VERSION 1
+
+// Not a Maya context - everything a fused solve of a frame range needs: the
+// rig with its dof mapping, the skin with its bind pose, the object SDF, the
+// settings and, per frame, the resolved contacts and markers (which carry the
+// object and mocap positions of their frame) with the prior dofs. Written by
+// the plugin and solved without Maya by fused_solve, which writes the frames
+// back as a dof matrix.
+struct FusedProblem
+{
+    FusedProblem();
+
+    bool read(const string &filename);
+    bool write(const string &filename) const;
+
+    static bool readDofMatrix(const string &filename, int &frameStart,
+                              vector<vector<double>> &frameDofs);
+    static bool writeDofMatrix(const string &filename, int frameStart,
+                               const vector<vector<double>> &frameDofs);
+
+    HandKinematics kinematics;
+    HandSkinning skinning;
+    ObjectSDF objectSDF; // Empty without an object mesh
+
+    FusedSolveSettings settings;
+    vector<double> dofLowerLimits; // Unlimited dofs are +-HUGE_VAL
+    vector<double> dofUpperLimits;
+
+    int frameStart;
+    vector<FrameCorrespondences> frameCorrespondences;
+    vector<vector<double>> frameDofs; // Priors and starting points
+};
+
+#endif // FUSEDPROBLEM_H
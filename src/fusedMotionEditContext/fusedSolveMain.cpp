@@ -0,0 +1,90 @@
+#include "fusedProblem.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Standalone fused solve of a problem exported by the plugin, for machines
+// without Maya. Writes the solved frames as a dof matrix for the plugin to
+// import.
+int main(int argc, char **argv)
+{
+    if (argc < 3 || argc > 4)
+    {
+        cerr << "Usage: fused_solve <problem file> <dof matrix file> [threads]"
+             << endl;
+        return 1;
+    }
+
+    string problemFilename = argv[1];
+    string dofMatrixFilename = argv[2];
+
+    // 0 uses every available core
+    int numThreads = (argc == 4) ? atoi(argv[3]) : 0;
+
+    if (numThreads <= 0)
+    {
+        numThreads = max((int)thread::hardware_concurrency(), 1);
+    }
+
+    FusedProblem problem;
+
+    if (!problem.read(problemFilename))
+    {
+        cerr << "Could not read problem from " << problemFilename << endl;
+        return 1;
+    }
+
+    int numFrames = problem.frameDofs.size();
+
+    cout << "Solving " << numFrames << " frames on " << numThreads
+         << " threads..." << endl;
+
+    FrameRangeSolver solver(problem.kinematics, problem.skinning,
+                            problem.objectSDF);
+    solver.setSettings(problem.settings);
+    solver.setDofLimits(problem.dofLowerLimits, problem.dofUpperLimits);
+
+    vector<vector<double>> frameSolutions;
+    vector<FrameTelemetry> frameTelemetry;
+    vector<int> frameIterations;
+
+    TelemetryClock solveStart = SolveTelemetry::now();
+
+    int numFailures = solver.solve(
+        numThreads, problem.frameStart, problem.frameCorrespondences,
+        problem.frameDofs, frameSolutions, frameTelemetry, frameIterations);
+
+    double solveTime = SolveTelemetry::secondsSince(solveStart);
+
+    int totalIterations = 0;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        totalIterations += frameIterations[i];
+    }
+
+    if (numFrames > 0)
+    {
+        cout << "Mean iterations per frame: "
+             << (double)totalIterations / numFrames << endl;
+    }
+
+    if (numFailures > 0)
+    {
+        cout << "NLOPT failed on " << numFailures << " frames - inputs kept"
+             << endl;
+    }
+
+    cout << "Time taken: " << solveTime << " s" << endl;
+
+    if (!FusedProblem::writeDofMatrix(dofMatrixFilename, problem.frameStart,
+                                      frameSolutions))
+    {
+        cerr << "Could not write dof matrix to " << dofMatrixFilename << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,378 @@
+#include "handKinematics.hpp"
+
+HandKinematics::HandKinematics() : m_num_joints(0) {}
+
+HandKinematics::~HandKinematics() {}
+
+int HandKinematics::addJoint(int parent, const double *preMatrix,
+                             const double *postMatrix,
+                             const int *rotationSequence,
+                             const double *rotation, const double *translation,
+                             bool worldTranslation)
+{
+    m_parents.push_back(parent);
+
+    m_pre_matrices.insert(m_pre_matrices.end(), preMatrix,
+                          preMatrix + MATRIX_SIZE);
+    m_post_matrices.insert(m_post_matrices.end(), postMatrix,
+                           postMatrix + MATRIX_SIZE);
+
+    m_rotation_sequences.insert(m_rotation_sequences.end(), rotationSequence,
+                                rotationSequence + 3);
+    m_base_rotations.insert(m_base_rotations.end(), rotation, rotation + 3);
+    m_base_translations.insert(m_base_translations.end(), translation,
+                               translation + 3);
+
+    m_world_translations.push_back(worldTranslation);
+
+    m_joint_dofs.push_back(vector<int>());
+
+    return m_num_joints++;
+}
+
+void HandKinematics::addDof(int joint, int dofIndex)
+{
+    int dof = m_dof_joints.size();
+
+    m_dof_joints.push_back(joint);
+    m_dof_indices.push_back(dofIndex);
+
+    // Descendants always follow their ancestors
+    for (int i = joint; i < m_num_joints; i++)
+    {
+        int ancestor = i;
+
+        while (ancestor > joint)
+        {
+            ancestor = m_parents[ancestor];
+        }
+
+        if (ancestor == joint)
+        {
+            m_joint_dofs[i].push_back(dof);
+        }
+    }
+}
+
+void HandKinematics::clear()
+{
+    m_num_joints = 0;
+
+    m_parents.clear();
+    m_rotation_sequences.clear();
+    m_pre_matrices.clear();
+    m_post_matrices.clear();
+    m_base_rotations.clear();
+    m_base_translations.clear();
+    m_world_translations.clear();
+
+    m_dof_joints.clear();
+    m_dof_indices.clear();
+    m_joint_dofs.clear();
+}
+
+void HandKinematics::computeDofAxes(const HandPose &pose, vector<double> &axes,
+                                    vector<double> &pivots) const
+{
+    int numDofs = getNumDofs();
+
+    axes.assign(3 * numDofs, 0.0);
+    pivots.assign(3 * numDofs, 0.0);
+
+    double frame[MATRIX_SIZE];
+    double jointFrame[MATRIX_SIZE];
+
+    for (int i = 0; i < numDofs; i++)
+    {
+        int joint = m_dof_joints[i];
+        int dofIndex = m_dof_indices[i];
+
+        if (dofIndex > 2) // indicates translation dof
+        {
+            // Translation is set in world space
+            axes[3 * i + dofIndex - 3] = 1.0;
+            continue;
+        }
+
+        // Carry the local dof axis through every rotation applied after it,
+        // then out through the joint orient and parent transforms
+
+        const double *rotation = &pose.m_rotations[3 * joint];
+        const int *sequence = &m_rotation_sequences[3 * joint];
+
+        fill(frame, frame + MATRIX_SIZE, 0.0);
+        frame[0] = frame[5] = frame[10] = frame[15] = 1.0;
+
+        bool axisApplied = false;
+
+        for (int j = 0; j < 3; j++)
+        {
+            int axis = sequence[j];
+
+            if (axisApplied)
+            {
+                applyAxisRotation(axis, rotation[axis], frame);
+            }
+
+            if (axis == dofIndex)
+            {
+                axisApplied = true;
+            }
+        }
+
+        multiplyMatrices(frame, &m_post_matrices[MATRIX_SIZE * joint],
+                         jointFrame);
+
+        int parent = m_parents[joint];
+
+        if (parent >= 0)
+        {
+            multiplyMatrices(jointFrame,
+                             &pose.m_world_matrices[MATRIX_SIZE * parent],
+                             frame);
+        }
+        else
+        {
+            copy(jointFrame, jointFrame + MATRIX_SIZE, frame);
+        }
+
+        // Row vector convention - the transformed unit axis is a matrix row
+        double *axis = &axes[3 * i];
+
+        axis[0] = frame[4 * dofIndex];
+        axis[1] = frame[4 * dofIndex + 1];
+        axis[2] = frame[4 * dofIndex + 2];
+
+        double length =
+            sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+        if (length > 0.0)
+        {
+            axis[0] /= length;
+            axis[1] /= length;
+            axis[2] /= length;
+        }
+
+        const double *world = &pose.m_world_matrices[MATRIX_SIZE * joint];
+
+        pivots[3 * i] = world[12];
+        pivots[3 * i + 1] = world[13];
+        pivots[3 * i + 2] = world[14];
+    }
+}
+
+template <typename Scalar>
+void HandKinematics::computePose(const vector<Scalar> &dofs,
+                                 ScalarHandPose<Scalar> &pose) const
+{
+    pose.resize(m_num_joints);
+
+    copy(m_base_rotations.begin(), m_base_rotations.end(),
+         pose.m_rotations.begin());
+    copy(m_base_translations.begin(), m_base_translations.end(),
+         pose.m_translations.begin());
+
+    int numDofs = getNumDofs();
+
+    for (int i = 0; i < numDofs; i++)
+    {
+        int joint = m_dof_joints[i];
+        int dofIndex = m_dof_indices[i];
+
+        if (dofIndex > 2) // indicates translation dof
+        {
+            pose.m_translations[3 * joint + dofIndex - 3] = dofs[i];
+        }
+        else
+        {
+            pose.m_rotations[3 * joint + dofIndex] = dofs[i];
+        }
+    }
+
+    Scalar rotationMatrix[MATRIX_SIZE];
+    Scalar localMatrix[MATRIX_SIZE];
+    Scalar jointMatrix[MATRIX_SIZE];
+
+    // Parents always precede their children, so one pass is enough
+    for (int i = 0; i < m_num_joints; i++)
+    {
+        computeRotationMatrix(&m_rotation_sequences[3 * i],
+                              &pose.m_rotations[3 * i], rotationMatrix);
+
+        multiplyMatrices(&m_pre_matrices[MATRIX_SIZE * i], rotationMatrix,
+                         localMatrix);
+
+        Scalar *world = &pose.m_world_matrices[MATRIX_SIZE * i];
+
+        int parent = m_parents[i];
+
+        if (parent >= 0)
+        {
+            multiplyMatrices(localMatrix, &m_post_matrices[MATRIX_SIZE * i],
+                             jointMatrix);
+            multiplyMatrices(jointMatrix,
+                             &pose.m_world_matrices[MATRIX_SIZE * parent],
+                             world);
+        }
+        else
+        {
+            multiplyMatrices(localMatrix, &m_post_matrices[MATRIX_SIZE * i],
+                             world);
+        }
+
+        if (m_world_translations[i])
+        {
+            world[12] = pose.m_translations[3 * i];
+            world[13] = pose.m_translations[3 * i + 1];
+            world[14] = pose.m_translations[3 * i + 2];
+        }
+    }
+}
+
+int HandKinematics::getDofIndex(int dof) const { return m_dof_indices[dof]; }
+
+int HandKinematics::getDofJoint(int dof) const { return m_dof_joints[dof]; }
+
+const vector<int> &HandKinematics::getJointDofs(int joint) const
+{
+    return m_joint_dofs[joint];
+}
+
+int HandKinematics::getJointParent(int joint) const { return m_parents[joint]; }
+
+int HandKinematics::getNumDofs() const { return m_dof_joints.size(); }
+
+int HandKinematics::getNumJoints() const { return m_num_joints; }
+
+// Replaces the rig. Joints and dofs are added again so that the dofs of each
+// joint are rebuilt.
+bool HandKinematics::read(istream &in)
+{
+    vector<int> parents;
+    vector<int> rotationSequences;
+    vector<double> preMatrices;
+    vector<double> postMatrices;
+    vector<double> baseRotations;
+    vector<double> baseTranslations;
+    vector<char> worldTranslations;
+    vector<int> dofJoints;
+    vector<int> dofIndices;
+
+    readBinaryVector(in, parents);
+    readBinaryVector(in, rotationSequences);
+    readBinaryVector(in, preMatrices);
+    readBinaryVector(in, postMatrices);
+    readBinaryVector(in, baseRotations);
+    readBinaryVector(in, baseTranslations);
+    readBinaryVector(in, worldTranslations);
+    readBinaryVector(in, dofJoints);
+    readBinaryVector(in, dofIndices);
+
+    size_t numJoints = parents.size();
+
+    if (!in || rotationSequences.size() != 3 * numJoints ||
+        preMatrices.size() != MATRIX_SIZE * numJoints ||
+        postMatrices.size() != MATRIX_SIZE * numJoints ||
+        baseRotations.size() != 3 * numJoints ||
+        baseTranslations.size() != 3 * numJoints ||
+        worldTranslations.size() != numJoints ||
+        dofIndices.size() != dofJoints.size())
+    {
+        return false;
+    }
+
+    clear();
+
+    for (size_t i = 0; i < numJoints; i++)
+    {
+        addJoint(parents[i], &preMatrices[MATRIX_SIZE * i],
+                 &postMatrices[MATRIX_SIZE * i], &rotationSequences[3 * i],
+                 &baseRotations[3 * i], &baseTranslations[3 * i],
+                 worldTranslations[i] != 0);
+    }
+
+    for (size_t i = 0; i < dofJoints.size(); i++)
+    {
+        addDof(dofJoints[i], dofIndices[i]);
+    }
+
+    return true;
+}
+
+void HandKinematics::write(ostream &out) const
+{
+    vector<char> worldTranslations(m_world_translations.begin(),
+                                   m_world_translations.end());
+
+    writeBinaryVector(out, m_parents);
+    writeBinaryVector(out, m_rotation_sequences);
+    writeBinaryVector(out, m_pre_matrices);
+    writeBinaryVector(out, m_post_matrices);
+    writeBinaryVector(out, m_base_rotations);
+    writeBinaryVector(out, m_base_translations);
+    writeBinaryVector(out, worldTranslations);
+    writeBinaryVector(out, m_dof_joints);
+    writeBinaryVector(out, m_dof_indices);
+}
+
+template <typename Scalar>
+void HandKinematics::computeRotationMatrix(const int *rotationSequence,
+                                           const Scalar *rotation,
+                                           Scalar *matrix)
+{
+    fill(matrix, matrix + MATRIX_SIZE, 0.0);
+    matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        int axis = rotationSequence[i];
+        applyAxisRotation(axis, rotation[axis], matrix);
+    }
+}
+
+template <typename Left, typename Right, typename Product>
+void HandKinematics::multiplyMatrices(const Left *a, const Right *b,
+                                      Product *product)
+{
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            product[4 * row + col] = a[4 * row] * b[col] +
+                                     a[4 * row + 1] * b[4 + col] +
+                                     a[4 * row + 2] * b[8 + col] +
+                                     a[4 * row + 3] * b[12 + col];
+        }
+    }
+}
+
+// Right multiplies by a single axis rotation, matching MEulerRotation
+template <typename Scalar>
+void HandKinematics::applyAxisRotation(int axis, Scalar angle, Scalar *matrix)
+{
+    int i = (axis + 1) % 3;
+    int j = (axis + 2) % 3;
+
+    Scalar c = cos(angle);
+    Scalar s = sin(angle);
+
+    for (int row = 0; row < 4; row++)
+    {
+        Scalar mi = matrix[4 * row + i];
+        Scalar mj = matrix[4 * row + j];
+
+        matrix[4 * row + i] = c * mi - s * mj;
+        matrix[4 * row + j] = s * mi + c * mj;
+    }
+}
+
+template void HandKinematics::computePose<double>(const vector<double> &,
+                                                  HandPose &) const;
+template void HandKinematics::computePose<DofDual>(const vector<DofDual> &,
+                                                   DualHandPose &) const;
+
+template void HandKinematics::computeRotationMatrix<double>(const int *,
+                                                            const double *,
+                                                            double *);
+template void HandKinematics::multiplyMatrices<double, double, double>(
+    const double *, const double *, double *);
@@ -0,0 +1,99 @@
+#ifndef HANDKINEMATICS_H
+#define HANDKINEMATICS_H
+
+#include "binaryStream.hpp"
+#include "dualNumber.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+// All matrices are 4x4, row-major and follow the Maya row vector convention
+// (p' = p * M), so they can be copied straight into an MMatrix
+#define MATRIX_SIZE 16
+
+// Per-evaluation state of the rig - one per thread so that a single
+// HandKinematics can be shared. Templated on the scalar type so that poses
+// can also be evaluated with dual numbers.
+template <typename Scalar> class ScalarHandPose
+{
+public:
+    void resize(int numJoints)
+    {
+        m_rotations.resize(3 * numJoints);
+        m_translations.resize(3 * numJoints);
+        m_world_matrices.resize(MATRIX_SIZE * numJoints);
+    }
+
+    vector<Scalar> m_rotations;      // 3 per joint, radians
+    vector<Scalar> m_translations;   // 3 per joint, world space
+    vector<Scalar> m_world_matrices; // MATRIX_SIZE per joint
+};
+
+typedef ScalarHandPose<double> HandPose;
+typedef ScalarHandPose<DofDual> DualHandPose;
+
+// Not a Maya context - native forward kinematics for the hand rig so that
+// poses can be evaluated without pushing dofs through the dependency graph.
+// Joints must be added parents first. Poses are instantiated for double and
+// DofDual.
+class HandKinematics
+{
+public:
+    HandKinematics();
+    virtual ~HandKinematics();
+
+    int addJoint(int parent, const double *preMatrix, const double *postMatrix,
+                 const int *rotationSequence, const double *rotation,
+                 const double *translation, bool worldTranslation);
+    void addDof(int joint, int dofIndex);
+    void clear();
+
+    void computeDofAxes(const HandPose &pose, vector<double> &axes,
+                        vector<double> &pivots) const;
+    template <typename Scalar>
+    void computePose(const vector<Scalar> &dofs,
+                     ScalarHandPose<Scalar> &pose) const;
+
+    int getDofIndex(int dof) const;
+    int getDofJoint(int dof) const;
+    const vector<int> &getJointDofs(int joint) const;
+    int getJointParent(int joint) const;
+    int getNumDofs() const;
+    int getNumJoints() const;
+
+    bool read(istream &in);
+    void write(ostream &out) const;
+
+    template <typename Scalar>
+    static void computeRotationMatrix(const int *rotationSequence,
+                                      const Scalar *rotation, Scalar *matrix);
+    template <typename Left, typename Right, typename Product>
+    static void multiplyMatrices(const Left *a, const Right *b,
+                                 Product *product);
+
+private:
+    template <typename Scalar>
+    static void applyAxisRotation(int axis, Scalar angle, Scalar *matrix);
+
+    // Joint vars (structure of arrays, indexed by joint)
+
+    int m_num_joints;
+    vector<int> m_parents;
+    vector<int> m_rotation_sequences;   // 3 per joint, axes in applied order
+    vector<double> m_pre_matrices;      // Scale and rotate axis
+    vector<double> m_post_matrices;     // Orient, translate and welded joints
+    vector<double> m_base_rotations;    // 3 per joint, used for locked axes
+    vector<double> m_base_translations; // 3 per joint
+    vector<bool> m_world_translations;
+
+    // Dof vars (indexed by dof vector entry)
+
+    vector<int> m_dof_joints;
+    vector<int> m_dof_indices; // 0-2 rotation, 3-5 translation
+    vector<vector<int>> m_joint_dofs; // All dofs that move a joint
+};
+
+#endif // HANDKINEMATICS_H
@@ -0,0 +1,758 @@
+#include "handSkinning.hpp"
+
+HandSkinning::HandSkinning() : m_bone_bounds_valid(false)
+{
+    m_influence_offsets.push_back(0);
+    m_bone_offsets.push_back(0);
+    m_bound_offsets.push_back(0);
+
+    fill(m_skin_matrix, m_skin_matrix + MATRIX_SIZE, 0.0);
+    m_skin_matrix[0] = m_skin_matrix[5] = m_skin_matrix[10] =
+        m_skin_matrix[15] = 1.0;
+}
+
+HandSkinning::~HandSkinning() {}
+
+void HandSkinning::addInfluence(int joint, double weight,
+                                const double *localPosition,
+                                const double *localNormal)
+{
+    m_influence_joints.push_back(joint);
+    m_influence_weights.push_back(weight);
+
+    m_influence_positions.insert(m_influence_positions.end(), localPosition,
+                                 localPosition + 3);
+    m_influence_normals.insert(m_influence_normals.end(), localNormal,
+                               localNormal + 3);
+}
+
+void HandSkinning::addVertex()
+{
+    m_influence_offsets.push_back(m_influence_joints.size());
+}
+
+// Call once all vertices are added
+void HandSkinning::buildBoneBounds(const HandKinematics &kinematics)
+{
+    int numVertices = getNumVertices();
+    int numJoints = kinematics.getNumJoints();
+
+    // Joint slots, static influences take the last one
+    int numSlots = numJoints + 1;
+
+    // Step 1: Partition vertices by their dominant influence
+
+    vector<vector<int>> slotVertices(numSlots);
+
+    m_bone_bounds_valid = true;
+
+    for (int v = 0; v < numVertices; v++)
+    {
+        int dominantSlot = numJoints;
+        double dominantWeight = 0.0;
+        double weightSum = 0.0;
+
+        for (int i = m_influence_offsets[v]; i < m_influence_offsets[v + 1];
+             i++)
+        {
+            int joint = m_influence_joints[i];
+            double weight = m_influence_weights[i];
+
+            weightSum += weight;
+
+            if (weight > dominantWeight)
+            {
+                dominantWeight = weight;
+                dominantSlot = joint == STATIC_INFLUENCE ? numJoints : joint;
+            }
+        }
+
+        if (abs(weightSum - 1.0) > BONE_WEIGHT_TOLERANCE)
+        {
+            m_bone_bounds_valid = false;
+        }
+
+        slotVertices[dominantSlot].push_back(v);
+    }
+
+    m_bone_offsets.assign(1, 0);
+    m_bone_vertices.clear();
+
+    for (int slot = 0; slot < numSlots; slot++)
+    {
+        if (slotVertices[slot].empty())
+        {
+            continue;
+        }
+
+        m_bone_vertices.insert(m_bone_vertices.end(),
+                               slotVertices[slot].begin(),
+                               slotVertices[slot].end());
+        m_bone_offsets.push_back(m_bone_vertices.size());
+    }
+
+    // Step 2: Bound each bone with one sphere per influencing joint
+
+    int numBones = getNumBones();
+
+    m_bound_offsets.assign(1, 0);
+    m_bound_joints.clear();
+    m_bound_centers.clear();
+    m_bound_radii.clear();
+
+    vector<double> slotMin(3 * numSlots);
+    vector<double> slotMax(3 * numSlots);
+    vector<double> slotRadii(numSlots);
+
+    for (int b = 0; b < numBones; b++)
+    {
+        fill(slotMin.begin(), slotMin.end(), HUGE_VAL);
+        fill(slotMax.begin(), slotMax.end(), -HUGE_VAL);
+        fill(slotRadii.begin(), slotRadii.end(), -1.0);
+
+        // Two passes - box centers first, then radii about them
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int k = m_bone_offsets[b]; k < m_bone_offsets[b + 1]; k++)
+            {
+                int v = m_bone_vertices[k];
+
+                for (int i = m_influence_offsets[v];
+                     i < m_influence_offsets[v + 1]; i++)
+                {
+                    int joint = m_influence_joints[i];
+                    int slot = joint == STATIC_INFLUENCE ? numJoints : joint;
+
+                    double weight = m_influence_weights[i];
+                    const double *q = &m_influence_positions[3 * i];
+
+                    double distanceSquared = 0.0;
+
+                    for (int c = 0; c < 3; c++)
+                    {
+                        double value = q[c] / weight;
+
+                        if (pass == 0)
+                        {
+                            slotMin[3 * slot + c] =
+                                min(slotMin[3 * slot + c], value);
+                            slotMax[3 * slot + c] =
+                                max(slotMax[3 * slot + c], value);
+                            continue;
+                        }
+
+                        double offset =
+                            value - 0.5 * (slotMin[3 * slot + c] +
+                                           slotMax[3 * slot + c]);
+                        distanceSquared += offset * offset;
+                    }
+
+                    if (pass == 1)
+                    {
+                        slotRadii[slot] =
+                            max(slotRadii[slot], sqrt(distanceSquared));
+                    }
+                }
+            }
+        }
+
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            if (slotRadii[slot] < 0.0)
+            {
+                continue;
+            }
+
+            m_bound_joints.push_back(slot < numJoints ? slot
+                                                      : STATIC_INFLUENCE);
+
+            for (int c = 0; c < 3; c++)
+            {
+                m_bound_centers.push_back(
+                    0.5 * (slotMin[3 * slot + c] + slotMax[3 * slot + c]));
+            }
+
+            m_bound_radii.push_back(slotRadii[slot]);
+        }
+
+        m_bound_offsets.push_back(m_bound_joints.size());
+    }
+}
+
+void HandSkinning::clear()
+{
+    m_influence_offsets.assign(1, 0);
+    m_influence_joints.clear();
+    m_influence_weights.clear();
+    m_influence_positions.clear();
+    m_influence_normals.clear();
+
+    m_bone_bounds_valid = false;
+    m_bone_offsets.assign(1, 0);
+    m_bone_vertices.clear();
+    m_bound_offsets.assign(1, 0);
+    m_bound_joints.clear();
+    m_bound_centers.clear();
+    m_bound_radii.clear();
+}
+
+void HandSkinning::accumulatePointGradient(
+    const HandKinematics &kinematics, const HandPose &pose,
+    const vector<double> &dofAxes, const vector<double> &dofPivots,
+    const int *vertices, const double *vertexWeights, int numVertices,
+    const double *positionWeight, const double *normalWeight,
+    vector<double> &grad) const
+{
+    const double *sm = m_skin_matrix;
+
+    // Forward pass: unit world normals per vertex and the interpolated normal
+
+    bool normalUsed =
+        normalWeight[0] != 0.0 || normalWeight[1] != 0.0 ||
+        normalWeight[2] != 0.0;
+
+    vector<double> unitNormals(3 * numVertices, 0.0);
+    vector<double> normalLengths(numVertices, 0.0);
+
+    double pointNormal[3] = {0.0, 0.0, 0.0};
+
+    double skinPosition[3];
+    double skinNormal[3];
+
+    if (normalUsed)
+    {
+        for (int k = 0; k < numVertices; k++)
+        {
+            computeSkinSpaceVertex(pose, vertices[k], skinPosition, skinNormal);
+
+            double *n = &unitNormals[3 * k];
+
+            for (int c = 0; c < 3; c++)
+            {
+                n[c] = skinNormal[0] * sm[c] + skinNormal[1] * sm[4 + c] +
+                       skinNormal[2] * sm[8 + c];
+            }
+
+            double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            if (length > 0.0)
+            {
+                n[0] /= length;
+                n[1] /= length;
+                n[2] /= length;
+            }
+
+            normalLengths[k] = length;
+
+            for (int c = 0; c < 3; c++)
+            {
+                pointNormal[c] += vertexWeights[k] * n[c];
+            }
+        }
+    }
+
+    double pointNormalLength =
+        sqrt(pointNormal[0] * pointNormal[0] + pointNormal[1] * pointNormal[1] +
+             pointNormal[2] * pointNormal[2]);
+
+    if (pointNormalLength == 0.0)
+    {
+        normalUsed = false;
+    }
+
+    // Backward pass: pull the weights back through both normalizations and
+    // the skin matrix into joint world space
+
+    double skinPositionWeight[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+        skinPositionWeight[r] = sm[4 * r] * positionWeight[0] +
+                                sm[4 * r + 1] * positionWeight[1] +
+                                sm[4 * r + 2] * positionWeight[2];
+    }
+
+    double pointNormalWeight[3] = {0.0, 0.0, 0.0};
+
+    if (normalUsed)
+    {
+        double unitPointNormal[3];
+        double alignment = 0.0;
+
+        for (int c = 0; c < 3; c++)
+        {
+            unitPointNormal[c] = pointNormal[c] / pointNormalLength;
+            alignment += normalWeight[c] * unitPointNormal[c];
+        }
+
+        for (int c = 0; c < 3; c++)
+        {
+            pointNormalWeight[c] =
+                (normalWeight[c] - alignment * unitPointNormal[c]) /
+                pointNormalLength;
+        }
+    }
+
+    double vertexNormalWeight[3];
+    double skinNormalWeight[3];
+
+    for (int k = 0; k < numVertices; k++)
+    {
+        int vertex = vertices[k];
+        double vertexWeight = vertexWeights[k];
+
+        bool vertexNormalUsed = normalUsed && normalLengths[k] > 0.0;
+
+        if (vertexNormalUsed)
+        {
+            const double *n = &unitNormals[3 * k];
+
+            double alignment = pointNormalWeight[0] * n[0] +
+                               pointNormalWeight[1] * n[1] +
+                               pointNormalWeight[2] * n[2];
+
+            for (int c = 0; c < 3; c++)
+            {
+                vertexNormalWeight[c] = vertexWeight *
+                                        (pointNormalWeight[c] - alignment * n[c]) /
+                                        normalLengths[k];
+            }
+
+            for (int r = 0; r < 3; r++)
+            {
+                skinNormalWeight[r] = sm[4 * r] * vertexNormalWeight[0] +
+                                      sm[4 * r + 1] * vertexNormalWeight[1] +
+                                      sm[4 * r + 2] * vertexNormalWeight[2];
+            }
+        }
+
+        int influenceStart = m_influence_offsets[vertex];
+        int influenceEnd = m_influence_offsets[vertex + 1];
+
+        for (int i = influenceStart; i < influenceEnd; i++)
+        {
+            int joint = m_influence_joints[i];
+
+            if (joint == STATIC_INFLUENCE)
+            {
+                continue;
+            }
+
+            double weight = m_influence_weights[i];
+
+            const double *q = &m_influence_positions[3 * i];
+            const double *nq = &m_influence_normals[3 * i];
+            const double *world = &pose.m_world_matrices[MATRIX_SIZE * joint];
+
+            double position[3];
+            double normal[3];
+
+            for (int c = 0; c < 3; c++)
+            {
+                position[c] = q[0] * world[c] + q[1] * world[4 + c] +
+                              q[2] * world[8 + c] + weight * world[12 + c];
+                normal[c] = nq[0] * world[c] + nq[1] * world[4 + c] +
+                            nq[2] * world[8 + c];
+            }
+
+            for (int dof : kinematics.getJointDofs(joint))
+            {
+                int dofIndex = kinematics.getDofIndex(dof);
+
+                if (dofIndex > 2) // indicates translation dof
+                {
+                    grad[dof] += vertexWeight * weight *
+                                 skinPositionWeight[dofIndex - 3];
+                    continue;
+                }
+
+                const double *a = &dofAxes[3 * dof];
+                const double *o = &dofPivots[3 * dof];
+
+                // Rotating about the dof axis through its pivot
+                double r[3] = {position[0] - weight * o[0],
+                               position[1] - weight * o[1],
+                               position[2] - weight * o[2]};
+
+                double dPosition[3] = {a[1] * r[2] - a[2] * r[1],
+                                       a[2] * r[0] - a[0] * r[2],
+                                       a[0] * r[1] - a[1] * r[0]};
+
+                grad[dof] += vertexWeight * (skinPositionWeight[0] * dPosition[0] +
+                                             skinPositionWeight[1] * dPosition[1] +
+                                             skinPositionWeight[2] * dPosition[2]);
+
+                if (vertexNormalUsed)
+                {
+                    double dNormal[3] = {a[1] * normal[2] - a[2] * normal[1],
+                                         a[2] * normal[0] - a[0] * normal[2],
+                                         a[0] * normal[1] - a[1] * normal[0]};
+
+                    grad[dof] += skinNormalWeight[0] * dNormal[0] +
+                                 skinNormalWeight[1] * dNormal[1] +
+                                 skinNormalWeight[2] * dNormal[2];
+                }
+            }
+        }
+    }
+}
+
+template <typename Scalar>
+void HandSkinning::computePoint(const ScalarHandPose<Scalar> &pose,
+                                const int *vertices,
+                                const double *vertexWeights, int numVertices,
+                                Scalar *position, Scalar *normal) const
+{
+    Scalar vertexPosition[3];
+    Scalar vertexNormal[3];
+
+    fill(position, position + 3, 0.0);
+    fill(normal, normal + 3, 0.0);
+
+    for (int k = 0; k < numVertices; k++)
+    {
+        computeVertex(pose, vertices[k], vertexPosition, vertexNormal);
+
+        for (int c = 0; c < 3; c++)
+        {
+            position[c] += vertexWeights[k] * vertexPosition[c];
+            normal[c] += vertexWeights[k] * vertexNormal[c];
+        }
+    }
+
+    Scalar length =
+        sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+    if (length > 0.0)
+    {
+        normal[0] /= length;
+        normal[1] /= length;
+        normal[2] /= length;
+    }
+}
+
+// Sorted dofs that can move the interpolated point - the nonzero columns of
+// its Jacobian
+void HandSkinning::collectPointDofs(const HandKinematics &kinematics,
+                                    const int *vertices, int numVertices,
+                                    vector<int> &dofs) const
+{
+    dofs.clear();
+
+    for (int k = 0; k < numVertices; k++)
+    {
+        int vertex = vertices[k];
+
+        for (int i = m_influence_offsets[vertex];
+             i < m_influence_offsets[vertex + 1]; i++)
+        {
+            int joint = m_influence_joints[i];
+
+            if (joint == STATIC_INFLUENCE)
+            {
+                continue;
+            }
+
+            const vector<int> &jointDofs = kinematics.getJointDofs(joint);
+            dofs.insert(dofs.end(), jointDofs.begin(), jointDofs.end());
+        }
+    }
+
+    sort(dofs.begin(), dofs.end());
+    dofs.erase(unique(dofs.begin(), dofs.end()), dofs.end());
+}
+
+// World space AABB of the posed bone spheres, false if the bone is unbounded
+bool HandSkinning::computeBoneBounds(const HandPose &pose, int bone,
+                                     double *boundsMin,
+                                     double *boundsMax) const
+{
+    if (!m_bone_bounds_valid)
+    {
+        return false;
+    }
+
+    const double *sm = m_skin_matrix;
+
+    static const double identity[MATRIX_SIZE] = {1.0, 0.0, 0.0, 0.0,
+                                                 0.0, 1.0, 0.0, 0.0,
+                                                 0.0, 0.0, 1.0, 0.0,
+                                                 0.0, 0.0, 0.0, 1.0};
+
+    fill(boundsMin, boundsMin + 3, HUGE_VAL);
+    fill(boundsMax, boundsMax + 3, -HUGE_VAL);
+
+    for (int k = m_bound_offsets[bone]; k < m_bound_offsets[bone + 1]; k++)
+    {
+        int joint = m_bound_joints[k];
+
+        const double *world =
+            joint == STATIC_INFLUENCE
+                ? identity
+                : &pose.m_world_matrices[MATRIX_SIZE * joint];
+
+        double combined[MATRIX_SIZE];
+        HandKinematics::multiplyMatrices(world, sm, combined);
+
+        const double *center = &m_bound_centers[3 * k];
+        double radius = m_bound_radii[k];
+
+        for (int c = 0; c < 3; c++)
+        {
+            double worldCenter = center[0] * combined[c] +
+                                 center[1] * combined[4 + c] +
+                                 center[2] * combined[8 + c] + combined[12 + c];
+
+            // Extent of the transformed sphere along the world axis
+            double extent =
+                radius * sqrt(combined[c] * combined[c] +
+                              combined[4 + c] * combined[4 + c] +
+                              combined[8 + c] * combined[8 + c]);
+
+            boundsMin[c] = min(boundsMin[c], worldCenter - extent);
+            boundsMax[c] = max(boundsMax[c], worldCenter + extent);
+        }
+    }
+
+    return true;
+}
+
+template <typename Scalar>
+void HandSkinning::computeVertex(const ScalarHandPose<Scalar> &pose,
+                                 int vertex, Scalar *position,
+                                 Scalar *normal) const
+{
+    const double *sm = m_skin_matrix;
+
+    Scalar skinPosition[3];
+    Scalar skinNormal[3];
+
+    computeSkinSpaceVertex(pose, vertex, skinPosition, skinNormal);
+
+    for (int c = 0; c < 3; c++)
+    {
+        position[c] = skinPosition[0] * sm[c] + skinPosition[1] * sm[4 + c] +
+                      skinPosition[2] * sm[8 + c] + sm[12 + c];
+        normal[c] = skinNormal[0] * sm[c] + skinNormal[1] * sm[4 + c] +
+                    skinNormal[2] * sm[8 + c];
+    }
+
+    Scalar length =
+        sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+    if (length > 0.0)
+    {
+        normal[0] /= length;
+        normal[1] /= length;
+        normal[2] /= length;
+    }
+}
+
+// Positions only, as separate x / y / z arrays for batch queries
+template <typename Scalar>
+void HandSkinning::computeVertexPositions(const ScalarHandPose<Scalar> &pose,
+                                          const int *vertices, int numVertices,
+                                          Scalar *xs, Scalar *ys,
+                                          Scalar *zs) const
+{
+    const double *sm = m_skin_matrix;
+
+    for (int k = 0; k < numVertices; k++)
+    {
+        int v = vertices[k];
+
+        Scalar p[3] = {0.0, 0.0, 0.0};
+
+        int influenceStart = m_influence_offsets[v];
+        int influenceEnd = m_influence_offsets[v + 1];
+
+        for (int i = influenceStart; i < influenceEnd; i++)
+        {
+            int joint = m_influence_joints[i];
+
+            const double *q = &m_influence_positions[3 * i];
+
+            if (joint == STATIC_INFLUENCE)
+            {
+                p[0] += q[0];
+                p[1] += q[1];
+                p[2] += q[2];
+
+                continue;
+            }
+
+            double weight = m_influence_weights[i];
+            const Scalar *world = &pose.m_world_matrices[MATRIX_SIZE * joint];
+
+            for (int c = 0; c < 3; c++)
+            {
+                p[c] += q[0] * world[c] + q[1] * world[4 + c] +
+                        q[2] * world[8 + c] + weight * world[12 + c];
+            }
+        }
+
+        xs[k] = p[0] * sm[0] + p[1] * sm[4] + p[2] * sm[8] + sm[12];
+        ys[k] = p[0] * sm[1] + p[1] * sm[5] + p[2] * sm[9] + sm[13];
+        zs[k] = p[0] * sm[2] + p[1] * sm[6] + p[2] * sm[10] + sm[14];
+    }
+}
+
+int HandSkinning::getBoneVertexCount(int bone) const
+{
+    return m_bone_offsets[bone + 1] - m_bone_offsets[bone];
+}
+
+const int *HandSkinning::getBoneVertices(int bone) const
+{
+    return &m_bone_vertices[m_bone_offsets[bone]];
+}
+
+int HandSkinning::getNumBones() const { return m_bone_offsets.size() - 1; }
+
+int HandSkinning::getNumVertices() const
+{
+    return m_influence_offsets.size() - 1;
+}
+
+bool HandSkinning::isEmpty() const { return m_influence_offsets.size() == 1; }
+
+// Replaces the skin and rebuilds the bone bounds against the kinematics
+bool HandSkinning::read(istream &in, const HandKinematics &kinematics)
+{
+    vector<int> offsets;
+    vector<int> joints;
+    vector<double> weights;
+    vector<double> positions;
+    vector<double> normals;
+    vector<double> skinMatrix;
+
+    readBinaryVector(in, offsets);
+    readBinaryVector(in, joints);
+    readBinaryVector(in, weights);
+    readBinaryVector(in, positions);
+    readBinaryVector(in, normals);
+    readBinaryVector(in, skinMatrix);
+
+    size_t numInfluences = joints.size();
+
+    if (!in || offsets.empty() || offsets.front() != 0 ||
+        offsets.back() != (int)numInfluences ||
+        weights.size() != numInfluences ||
+        positions.size() != 3 * numInfluences ||
+        normals.size() != 3 * numInfluences ||
+        skinMatrix.size() != MATRIX_SIZE)
+    {
+        return false;
+    }
+
+    for (size_t i = 1; i < offsets.size(); i++)
+    {
+        if (offsets[i] < offsets[i - 1])
+        {
+            return false;
+        }
+    }
+
+    for (int joint : joints)
+    {
+        if (joint != STATIC_INFLUENCE &&
+            (joint < 0 || joint >= kinematics.getNumJoints()))
+        {
+            return false;
+        }
+    }
+
+    clear();
+
+    m_influence_offsets = move(offsets);
+    m_influence_joints = move(joints);
+    m_influence_weights = move(weights);
+    m_influence_positions = move(positions);
+    m_influence_normals = move(normals);
+
+    setSkinMatrix(skinMatrix.data());
+
+    if (!isEmpty())
+    {
+        buildBoneBounds(kinematics);
+    }
+
+    return true;
+}
+
+void HandSkinning::setSkinMatrix(const double *skinMatrix)
+{
+    copy(skinMatrix, skinMatrix + MATRIX_SIZE, m_skin_matrix);
+}
+
+// Bone bounds are derived, so only the influences are written
+void HandSkinning::write(ostream &out) const
+{
+    vector<double> skinMatrix(m_skin_matrix, m_skin_matrix + MATRIX_SIZE);
+
+    writeBinaryVector(out, m_influence_offsets);
+    writeBinaryVector(out, m_influence_joints);
+    writeBinaryVector(out, m_influence_weights);
+    writeBinaryVector(out, m_influence_positions);
+    writeBinaryVector(out, m_influence_normals);
+    writeBinaryVector(out, skinMatrix);
+}
+
+template <typename Scalar>
+void HandSkinning::computeSkinSpaceVertex(const ScalarHandPose<Scalar> &pose,
+                                          int vertex, Scalar *position,
+                                          Scalar *normal) const
+{
+    fill(position, position + 3, 0.0);
+    fill(normal, normal + 3, 0.0);
+
+    int influenceStart = m_influence_offsets[vertex];
+    int influenceEnd = m_influence_offsets[vertex + 1];
+
+    for (int i = influenceStart; i < influenceEnd; i++)
+    {
+        int joint = m_influence_joints[i];
+
+        const double *q = &m_influence_positions[3 * i];
+        const double *nq = &m_influence_normals[3 * i];
+
+        if (joint == STATIC_INFLUENCE)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                position[c] += q[c];
+                normal[c] += nq[c];
+            }
+
+            continue;
+        }
+
+        double weight = m_influence_weights[i];
+        const Scalar *world = &pose.m_world_matrices[MATRIX_SIZE * joint];
+
+        for (int c = 0; c < 3; c++)
+        {
+            position[c] += q[0] * world[c] + q[1] * world[4 + c] +
+                           q[2] * world[8 + c] + weight * world[12 + c];
+            normal[c] += nq[0] * world[c] + nq[1] * world[4 + c] +
+                         nq[2] * world[8 + c];
+        }
+    }
+}
+
+template void HandSkinning::computePoint<double>(const HandPose &,
+                                                 const int *, const double *,
+                                                 int, double *, double *) const;
+template void HandSkinning::computePoint<DofDual>(const DualHandPose &,
+                                                  const int *, const double *,
+                                                  int, DofDual *,
+                                                  DofDual *) const;
+
+template void HandSkinning::computeVertex<double>(const HandPose &, int,
+                                                  double *, double *) const;
+
+template void HandSkinning::computeVertexPositions<double>(
+    const HandPose &, const int *, int, double *, double *, double *) const;
+template void HandSkinning::computeVertexPositions<DofDual>(
+    const DualHandPose &, const int *, int, DofDual *, DofDual *,
+    DofDual *) const;
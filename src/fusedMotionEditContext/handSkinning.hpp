@@ -0,0 +1,98 @@
+#ifndef HANDSKINNING_H
+#define HANDSKINNING_H
+
+#include "handKinematics.hpp"
+
+// Influences that do not belong to the rig never move
+#define STATIC_INFLUENCE -1
+
+// Bone bounds assume normalized skin weights
+#define BONE_WEIGHT_TOLERANCE 1e-4
+
+// Not a Maya context - native linear blend skinning of the hand mesh driven
+// by HandKinematics poses. Each vertex stores one row of influences with its
+// bind position and normal already expressed in the local frame of the
+// influencing joint (and pre-multiplied by the weight), so a vertex is just
+// a weighted sum of joint world transforms. Posing is instantiated for
+// double and DofDual.
+class HandSkinning
+{
+public:
+    HandSkinning();
+    virtual ~HandSkinning();
+
+    void addInfluence(int joint, double weight, const double *localPosition,
+                      const double *localNormal);
+    void addVertex();
+    void buildBoneBounds(const HandKinematics &kinematics);
+    void clear();
+
+    void accumulatePointGradient(const HandKinematics &kinematics,
+                                 const HandPose &pose,
+                                 const vector<double> &dofAxes,
+                                 const vector<double> &dofPivots,
+                                 const int *vertices,
+                                 const double *vertexWeights, int numVertices,
+                                 const double *positionWeight,
+                                 const double *normalWeight,
+                                 vector<double> &grad) const;
+    template <typename Scalar>
+    void computePoint(const ScalarHandPose<Scalar> &pose, const int *vertices,
+                      const double *vertexWeights, int numVertices,
+                      Scalar *position, Scalar *normal) const;
+    void collectPointDofs(const HandKinematics &kinematics,
+                          const int *vertices, int numVertices,
+                          vector<int> &dofs) const;
+    bool computeBoneBounds(const HandPose &pose, int bone, double *boundsMin,
+                           double *boundsMax) const;
+    template <typename Scalar>
+    void computeVertex(const ScalarHandPose<Scalar> &pose, int vertex,
+                       Scalar *position, Scalar *normal) const;
+    template <typename Scalar>
+    void computeVertexPositions(const ScalarHandPose<Scalar> &pose,
+                                const int *vertices, int numVertices,
+                                Scalar *xs, Scalar *ys, Scalar *zs) const;
+
+    int getBoneVertexCount(int bone) const;
+    const int *getBoneVertices(int bone) const;
+    int getNumBones() const;
+    int getNumVertices() const;
+    bool isEmpty() const;
+
+    bool read(istream &in, const HandKinematics &kinematics);
+
+    void setSkinMatrix(const double *skinMatrix);
+
+    void write(ostream &out) const;
+
+private:
+    template <typename Scalar>
+    void computeSkinSpaceVertex(const ScalarHandPose<Scalar> &pose, int vertex,
+                                Scalar *position, Scalar *normal) const;
+
+    // Influence rows (compressed, one row per vertex)
+
+    vector<int> m_influence_offsets;
+    vector<int> m_influence_joints;
+    vector<double> m_influence_weights;
+    vector<double> m_influence_positions; // 3 per influence
+    vector<double> m_influence_normals;   // 3 per influence
+
+    // Bone vars - vertices partitioned by dominant influence. Each bone keeps
+    // one sphere per influencing joint (in that joint's frame) around the
+    // unweighted influence positions, so the convex hull of the posed spheres
+    // contains every skinned vertex of the bone.
+
+    bool m_bone_bounds_valid;
+    vector<int> m_bone_offsets;
+    vector<int> m_bone_vertices;
+    vector<int> m_bound_offsets;
+    vector<int> m_bound_joints;
+    vector<double> m_bound_centers; // 3 per bound
+    vector<double> m_bound_radii;
+
+    // Constant transform from joint world space to mesh world space
+    double m_skin_matrix[MATRIX_SIZE];
+};
+
+#endif // HANDSKINNING_H
@@ -0,0 +1,184 @@
+#include "levenbergMarquardt.hpp"
+
+LevenbergMarquardt::LevenbergMarquardt(FrameObjective &objective)
+    : m_objective(objective), m_max_iterations(100),
+      m_relative_tolerance(1e-4), m_result(LM_RESULT_MAX_ITERATIONS_REACHED)
+{
+}
+
+LevenbergMarquardt::~LevenbergMarquardt() {}
+
+int LevenbergMarquardt::getResult() const { return m_result; }
+
+// Returns the number of iterations taken
+int LevenbergMarquardt::solve(vector<double> &dofs, double &minObjective)
+{
+    vector<double> noGrad;
+
+    int numDofs = dofs.size();
+
+    double objective =
+        m_objective.computeNormalEquations(dofs, m_hessian, m_gradient);
+    double damping = LM_INITIAL_DAMPING;
+
+    m_result = LM_RESULT_MAX_ITERATIONS_REACHED;
+
+    int iteration = 0;
+
+    while (iteration < m_max_iterations)
+    {
+        iteration++;
+
+        if (!computeStep(damping))
+        {
+            damping *= LM_DAMPING_INCREASE;
+
+            if (damping > LM_MAX_DAMPING)
+            {
+                m_result = LM_RESULT_DAMPING_LIMITED;
+                break;
+            }
+
+            continue;
+        }
+
+        m_candidate = dofs;
+
+        double stepNorm = 0.0;
+        double dofNorm = 0.0;
+
+        for (int i = 0; i < numDofs; i++)
+        {
+            m_candidate[i] += m_step[i];
+
+            stepNorm += m_step[i] * m_step[i];
+            dofNorm += dofs[i] * dofs[i];
+        }
+
+        double candidateObjective =
+            m_objective.computeObjective(m_candidate, noGrad);
+
+        if (!(candidateObjective < objective))
+        {
+            damping *= LM_DAMPING_INCREASE;
+
+            if (damping > LM_MAX_DAMPING)
+            {
+                m_result = LM_RESULT_DAMPING_LIMITED;
+                break;
+            }
+
+            continue;
+        }
+
+        bool xConverged =
+            sqrt(stepNorm) <=
+            m_relative_tolerance * (sqrt(dofNorm) + m_relative_tolerance);
+        bool fConverged = objective - candidateObjective <=
+                          m_relative_tolerance * candidateObjective;
+
+        dofs = m_candidate;
+        damping = max(damping * LM_DAMPING_DECREASE, LM_MIN_DAMPING);
+
+        if (xConverged || fConverged)
+        {
+            m_result =
+                xConverged ? LM_RESULT_XTOL_REACHED : LM_RESULT_FTOL_REACHED;
+            objective = candidateObjective;
+            break;
+        }
+
+        objective =
+            m_objective.computeNormalEquations(dofs, m_hessian, m_gradient);
+    }
+
+    minObjective = objective;
+
+    return iteration;
+}
+
+void LevenbergMarquardt::setMaxIterations(int maxIterations)
+{
+    m_max_iterations = maxIterations;
+}
+
+void LevenbergMarquardt::setRelativeTolerance(double relativeTolerance)
+{
+    m_relative_tolerance = relativeTolerance;
+}
+
+// Solves (H + damping * diag(H)) step = -g with a Cholesky factorization,
+// false if the system is not positive definite
+bool LevenbergMarquardt::computeStep(double damping)
+{
+    int n = m_gradient.size();
+
+    m_factor = m_hessian;
+
+    for (int i = 0; i < n; i++)
+    {
+        double &diagonal = m_factor[n * i + i];
+
+        diagonal += damping * (m_hessian[n * i + i] + LM_DIAGONAL_FLOOR);
+    }
+
+    // Lower triangle holds L
+    for (int j = 0; j < n; j++)
+    {
+        double pivot = m_factor[n * j + j];
+
+        for (int k = 0; k < j; k++)
+        {
+            pivot -= m_factor[n * j + k] * m_factor[n * j + k];
+        }
+
+        if (!(pivot > 0.0))
+        {
+            return false;
+        }
+
+        pivot = sqrt(pivot);
+        m_factor[n * j + j] = pivot;
+
+        for (int i = j + 1; i < n; i++)
+        {
+            double value = m_factor[n * i + j];
+
+            for (int k = 0; k < j; k++)
+            {
+                value -= m_factor[n * i + k] * m_factor[n * j + k];
+            }
+
+            m_factor[n * i + j] = value / pivot;
+        }
+    }
+
+    // Forward then back substitution
+    m_step.resize(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        double value = -m_gradient[i];
+
+        for (int k = 0; k < i; k++)
+        {
+            value -= m_factor[n * i + k] * m_step[k];
+        }
+
+        m_step[i] = value / m_factor[n * i + i];
+    }
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        double value = m_step[i];
+
+        for (int k = i + 1; k < n; k++)
+        {
+            value -= m_factor[n * k + i] * m_step[k];
+        }
+
+        m_step[i] = value / m_factor[n * i + i];
+    }
+
+    return true;
+}
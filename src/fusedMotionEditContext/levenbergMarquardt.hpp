@@ -0,0 +1,56 @@
+#ifndef LEVENBERGMARQUARDT_H
+#define LEVENBERGMARQUARDT_H
+
+#include "frameObjective.hpp"
+
+#define LM_INITIAL_DAMPING 1e-3
+#define LM_MIN_DAMPING 1e-9
+#define LM_MAX_DAMPING 1e9
+#define LM_DAMPING_INCREASE 4.0
+#define LM_DAMPING_DECREASE 0.25
+
+// Keeps the damped system positive definite for dofs nothing depends on
+#define LM_DIAGONAL_FLOOR 1e-6
+
+// Termination codes, same values as the matching nlopt::result
+#define LM_RESULT_FTOL_REACHED 3
+#define LM_RESULT_XTOL_REACHED 4
+#define LM_RESULT_MAX_ITERATIONS_REACHED 5
+#define LM_RESULT_DAMPING_LIMITED -4
+
+// Not a Maya context - Levenberg-Marquardt on the reweighted residuals of a
+// FrameObjective. Each iteration is one linearization, and steps are only
+// accepted if they lower the true objective.
+class LevenbergMarquardt
+{
+public:
+    LevenbergMarquardt(FrameObjective &objective);
+    virtual ~LevenbergMarquardt();
+
+    int getResult() const;
+
+    int solve(vector<double> &dofs, double &minObjective);
+
+    void setMaxIterations(int maxIterations);
+    void setRelativeTolerance(double relativeTolerance);
+
+private:
+    bool computeStep(double damping);
+
+    FrameObjective &m_objective;
+
+    int m_max_iterations;
+    double m_relative_tolerance;
+
+    int m_result; // Of the last solve
+
+    // Scratch vars
+
+    vector<double> m_hessian;
+    vector<double> m_gradient;
+    vector<double> m_factor; // Cholesky factor of the damped hessian
+    vector<double> m_step;
+    vector<double> m_candidate;
+};
+
+#endif // LEVENBERGMARQUARDT_H
@@ -0,0 +1,689 @@
+#include "objectSDF.hpp"
+
+#include <fstream>
+
+ObjectSDF::ObjectSDF() { clear(); }
+
+ObjectSDF::~ObjectSDF() {}
+
+// Vertices are packed xyz in object space, triangles are packed vertex index
+// triples. Every node within the band of a triangle gets its exact distance,
+// which is then propagated to the rest of the grid. The sign comes from ray
+// parity, so the mesh should be closed.
+void ObjectSDF::build(const vector<double> &vertices,
+                      const vector<int> &triangles)
+{
+    clear();
+
+    int numVertices = vertices.size() / 3;
+    int numTriangles = triangles.size() / 3;
+
+    if (numVertices == 0 || numTriangles == 0)
+    {
+        return;
+    }
+
+    double meshMin[3] = {vertices[0], vertices[1], vertices[2]};
+    double meshMax[3] = {vertices[0], vertices[1], vertices[2]};
+
+    for (int v = 1; v < numVertices; v++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            meshMin[a] = min(meshMin[a], vertices[3 * v + a]);
+            meshMax[a] = max(meshMax[a], vertices[3 * v + a]);
+        }
+    }
+
+    double extent = max(meshMax[0] - meshMin[0],
+                        max(meshMax[1] - meshMin[1], meshMax[2] - meshMin[2]));
+
+    if (!(extent > 0.0))
+    {
+        return;
+    }
+
+    m_cell_size = extent / OBJECT_SDF_RESOLUTION;
+    m_band = OBJECT_SDF_BAND_CELLS * m_cell_size;
+
+    // Keeps a band of outside nodes around the mesh on every side
+    double padding = m_band + m_cell_size;
+
+    for (int a = 0; a < 3; a++)
+    {
+        m_origin[a] = meshMin[a] - padding;
+        m_dims[a] = (int)ceil((meshMax[a] - meshMin[a] + 2.0 * padding) /
+                              m_cell_size) +
+                    1;
+    }
+
+    m_distances.assign(m_dims[0] * m_dims[1] * m_dims[2], FLT_MAX);
+
+    for (int t = 0; t < numTriangles; t++)
+    {
+        const double *a = &vertices[3 * triangles[3 * t]];
+        const double *b = &vertices[3 * triangles[3 * t + 1]];
+        const double *c = &vertices[3 * triangles[3 * t + 2]];
+
+        int lo[3];
+        int hi[3];
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double low = min(a[axis], min(b[axis], c[axis])) - m_band;
+            double high = max(a[axis], max(b[axis], c[axis])) + m_band;
+
+            lo[axis] = max(0, (int)floor((low - m_origin[axis]) / m_cell_size));
+            hi[axis] = min(m_dims[axis] - 1,
+                           (int)ceil((high - m_origin[axis]) / m_cell_size));
+        }
+
+        double node[3];
+
+        for (int k = lo[2]; k <= hi[2]; k++)
+        {
+            node[2] = m_origin[2] + k * m_cell_size;
+
+            for (int j = lo[1]; j <= hi[1]; j++)
+            {
+                node[1] = m_origin[1] + j * m_cell_size;
+
+                float *row = &m_distances[m_dims[0] * (j + m_dims[1] * k)];
+
+                for (int i = lo[0]; i <= hi[0]; i++)
+                {
+                    node[0] = m_origin[0] + i * m_cell_size;
+
+                    float distance =
+                        (float)computeTriangleDistance(node, a, b, c);
+
+                    row[i] = min(row[i], distance);
+                }
+            }
+        }
+    }
+
+    propagateDistances();
+
+    vector<char> inside;
+    computeInsideNodes(vertices, triangles, inside);
+
+    for (int n = 0; n < m_distances.size(); n++)
+    {
+        if (inside[n])
+        {
+            m_distances[n] = -m_distances[n];
+        }
+    }
+
+    m_mesh_hash = computeMeshHash(vertices, triangles);
+}
+
+void ObjectSDF::clear()
+{
+    fill(m_origin, m_origin + 3, 0.0);
+    fill(m_dims, m_dims + 3, 0);
+
+    m_cell_size = 0.0;
+    m_band = 0.0;
+    m_distances.clear();
+    m_mesh_hash = 0;
+}
+
+// Gradient is chained back to world space
+double ObjectSDF::computeDistance(const double *inverse, const double *point,
+                                  double *gradient) const
+{
+    const double *t = inverse;
+
+    double local[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+        local[r] = t[4 * r] * point[0] + t[4 * r + 1] * point[1] +
+                   t[4 * r + 2] * point[2] + t[4 * r + 3];
+    }
+
+    double localGradient[3];
+    double distance = sampleLocal(local, localGradient);
+
+    for (int c = 0; c < 3; c++)
+    {
+        gradient[c] = localGradient[0] * t[c] + localGradient[1] * t[4 + c] +
+                      localGradient[2] * t[8 + c];
+    }
+
+    return distance;
+}
+
+// Sum of -min(sdf, 0) over all points, as BoxSDF::computePenetration
+double ObjectSDF::computePenetration(const double *inverse, const double *xs,
+                                     const double *ys, const double *zs,
+                                     int numPoints,
+                                     vector<int> *penetratingPoints) const
+{
+    const double *t = inverse;
+
+    double penetration = 0.0;
+    double local[3];
+
+    for (int p = 0; p < numPoints; p++)
+    {
+        for (int r = 0; r < 3; r++)
+        {
+            local[r] = t[4 * r] * xs[p] + t[4 * r + 1] * ys[p] +
+                       t[4 * r + 2] * zs[p] + t[4 * r + 3];
+        }
+
+        double distance = sampleLocal(local, nullptr);
+
+        if (distance < 0.0)
+        {
+            penetration -= distance;
+
+            if (penetratingPoints)
+            {
+                penetratingPoints->push_back(p);
+            }
+        }
+    }
+
+    return penetration;
+}
+
+uint64_t ObjectSDF::getMeshHash() const { return m_mesh_hash; }
+
+bool ObjectSDF::isEmpty() const { return m_distances.empty(); }
+
+// Fails without touching the grid unless the file was built from a mesh with
+// the same hash
+bool ObjectSDF::load(const string &filename, uint64_t meshHash)
+{
+    ifstream file(filename, ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    return read(file, &meshHash);
+}
+
+// Conservative - tests the world box's local bounds against the grid inset by
+// the band, which still contains the whole mesh
+bool ObjectSDF::overlapsBounds(const double *inverse, const double *boundsMin,
+                               const double *boundsMax) const
+{
+    if (isEmpty())
+    {
+        return false;
+    }
+
+    const double *t = inverse;
+
+    for (int r = 0; r < 3; r++)
+    {
+        double localMin = t[4 * r + 3];
+        double localMax = t[4 * r + 3];
+
+        for (int c = 0; c < 3; c++)
+        {
+            double low = t[4 * r + c] * boundsMin[c];
+            double high = t[4 * r + c] * boundsMax[c];
+
+            localMin += min(low, high);
+            localMax += max(low, high);
+        }
+
+        double gridMin = m_origin[r] + m_band;
+        double gridMax = m_origin[r] + (m_dims[r] - 1) * m_cell_size - m_band;
+
+        if (localMax < gridMin || localMin > gridMax)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Fails without touching the grid on a bad header, or if meshHash is given
+// and the grid was built from a different mesh
+bool ObjectSDF::read(istream &in, const uint64_t *meshHash)
+{
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t hash = 0;
+    int32_t dims[3] = {0, 0, 0};
+    double origin[3];
+    double cellSize;
+    double band;
+
+    in.read((char *)&magic, sizeof(magic));
+    in.read((char *)&version, sizeof(version));
+    in.read((char *)&hash, sizeof(hash));
+    in.read((char *)dims, sizeof(dims));
+    in.read((char *)origin, sizeof(origin));
+    in.read((char *)&cellSize, sizeof(cellSize));
+    in.read((char *)&band, sizeof(band));
+
+    if (!in || magic != OBJECT_SDF_FILE_MAGIC ||
+        version != OBJECT_SDF_FILE_VERSION ||
+        (meshHash != nullptr && hash != *meshHash))
+    {
+        return false;
+    }
+
+    // Grids are never much larger than the resolution along any axis
+    for (int a = 0; a < 3; a++)
+    {
+        if (dims[a] < 2 || dims[a] > 2 * OBJECT_SDF_RESOLUTION)
+        {
+            return false;
+        }
+    }
+
+    vector<float> distances((size_t)dims[0] * dims[1] * dims[2]);
+
+    in.read((char *)distances.data(), distances.size() * sizeof(float));
+
+    if (!in)
+    {
+        return false;
+    }
+
+    copy(origin, origin + 3, m_origin);
+    copy(dims, dims + 3, m_dims);
+
+    m_cell_size = cellSize;
+    m_band = band;
+    m_distances = move(distances);
+    m_mesh_hash = hash;
+
+    return true;
+}
+
+bool ObjectSDF::save(const string &filename) const
+{
+    if (isEmpty())
+    {
+        return false;
+    }
+
+    ofstream file(filename, ios::binary | ios::trunc);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    return write(file);
+}
+
+bool ObjectSDF::write(ostream &out) const
+{
+    if (isEmpty())
+    {
+        return false;
+    }
+
+    uint32_t magic = OBJECT_SDF_FILE_MAGIC;
+    uint32_t version = OBJECT_SDF_FILE_VERSION;
+    int32_t dims[3] = {m_dims[0], m_dims[1], m_dims[2]};
+
+    out.write((const char *)&magic, sizeof(magic));
+    out.write((const char *)&version, sizeof(version));
+    out.write((const char *)&m_mesh_hash, sizeof(m_mesh_hash));
+    out.write((const char *)dims, sizeof(dims));
+    out.write((const char *)m_origin, sizeof(m_origin));
+    out.write((const char *)&m_cell_size, sizeof(m_cell_size));
+    out.write((const char *)&m_band, sizeof(m_band));
+    out.write((const char *)m_distances.data(),
+              m_distances.size() * sizeof(float));
+
+    return (bool)out;
+}
+
+// FNV-1a over the mesh and the grid parameters, so a cached grid is rebuilt
+// whenever either changes
+uint64_t ObjectSDF::computeMeshHash(const vector<double> &vertices,
+                                    const vector<int> &triangles)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    auto mix = [&hash](const void *data, size_t size)
+    {
+        const unsigned char *bytes = (const unsigned char *)data;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    int parameters[3] = {OBJECT_SDF_RESOLUTION, OBJECT_SDF_BAND_CELLS,
+                         OBJECT_SDF_FILE_VERSION};
+
+    mix(vertices.data(), vertices.size() * sizeof(double));
+    mix(triangles.data(), triangles.size() * sizeof(int));
+    mix(parameters, sizeof(parameters));
+
+    return hash;
+}
+
+// Casts a ray along +x through every (y, z) node column and fills the nodes
+// behind an odd number of crossings. Columns are nudged off the node lattice
+// by a fraction of a cell so rays do not graze vertices or edges.
+void ObjectSDF::computeInsideNodes(const vector<double> &vertices,
+                                   const vector<int> &triangles,
+                                   vector<char> &inside) const
+{
+    inside.assign(m_distances.size(), 0);
+
+    double offsetY = 0.0123456789 * m_cell_size;
+    double offsetZ = 0.0314159265 * m_cell_size;
+
+    vector<vector<double>> crossings(m_dims[1] * m_dims[2]);
+
+    int numTriangles = triangles.size() / 3;
+
+    for (int t = 0; t < numTriangles; t++)
+    {
+        const double *a = &vertices[3 * triangles[3 * t]];
+        const double *b = &vertices[3 * triangles[3 * t + 1]];
+        const double *c = &vertices[3 * triangles[3 * t + 2]];
+
+        double det = (b[1] - a[1]) * (c[2] - a[2]) -
+                     (c[1] - a[1]) * (b[2] - a[2]);
+
+        if (det == 0.0) // Parallel to the rays
+        {
+            continue;
+        }
+
+        double lowY = min(a[1], min(b[1], c[1])) - offsetY - m_origin[1];
+        double highY = max(a[1], max(b[1], c[1])) - offsetY - m_origin[1];
+        double lowZ = min(a[2], min(b[2], c[2])) - offsetZ - m_origin[2];
+        double highZ = max(a[2], max(b[2], c[2])) - offsetZ - m_origin[2];
+
+        int loJ = max(0, (int)ceil(lowY / m_cell_size));
+        int hiJ = min(m_dims[1] - 1, (int)floor(highY / m_cell_size));
+        int loK = max(0, (int)ceil(lowZ / m_cell_size));
+        int hiK = min(m_dims[2] - 1, (int)floor(highZ / m_cell_size));
+
+        for (int k = loK; k <= hiK; k++)
+        {
+            double dz = m_origin[2] + k * m_cell_size + offsetZ - a[2];
+
+            for (int j = loJ; j <= hiJ; j++)
+            {
+                double dy = m_origin[1] + j * m_cell_size + offsetY - a[1];
+
+                double w1 = (dy * (c[2] - a[2]) - (c[1] - a[1]) * dz) / det;
+                double w2 = ((b[1] - a[1]) * dz - dy * (b[2] - a[2])) / det;
+
+                if (w1 < 0.0 || w2 < 0.0 || w1 + w2 > 1.0)
+                {
+                    continue;
+                }
+
+                double x = a[0] + w1 * (b[0] - a[0]) + w2 * (c[0] - a[0]);
+
+                crossings[j + m_dims[1] * k].push_back(x);
+            }
+        }
+    }
+
+    for (int column = 0; column < crossings.size(); column++)
+    {
+        vector<double> &columnCrossings = crossings[column];
+
+        if (columnCrossings.empty())
+        {
+            continue;
+        }
+
+        sort(columnCrossings.begin(), columnCrossings.end());
+
+        char *row = &inside[m_dims[0] * column];
+
+        int numBehind = 0;
+
+        for (int i = 0; i < m_dims[0]; i++)
+        {
+            double x = m_origin[0] + i * m_cell_size;
+
+            while (numBehind < columnCrossings.size() &&
+                   columnCrossings[numBehind] < x)
+            {
+                numBehind++;
+            }
+
+            row[i] = numBehind % 2;
+        }
+    }
+}
+
+// Two chamfer sweeps over the 26 neighbourhood, so that deep penetrations
+// still have a gradient. Overestimates by a few percent away from the band.
+void ObjectSDF::propagateDistances()
+{
+    // By number of offset axes
+    float steps[4] = {0.0f, (float)m_cell_size,
+                      (float)(sqrt(2.0) * m_cell_size),
+                      (float)(sqrt(3.0) * m_cell_size)};
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // Forward sweeps read the neighbours before the node, backward sweeps
+        // the ones after it
+        int direction = pass == 0 ? 1 : -1;
+
+        int begin[3];
+        int end[3];
+
+        for (int a = 0; a < 3; a++)
+        {
+            begin[a] = pass == 0 ? 0 : m_dims[a] - 1;
+            end[a] = pass == 0 ? m_dims[a] : -1;
+        }
+
+        for (int k = begin[2]; k != end[2]; k += direction)
+        {
+            for (int j = begin[1]; j != end[1]; j += direction)
+            {
+                for (int i = begin[0]; i != end[0]; i += direction)
+                {
+                    float &distance =
+                        m_distances[i + m_dims[0] * (j + m_dims[1] * k)];
+
+                    for (int dk = -1; dk <= 0; dk++)
+                    {
+                        for (int dj = -1; dj <= (dk < 0 ? 1 : 0); dj++)
+                        {
+                            int maxDi = (dk < 0 || dj < 0) ? 1 : -1;
+
+                            for (int di = -1; di <= maxDi; di++)
+                            {
+                                int ni = i + direction * di;
+                                int nj = j + direction * dj;
+                                int nk = k + direction * dk;
+
+                                if (ni < 0 || ni >= m_dims[0] || nj < 0 ||
+                                    nj >= m_dims[1] || nk < 0 ||
+                                    nk >= m_dims[2])
+                                {
+                                    continue;
+                                }
+
+                                float neighbour =
+                                    m_distances[ni + m_dims[0] *
+                                                         (nj + m_dims[1] * nk)];
+
+                                distance =
+                                    min(distance, neighbour + steps[abs(di) +
+                                                                    abs(dj) +
+                                                                    abs(dk)]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Trilinear interpolation of the node distances. Points off the grid are
+// further than the band from the mesh. localGradient may be null.
+double ObjectSDF::sampleLocal(const double *local,
+                              double *localGradient) const
+{
+    int base[3];
+    double f[3];
+
+    for (int a = 0; a < 3; a++)
+    {
+        double u = (local[a] - m_origin[a]) / m_cell_size;
+
+        if (!(u >= 0.0 && u <= m_dims[a] - 1)) // Also rejects NaN
+        {
+            if (localGradient)
+            {
+                fill(localGradient, localGradient + 3, 0.0);
+            }
+
+            return m_band;
+        }
+
+        base[a] = min((int)u, m_dims[a] - 2);
+        f[a] = u - base[a];
+    }
+
+    int strides[3] = {1, m_dims[0], m_dims[0] * m_dims[1]};
+
+    const float *corner0 =
+        &m_distances[base[0] + strides[1] * base[1] + strides[2] * base[2]];
+
+    double distance = 0.0;
+    double gradient[3] = {0.0, 0.0, 0.0};
+
+    for (int corner = 0; corner < 8; corner++)
+    {
+        int offset = 0;
+        double weights[3];
+
+        for (int a = 0; a < 3; a++)
+        {
+            bool upper = corner & (1 << a);
+
+            offset += upper ? strides[a] : 0;
+            weights[a] = upper ? f[a] : 1.0 - f[a];
+        }
+
+        double value = corner0[offset];
+
+        distance += value * weights[0] * weights[1] * weights[2];
+
+        for (int a = 0; a < 3; a++)
+        {
+            double sign = (corner & (1 << a)) ? 1.0 : -1.0;
+
+            gradient[a] += sign * value * weights[(a + 1) % 3] *
+                           weights[(a + 2) % 3];
+        }
+    }
+
+    if (localGradient)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            localGradient[a] = gradient[a] / m_cell_size;
+        }
+    }
+
+    return distance;
+}
+
+// Closest point on the triangle by Voronoi region, as in Ericson's Real-Time
+// Collision Detection
+double ObjectSDF::computeTriangleDistance(const double *p, const double *a,
+                                          const double *b, const double *c)
+{
+    auto dot = [](const double *u, const double *v)
+    { return u[0] * v[0] + u[1] * v[1] + u[2] * v[2]; };
+
+    double ab[3], ac[3], ap[3], bp[3], cp[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        ab[i] = b[i] - a[i];
+        ac[i] = c[i] - a[i];
+        ap[i] = p[i] - a[i];
+        bp[i] = p[i] - b[i];
+        cp[i] = p[i] - c[i];
+    }
+
+    double d1 = dot(ab, ap);
+    double d2 = dot(ac, ap);
+    double d3 = dot(ab, bp);
+    double d4 = dot(ac, bp);
+    double d5 = dot(ab, cp);
+    double d6 = dot(ac, cp);
+
+    double v;
+    double w;
+
+    double vc = d1 * d4 - d3 * d2;
+    double vb = d5 * d2 - d1 * d6;
+    double va = d3 * d6 - d5 * d4;
+
+    if (d1 <= 0.0 && d2 <= 0.0) // Vertex a
+    {
+        v = 0.0;
+        w = 0.0;
+    }
+    else if (d3 >= 0.0 && d4 <= d3) // Vertex b
+    {
+        v = 1.0;
+        w = 0.0;
+    }
+    else if (d6 >= 0.0 && d5 <= d6) // Vertex c
+    {
+        v = 0.0;
+        w = 1.0;
+    }
+    else if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) // Edge ab
+    {
+        v = d1 / (d1 - d3);
+        w = 0.0;
+    }
+    else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) // Edge ac
+    {
+        v = 0.0;
+        w = d2 / (d2 - d6);
+    }
+    else if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) // Edge bc
+    {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        v = 1.0 - w;
+    }
+    else // Face
+    {
+        double denominator = 1.0 / (va + vb + vc);
+
+        v = vb * denominator;
+        w = vc * denominator;
+    }
+
+    double distanceSquared = 0.0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        double delta = ap[i] - v * ab[i] - w * ac[i];
+
+        distanceSquared += delta * delta;
+    }
+
+    return sqrt(distanceSquared);
+}
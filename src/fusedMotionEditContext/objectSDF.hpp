@@ -0,0 +1,80 @@
+#ifndef OBJECTSDF_H
+#define OBJECTSDF_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define OBJECT_SDF_RESOLUTION 64 // Cells along the longest side of the mesh
+#define OBJECT_SDF_BAND_CELLS 4  // Exact distances this close to the surface
+
+#define OBJECT_SDF_FILE_MAGIC 0x4644534f // "OSDF"
+#define OBJECT_SDF_FILE_VERSION 1
+
+// Not a Maya context - signed distance to a closed triangle mesh, sampled on a
+// regular grid in the mesh's object space. Distances are exact within a
+// narrow band around the surface and propagated beyond it, negative inside.
+// Queries take world points and the object's inverse transform in the same
+// layout as BoxSDF, and interpolate trilinearly, so they never touch the
+// mesh. The grid is shared read-only between threads.
+class ObjectSDF
+{
+public:
+    ObjectSDF();
+    virtual ~ObjectSDF();
+
+    void build(const vector<double> &vertices, const vector<int> &triangles);
+    void clear();
+
+    double computeDistance(const double *inverse, const double *point,
+                           double *gradient) const;
+    double computePenetration(const double *inverse, const double *xs,
+                              const double *ys, const double *zs,
+                              int numPoints,
+                              vector<int> *penetratingPoints) const;
+
+    uint64_t getMeshHash() const;
+
+    bool isEmpty() const;
+
+    bool load(const string &filename, uint64_t meshHash);
+
+    bool overlapsBounds(const double *inverse, const double *boundsMin,
+                        const double *boundsMax) const;
+
+    bool read(istream &in, const uint64_t *meshHash = nullptr);
+
+    bool save(const string &filename) const;
+
+    bool write(ostream &out) const;
+
+    static uint64_t computeMeshHash(const vector<double> &vertices,
+                                    const vector<int> &triangles);
+
+private:
+    void computeInsideNodes(const vector<double> &vertices,
+                            const vector<int> &triangles,
+                            vector<char> &inside) const;
+    void propagateDistances();
+    double sampleLocal(const double *local, double *localGradient) const;
+
+    static double computeTriangleDistance(const double *p, const double *a,
+                                          const double *b, const double *c);
+
+    double m_origin[3]; // Object space position of node (0, 0, 0)
+    double m_cell_size;
+    double m_band;
+    int m_dims[3]; // Nodes per axis
+    vector<float> m_distances; // x fastest
+
+    uint64_t m_mesh_hash; // Of the mesh the grid was built from
+};
+
+#endif // OBJECTSDF_H
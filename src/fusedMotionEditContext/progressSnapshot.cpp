@@ -0,0 +1,79 @@
+#include "progressSnapshot.hpp"
+
+ProgressSnapshot::ProgressSnapshot() { reset(); }
+
+ProgressSnapshot::~ProgressSnapshot() {}
+
+const vector<double> &ProgressSnapshot::getDofs() const { return m_dofs; }
+
+int ProgressSnapshot::getNumEvaluations() const { return m_num_evaluations; }
+
+double ProgressSnapshot::getObjective() const { return m_objective; }
+
+void ProgressSnapshot::getWeightedErrors(double &markerError,
+                                         double &contactError,
+                                         double &intersectionError,
+                                         double &priorError) const
+{
+    markerError = m_weighted_marker_error;
+    contactError = m_weighted_contact_error;
+    intersectionError = m_weighted_intersection_error;
+    priorError = m_weighted_prior_error;
+}
+
+// Rate in redraws per second, 0 redraws on every improvement
+bool ProgressSnapshot::isRedrawDue(double rate) const
+{
+    if (!m_improved)
+    {
+        return false;
+    }
+
+    return rate <= 0.0 || SolveTelemetry::secondsSince(m_last_redraw) >=
+                              1.0 / rate;
+}
+
+void ProgressSnapshot::markDrawn()
+{
+    m_improved = false;
+    m_last_redraw = SolveTelemetry::now();
+}
+
+void ProgressSnapshot::publish(const vector<double> &dofs,
+                               double markerError, double contactError,
+                               double intersectionError, double priorError)
+{
+    m_num_evaluations++;
+
+    double objective =
+        markerError + contactError + intersectionError + priorError;
+
+    if (objective >= m_objective)
+    {
+        return;
+    }
+
+    m_dofs = dofs;
+    m_objective = objective;
+    m_weighted_marker_error = markerError;
+    m_weighted_contact_error = contactError;
+    m_weighted_intersection_error = intersectionError;
+    m_weighted_prior_error = priorError;
+
+    m_improved = true;
+}
+
+// The first improvement after a reset is drawn straight away
+void ProgressSnapshot::reset()
+{
+    m_dofs.clear();
+    m_objective = numeric_limits<double>::infinity();
+    m_weighted_marker_error = 0.0;
+    m_weighted_contact_error = 0.0;
+    m_weighted_intersection_error = 0.0;
+    m_weighted_prior_error = 0.0;
+
+    m_num_evaluations = 0;
+    m_improved = false;
+    m_last_redraw = TelemetryClock();
+}
@@ -0,0 +1,49 @@
+#ifndef PROGRESSSNAPSHOT_H
+#define PROGRESSSNAPSHOT_H
+
+#include "solveTelemetry.hpp"
+
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+// Not a Maya context - best-so-far state of a running solve. The solver
+// publishes every evaluation, which only costs a comparison unless it
+// improves on the best, and the display is redrawn from it at a fixed rate
+// so that watching progress does not scale with the evaluation count.
+class ProgressSnapshot
+{
+public:
+    ProgressSnapshot();
+    virtual ~ProgressSnapshot();
+
+    const vector<double> &getDofs() const;
+    int getNumEvaluations() const;
+    double getObjective() const;
+    void getWeightedErrors(double &markerError, double &contactError,
+                           double &intersectionError,
+                           double &priorError) const;
+
+    bool isRedrawDue(double rate) const;
+    void markDrawn();
+
+    void publish(const vector<double> &dofs, double markerError,
+                 double contactError, double intersectionError,
+                 double priorError);
+    void reset();
+
+private:
+    vector<double> m_dofs;
+    double m_objective;
+    double m_weighted_marker_error;
+    double m_weighted_contact_error;
+    double m_weighted_intersection_error;
+    double m_weighted_prior_error;
+
+    int m_num_evaluations; // Published since the last reset
+    bool m_improved;       // Since the last redraw
+    TelemetryClock m_last_redraw;
+};
+
+#endif // PROGRESSSNAPSHOT_H
@@ -0,0 +1,155 @@
+#include "rigKeyframeSink.hpp"
+
+static const char *RIG_KEYFRAME_CHANNEL_NAMES[RIG_KEYFRAME_CHANNELS] = {
+    "rotateX", "rotateY", "rotateZ", "translateX", "translateY", "translateZ"};
+
+RigKeyframeSink::RigKeyframeSink() {}
+
+RigKeyframeSink::~RigKeyframeSink() {}
+
+// Samples the current (not necessarily keyed) joint values as the given frame
+MStatus RigKeyframeSink::addFrame(int frame, MTime::Unit unit)
+{
+    MStatus status;
+
+    int jointIndex = -1;
+
+    double rotation[3];
+    MVector translation;
+
+    for (int i = 0; i < m_dof_mappings.size(); i++)
+    {
+        pair<int, int> indices = m_dof_mappings[i];
+
+        // Dofs of the same joint are contiguous
+        if (indices.first != jointIndex)
+        {
+            jointIndex = indices.first;
+
+            MFnIkJoint fnJoint(m_joints[jointIndex], &status);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            MTransformationMatrix::RotationOrder order;
+
+            status = fnJoint.getRotation(rotation, order);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+
+            translation = fnJoint.getTranslation(MSpace::kTransform, &status);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+
+        int dofIndex = indices.second;
+
+        double value = dofIndex > 2 ? translation[dofIndex - 3]
+                                    : rotation[dofIndex];
+
+        status = m_dof_values[i].append(value);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    status = m_times.append(MTime((double)frame, unit));
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
+
+void RigKeyframeSink::clear()
+{
+    m_times.clear();
+
+    for (MDoubleArray &values : m_dof_values)
+    {
+        values.clear();
+    }
+}
+
+// Replaces any existing keys at the collected frames and keeps all others,
+// like setKeyframe
+MStatus RigKeyframeSink::commit()
+{
+    MStatus status;
+
+    if (m_times.length() == 0)
+    {
+        return MS::kSuccess;
+    }
+
+    for (int i = 0; i < m_dof_mappings.size(); i++)
+    {
+        pair<int, int> indices = m_dof_mappings[i];
+
+        MFnIkJoint fnJoint(m_joints[indices.first], &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        MPlug plug = fnJoint.findPlug(
+            RIG_KEYFRAME_CHANNEL_NAMES[indices.second], false, &status);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        // setKeyframe skips these too
+        if (plug.isLocked())
+        {
+            continue;
+        }
+
+        MFnAnimCurve fnCurve;
+
+        status = getChannelCurve(plug, fnCurve);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        // Clear the collected frames first, and merge so that keys on other
+        // frames survive
+        for (int t = 0; t < m_times.length(); t++)
+        {
+            unsigned int keyIndex;
+
+            if (fnCurve.find(m_times[t], keyIndex))
+            {
+                status = fnCurve.remove(keyIndex);
+                CHECK_MSTATUS_AND_RETURN_IT(status);
+            }
+        }
+
+        status = fnCurve.addKeys(&m_times, &m_dof_values[i],
+                                 MFnAnimCurve::kTangentGlobal,
+                                 MFnAnimCurve::kTangentGlobal, true);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+    }
+
+    clear();
+
+    return MS::kSuccess;
+}
+
+int RigKeyframeSink::getNumFrames() const { return m_times.length(); }
+
+void RigKeyframeSink::setRig(const MDagPathArray &joints,
+                             const vector<pair<int, int>> &dofMappings)
+{
+    m_joints = joints;
+    m_dof_mappings = dofMappings;
+
+    m_dof_values.assign(dofMappings.size(), MDoubleArray());
+    m_times.clear();
+}
+
+MStatus RigKeyframeSink::getChannelCurve(MPlug &plug, MFnAnimCurve &fnCurve)
+{
+    MStatus status;
+
+    MObjectArray curves;
+
+    bool animated = MAnimUtil::findAnimation(plug, curves, &status);
+
+    if (animated && curves.length() > 0)
+    {
+        status = fnCurve.setObject(curves[0]);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+
+        return MS::kSuccess;
+    }
+
+    fnCurve.create(plug, NULL, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    return MS::kSuccess;
+}
@@ -0,0 +1,49 @@
+#ifndef RIGKEYFRAMESINK_H
+#define RIGKEYFRAMESINK_H
+
+#include <maya/MAnimUtil.h>
+#include <maya/MDagPathArray.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MFnAnimCurve.h>
+#include <maya/MFnIkJoint.h>
+#include <maya/MObjectArray.h>
+#include <maya/MPlug.h>
+#include <maya/MTimeArray.h>
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Rotate XYZ followed by translate XYZ, matching the dof index layout
+#define RIG_KEYFRAME_CHANNELS 6
+
+// Not a Maya context - collects rig joint values for many frames and writes
+// them to the joints' anim curves in one batch, without MEL or time changes.
+// Only rig dof channels are keyed. Frames must be added in increasing order.
+class RigKeyframeSink
+{
+public:
+    RigKeyframeSink();
+    virtual ~RigKeyframeSink();
+
+    MStatus addFrame(int frame, MTime::Unit unit);
+    void clear();
+    MStatus commit();
+
+    int getNumFrames() const;
+
+    void setRig(const MDagPathArray &joints,
+                const vector<pair<int, int>> &dofMappings);
+
+private:
+    MStatus getChannelCurve(MPlug &plug, MFnAnimCurve &fnCurve);
+
+    MDagPathArray m_joints;
+    vector<pair<int, int>> m_dof_mappings;
+
+    MTimeArray m_times;
+    vector<MDoubleArray> m_dof_values;
+};
+
+#endif // RIGKEYFRAMESINK_H
@@ -0,0 +1,124 @@
+#include "solveTelemetry.hpp"
+
+#include "JSONUtils.hpp"
+
+#include <fstream>
+
+FrameTelemetry::FrameTelemetry()
+    : frame(0), numObjectiveEvaluations(0), numGradientEvaluations(0),
+      kinematicsTime(0.0), priorTime(0.0), contactTime(0.0), markerTime(0.0),
+      intersectionTime(0.0), sceneTime(0.0), solveTime(0.0), resultCode(0),
+      finalObjective(0.0)
+{
+}
+
+void FrameTelemetry::addTermTimes(const FrameTelemetry &other)
+{
+    kinematicsTime += other.kinematicsTime;
+    priorTime += other.priorTime;
+    contactTime += other.contactTime;
+    markerTime += other.markerTime;
+    intersectionTime += other.intersectionTime;
+}
+
+SolveTelemetry::SolveTelemetry() {}
+
+SolveTelemetry::~SolveTelemetry() {}
+
+void SolveTelemetry::addFrame(const FrameTelemetry &frameTelemetry)
+{
+    m_frames.push_back(frameTelemetry);
+}
+
+void SolveTelemetry::clear() { m_frames.clear(); }
+
+int SolveTelemetry::getNumFrames() const { return m_frames.size(); }
+
+bool SolveTelemetry::writeCsv(const string &filename) const
+{
+    ofstream file(filename);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "frame,objective_evaluations,gradient_evaluations,"
+            "kinematics_time,prior_time,contact_time,marker_time,"
+            "intersection_time,scene_time,solve_time,result,objective"
+         << endl;
+
+    for (const FrameTelemetry &entry : m_frames)
+    {
+        file << entry.frame << "," << entry.numObjectiveEvaluations << ","
+             << entry.numGradientEvaluations << "," << entry.kinematicsTime
+             << "," << entry.priorTime << "," << entry.contactTime << ","
+             << entry.markerTime << "," << entry.intersectionTime << ","
+             << entry.sceneTime << "," << entry.solveTime << ","
+             << entry.resultCode << "," << entry.finalObjective << endl;
+    }
+
+    return file.good();
+}
+
+// writeJSON reports no errors, so the file is truncated up front to check
+// that it opens, and read back to check that it was written
+bool SolveTelemetry::writeJson(const string &filename) const
+{
+    ofstream file(filename);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.close();
+
+    Document d;
+    d.SetObject();
+
+    Document::AllocatorType &allocator = d.GetAllocator();
+
+    Value frames(kArrayType);
+
+    for (const FrameTelemetry &entry : m_frames)
+    {
+        Value frameData(kObjectType);
+
+        frameData.AddMember("frame", entry.frame, allocator);
+        frameData.AddMember("objectiveEvaluations",
+                            entry.numObjectiveEvaluations, allocator);
+        frameData.AddMember("gradientEvaluations",
+                            entry.numGradientEvaluations, allocator);
+        frameData.AddMember("kinematicsTime", entry.kinematicsTime, allocator);
+        frameData.AddMember("priorTime", entry.priorTime, allocator);
+        frameData.AddMember("contactTime", entry.contactTime, allocator);
+        frameData.AddMember("markerTime", entry.markerTime, allocator);
+        frameData.AddMember("intersectionTime", entry.intersectionTime,
+                            allocator);
+        frameData.AddMember("sceneTime", entry.sceneTime, allocator);
+        frameData.AddMember("solveTime", entry.solveTime, allocator);
+        frameData.AddMember("result", entry.resultCode, allocator);
+        frameData.AddMember("objective", entry.finalObjective, allocator);
+
+        frames.PushBack(frameData, allocator);
+    }
+
+    d.AddMember("frames", frames, allocator);
+
+    string jsonFilename = filename;
+
+    writeJSON(d, jsonFilename);
+
+    ifstream written(filename);
+
+    return written.good() && written.peek() != ifstream::traits_type::eof();
+}
+
+TelemetryClock SolveTelemetry::now() { return chrono::steady_clock::now(); }
+
+double SolveTelemetry::secondsSince(const TelemetryClock &start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+        .count();
+}
@@ -0,0 +1,61 @@
+#ifndef SOLVETELEMETRY_H
+#define SOLVETELEMETRY_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock::time_point TelemetryClock;
+
+// Counters of a single frame solve. Times are in seconds.
+struct FrameTelemetry
+{
+    FrameTelemetry();
+
+    void addTermTimes(const FrameTelemetry &other);
+
+    int frame;
+
+    int numObjectiveEvaluations;
+    int numGradientEvaluations;
+
+    // Objective terms
+    double kinematicsTime; // Pose and dof axes
+    double priorTime;
+    double contactTime;
+    double markerTime;
+    double intersectionTime;
+
+    double sceneTime; // Maya DG reads and writes
+    double solveTime; // Wall clock of the whole solve
+
+    int resultCode; // nlopt::result
+    double finalObjective;
+};
+
+// Not a Maya context - per-frame solver telemetry collected over a run,
+// written out as CSV or JSON
+class SolveTelemetry
+{
+public:
+    SolveTelemetry();
+    virtual ~SolveTelemetry();
+
+    void addFrame(const FrameTelemetry &frameTelemetry);
+    void clear();
+
+    int getNumFrames() const;
+
+    bool writeCsv(const string &filename) const;
+    bool writeJson(const string &filename) const;
+
+    static TelemetryClock now();
+    static double secondsSince(const TelemetryClock &start);
+
+private:
+    vector<FrameTelemetry> m_frames;
+};
+
+#endif // SOLVETELEMETRY_H
@@ -0,0 +1,369 @@
+#include "spaceTimeSolver.hpp"
+
+SpaceTimeSolver::SpaceTimeSolver(FrameObjective &objective)
+    : m_objective(objective), m_correspondences(nullptr),
+      m_prior_dofs(nullptr), m_acceleration_coefficient(1.0),
+      m_max_iterations(100), m_relative_tolerance(1e-4),
+      m_result(LM_RESULT_MAX_ITERATIONS_REACHED), m_num_dofs(0),
+      m_bandwidth(0)
+{
+}
+
+SpaceTimeSolver::~SpaceTimeSolver() {}
+
+int SpaceTimeSolver::getResult() const { return m_result; }
+
+// Returns the number of iterations taken. Frames and boundary must be set.
+int SpaceTimeSolver::solve(vector<vector<double>> &windowDofs,
+                           double &minObjective)
+{
+    int numFrames = windowDofs.size();
+
+    m_num_dofs = numFrames > 0 ? windowDofs[0].size() : 0;
+    m_bandwidth = 2 * m_num_dofs;
+
+    double objective = computeWindowNormalEquations(windowDofs);
+    double damping = LM_INITIAL_DAMPING;
+
+    m_result = LM_RESULT_MAX_ITERATIONS_REACHED;
+
+    int iteration = 0;
+
+    while (iteration < m_max_iterations)
+    {
+        iteration++;
+
+        if (!computeStep(damping))
+        {
+            damping *= LM_DAMPING_INCREASE;
+
+            if (damping > LM_MAX_DAMPING)
+            {
+                m_result = LM_RESULT_DAMPING_LIMITED;
+                break;
+            }
+
+            continue;
+        }
+
+        m_candidate = windowDofs;
+
+        double stepNorm = 0.0;
+        double dofNorm = 0.0;
+
+        for (int f = 0; f < numFrames; f++)
+        {
+            for (int i = 0; i < m_num_dofs; i++)
+            {
+                double step = m_step[m_num_dofs * f + i];
+
+                m_candidate[f][i] += step;
+
+                stepNorm += step * step;
+                dofNorm += windowDofs[f][i] * windowDofs[f][i];
+            }
+        }
+
+        double candidateObjective = computeWindowObjective(m_candidate);
+
+        if (!(candidateObjective < objective))
+        {
+            damping *= LM_DAMPING_INCREASE;
+
+            if (damping > LM_MAX_DAMPING)
+            {
+                m_result = LM_RESULT_DAMPING_LIMITED;
+                break;
+            }
+
+            continue;
+        }
+
+        bool xConverged =
+            sqrt(stepNorm) <=
+            m_relative_tolerance * (sqrt(dofNorm) + m_relative_tolerance);
+        bool fConverged = objective - candidateObjective <=
+                          m_relative_tolerance * candidateObjective;
+
+        windowDofs = m_candidate;
+        damping = max(damping * LM_DAMPING_DECREASE, LM_MIN_DAMPING);
+
+        if (xConverged || fConverged)
+        {
+            m_result =
+                xConverged ? LM_RESULT_XTOL_REACHED : LM_RESULT_FTOL_REACHED;
+            objective = candidateObjective;
+            break;
+        }
+
+        objective = computeWindowNormalEquations(windowDofs);
+    }
+
+    minObjective = objective;
+
+    return iteration;
+}
+
+void SpaceTimeSolver::setAccelerationCoefficient(double coefficient)
+{
+    m_acceleration_coefficient = coefficient;
+}
+
+void SpaceTimeSolver::setAccelerationScales(const vector<double> &scales)
+{
+    m_acceleration_scales = scales;
+}
+
+void SpaceTimeSolver::setBoundary(const vector<vector<double>> &leadingDofs,
+                                  const vector<vector<double>> &trailingDofs)
+{
+    m_leading_dofs = leadingDofs;
+    m_trailing_dofs = trailingDofs;
+}
+
+// Both are referenced, not copied, and must outlive the solve
+void SpaceTimeSolver::setFrames(
+    const vector<FrameCorrespondences> &correspondences,
+    const vector<vector<double>> &priorDofs)
+{
+    m_correspondences = &correspondences;
+    m_prior_dofs = &priorDofs;
+}
+
+void SpaceTimeSolver::setMaxIterations(int maxIterations)
+{
+    m_max_iterations = maxIterations;
+}
+
+void SpaceTimeSolver::setRelativeTolerance(double relativeTolerance)
+{
+    m_relative_tolerance = relativeTolerance;
+}
+
+// Sum over every stencil touching the window of
+// coefficient / 2 * (scale * (x[t - 1] - 2 x[t] + x[t + 1]))^2. Its hessian
+// is the same for every window, a (1, -4, 6, -4, 1) band per dof.
+double SpaceTimeSolver::computeAccelerationError(
+    const vector<vector<double>> &windowDofs, bool derivativesRequested)
+{
+    int numFrames = windowDofs.size();
+
+    // Window frame f sits at f + SPACE_TIME_BOUNDARY_FRAMES of the padded
+    // sequence, so stencil centers 1 to numFrames + 2 touch the window
+    int numCenters = numFrames + 2;
+    int numPadded = numFrames + 2 * SPACE_TIME_BOUNDARY_FRAMES;
+
+    auto paddedDofs = [&](int t) -> const vector<double> &
+    {
+        if (t < SPACE_TIME_BOUNDARY_FRAMES)
+        {
+            return m_leading_dofs[t];
+        }
+
+        if (t < numFrames + SPACE_TIME_BOUNDARY_FRAMES)
+        {
+            return windowDofs[t - SPACE_TIME_BOUNDARY_FRAMES];
+        }
+
+        return m_trailing_dofs[t - numFrames - SPACE_TIME_BOUNDARY_FRAMES];
+    };
+
+    m_accelerations.assign(numCenters * m_num_dofs, 0.0);
+
+    double error = 0.0;
+
+    for (int c = 1; c < numPadded - 1; c++)
+    {
+        const vector<double> &previous = paddedDofs(c - 1);
+        const vector<double> &current = paddedDofs(c);
+        const vector<double> &next = paddedDofs(c + 1);
+
+        for (int i = 0; i < m_num_dofs; i++)
+        {
+            double acceleration = m_acceleration_scales[i] *
+                                  (previous[i] - 2.0 * current[i] + next[i]);
+
+            m_accelerations[m_num_dofs * (c - 1) + i] = acceleration;
+
+            error += acceleration * acceleration;
+        }
+    }
+
+    if (!derivativesRequested)
+    {
+        return 0.5 * m_acceleration_coefficient * error;
+    }
+
+    int rowSize = m_bandwidth + 1;
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        // Stencils centered on the previous, same and next frame
+        int center = f + SPACE_TIME_BOUNDARY_FRAMES - 1;
+
+        for (int i = 0; i < m_num_dofs; i++)
+        {
+            double scale = m_acceleration_scales[i];
+            double weight = m_acceleration_coefficient * scale * scale;
+
+            int row = m_num_dofs * f + i;
+
+            m_gradient[row] +=
+                m_acceleration_coefficient * scale *
+                (m_accelerations[m_num_dofs * (center - 1) + i] -
+                 2.0 * m_accelerations[m_num_dofs * center + i] +
+                 m_accelerations[m_num_dofs * (center + 1) + i]);
+
+            m_band[rowSize * row + m_bandwidth] += 6.0 * weight;
+
+            if (f > 0)
+            {
+                m_band[rowSize * row + m_bandwidth - m_num_dofs] -=
+                    4.0 * weight;
+            }
+
+            if (f > 1)
+            {
+                m_band[rowSize * row] += weight;
+            }
+        }
+    }
+
+    return 0.5 * m_acceleration_coefficient * error;
+}
+
+// Damped band Cholesky solve of hessian * step = -gradient
+bool SpaceTimeSolver::computeStep(double damping)
+{
+    int n = m_gradient.size();
+    int rowSize = m_bandwidth + 1;
+
+    m_factor = m_band;
+
+    for (int i = 0; i < n; i++)
+    {
+        double &diagonal = m_factor[rowSize * i + m_bandwidth];
+
+        diagonal +=
+            damping * (m_band[rowSize * i + m_bandwidth] + LM_DIAGONAL_FLOOR);
+    }
+
+    // Entry (i, j) of the lower band is at rowSize * i + j - i + bandwidth
+    for (int i = 0; i < n; i++)
+    {
+        int firstColumn = max(0, i - m_bandwidth);
+
+        for (int j = firstColumn; j <= i; j++)
+        {
+            double value = m_factor[rowSize * i + j - i + m_bandwidth];
+
+            for (int k = max(firstColumn, j - m_bandwidth); k < j; k++)
+            {
+                value -= m_factor[rowSize * i + k - i + m_bandwidth] *
+                         m_factor[rowSize * j + k - j + m_bandwidth];
+            }
+
+            if (j < i)
+            {
+                m_factor[rowSize * i + j - i + m_bandwidth] =
+                    value / m_factor[rowSize * j + m_bandwidth];
+                continue;
+            }
+
+            if (!(value > 0.0))
+            {
+                return false;
+            }
+
+            m_factor[rowSize * i + m_bandwidth] = sqrt(value);
+        }
+    }
+
+    // Forward then back substitution
+    m_step.resize(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        double value = -m_gradient[i];
+
+        for (int k = max(0, i - m_bandwidth); k < i; k++)
+        {
+            value -= m_factor[rowSize * i + k - i + m_bandwidth] * m_step[k];
+        }
+
+        m_step[i] = value / m_factor[rowSize * i + m_bandwidth];
+    }
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        double value = m_step[i];
+
+        for (int k = i + 1; k <= min(n - 1, i + m_bandwidth); k++)
+        {
+            value -= m_factor[rowSize * k + i - k + m_bandwidth] * m_step[k];
+        }
+
+        m_step[i] = value / m_factor[rowSize * i + m_bandwidth];
+    }
+
+    return true;
+}
+
+double
+SpaceTimeSolver::computeWindowObjective(const vector<vector<double>> &windowDofs)
+{
+    vector<double> noGrad;
+
+    int numFrames = windowDofs.size();
+
+    double objective = 0.0;
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        m_objective.setCorrespondences(&(*m_correspondences)[f]);
+        m_objective.setPriorDofs((*m_prior_dofs)[f]);
+
+        objective += m_objective.computeObjective(windowDofs[f], noGrad);
+    }
+
+    return objective + computeAccelerationError(windowDofs, false);
+}
+
+// Per-frame Gauss-Newton blocks on the diagonal, coupled by the acceleration
+// band. Returns the objective.
+double SpaceTimeSolver::computeWindowNormalEquations(
+    const vector<vector<double>> &windowDofs)
+{
+    int numFrames = windowDofs.size();
+    int rowSize = m_bandwidth + 1;
+
+    m_band.assign(numFrames * m_num_dofs * rowSize, 0.0);
+    m_gradient.assign(numFrames * m_num_dofs, 0.0);
+
+    double objective = 0.0;
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        m_objective.setCorrespondences(&(*m_correspondences)[f]);
+        m_objective.setPriorDofs((*m_prior_dofs)[f]);
+
+        objective += m_objective.computeNormalEquations(
+            windowDofs[f], m_frame_hessian, m_frame_gradient);
+
+        int offset = m_num_dofs * f;
+
+        for (int i = 0; i < m_num_dofs; i++)
+        {
+            m_gradient[offset + i] = m_frame_gradient[i];
+
+            // Lower triangle of the frame block
+            for (int j = 0; j <= i; j++)
+            {
+                m_band[rowSize * (offset + i) + j - i + m_bandwidth] =
+                    m_frame_hessian[m_num_dofs * i + j];
+            }
+        }
+    }
+
+    return objective + computeAccelerationError(windowDofs, true);
+}
@@ -0,0 +1,75 @@
+#ifndef SPACETIMESOLVER_H
+#define SPACETIMESOLVER_H
+
+#include "levenbergMarquardt.hpp"
+
+// Fixed frames on either side of a window, enough for the acceleration of the
+// window's outer frames and of their fixed neighbours
+#define SPACE_TIME_BOUNDARY_FRAMES 2
+
+// Not a Maya context - Levenberg-Marquardt over a window of consecutive frames
+// solved jointly. Each frame keeps its own fused objective, and a quadratic
+// penalty on the finite difference acceleration of every dof couples
+// neighbouring frames. The window hessian is then block banded, two blocks to
+// either side of the diagonal, and is factored in band form.
+class SpaceTimeSolver
+{
+public:
+    SpaceTimeSolver(FrameObjective &objective);
+    virtual ~SpaceTimeSolver();
+
+    int getResult() const;
+
+    int solve(vector<vector<double>> &windowDofs, double &minObjective);
+
+    void setAccelerationCoefficient(double coefficient);
+    void setAccelerationScales(const vector<double> &scales);
+    void setBoundary(const vector<vector<double>> &leadingDofs,
+                     const vector<vector<double>> &trailingDofs);
+    void setFrames(const vector<FrameCorrespondences> &correspondences,
+                   const vector<vector<double>> &priorDofs);
+    void setMaxIterations(int maxIterations);
+    void setRelativeTolerance(double relativeTolerance);
+
+private:
+    double computeAccelerationError(const vector<vector<double>> &windowDofs,
+                                    bool derivativesRequested);
+    bool computeStep(double damping);
+    double computeWindowObjective(const vector<vector<double>> &windowDofs);
+    double computeWindowNormalEquations(
+        const vector<vector<double>> &windowDofs);
+
+    FrameObjective &m_objective;
+
+    // Window vars
+
+    const vector<FrameCorrespondences> *m_correspondences;
+    const vector<vector<double>> *m_prior_dofs;
+    vector<vector<double>> m_leading_dofs;  // Oldest first
+    vector<vector<double>> m_trailing_dofs; // Oldest first
+
+    // Acceleration vars
+
+    double m_acceleration_coefficient;
+    vector<double> m_acceleration_scales; // Per dof, applied before squaring
+
+    int m_max_iterations;
+    double m_relative_tolerance;
+
+    int m_result; // Of the last solve
+
+    // Scratch vars
+
+    int m_num_dofs;
+    int m_bandwidth;
+    vector<double> m_band;   // Lower band of the hessian, row by row
+    vector<double> m_factor; // Cholesky factor in the same layout
+    vector<double> m_gradient;
+    vector<double> m_step;
+    vector<double> m_frame_hessian;
+    vector<double> m_frame_gradient;
+    vector<double> m_accelerations; // Per stencil center and dof
+    vector<vector<double>> m_candidate;
+};
+
+#endif // SPACETIMESOLVER_H
@@ -0,0 +1,88 @@
+#include "taskPool.hpp"
+
+TaskPool::TaskPool(int numThreads)
+    : m_num_threads(max(numThreads, 1)), m_queues(m_num_threads),
+      m_queue_mutexes(m_num_threads)
+{
+}
+
+TaskPool::~TaskPool() {}
+
+int TaskPool::getNumThreads() const { return m_num_threads; }
+
+// Blocks until all tasks are done. The callback receives the worker index
+// (for per-thread state) and the task index.
+void TaskPool::run(int numTasks, const function<void(int, int)> &task)
+{
+    for (int worker = 0; worker < m_num_threads; worker++)
+    {
+        int blockStart = (numTasks * worker) / m_num_threads;
+        int blockEnd = (numTasks * (worker + 1)) / m_num_threads;
+
+        m_queues[worker].clear();
+
+        for (int i = blockStart; i < blockEnd; i++)
+        {
+            m_queues[worker].push_back(i);
+        }
+    }
+
+    vector<thread> workers;
+
+    for (int worker = 0; worker < m_num_threads; worker++)
+    {
+        workers.emplace_back(
+            [this, worker, &task]()
+            {
+                int next;
+
+                while (popTask(worker, next) || stealTask(worker, next))
+                {
+                    task(worker, next);
+                }
+            });
+    }
+
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+bool TaskPool::popTask(int worker, int &task)
+{
+    lock_guard<mutex> lock(m_queue_mutexes[worker]);
+
+    if (m_queues[worker].empty())
+    {
+        return false;
+    }
+
+    task = m_queues[worker].front();
+    m_queues[worker].pop_front();
+
+    return true;
+}
+
+// Queues are never refilled during a run, so one empty sweep means done
+bool TaskPool::stealTask(int thief, int &task)
+{
+    for (int offset = 1; offset < m_num_threads; offset++)
+    {
+        int victim = (thief + offset) % m_num_threads;
+
+        lock_guard<mutex> lock(m_queue_mutexes[victim]);
+
+        if (m_queues[victim].empty())
+        {
+            continue;
+        }
+
+        task = m_queues[victim].back();
+        m_queues[victim].pop_back();
+
+        return true;
+    }
+
+    return false;
+}
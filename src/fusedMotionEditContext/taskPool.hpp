@@ -0,0 +1,37 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Not a Maya context - runs independent tasks on worker threads. Each worker
+// starts on its own contiguous block of tasks and steals from the back of
+// the other workers' queues once it runs dry, so uneven task costs still
+// balance out. Tasks must not touch Maya.
+class TaskPool
+{
+public:
+    TaskPool(int numThreads);
+    virtual ~TaskPool();
+
+    int getNumThreads() const;
+
+    void run(int numTasks, const function<void(int, int)> &task);
+
+private:
+    bool popTask(int worker, int &task);
+    bool stealTask(int thief, int &task);
+
+    int m_num_threads;
+
+    vector<deque<int>> m_queues;
+    vector<mutex> m_queue_mutexes;
+};
+
+#endif // TASKPOOL_H
@@ -249,11 +249,13 @@ MStatus SmoothMotionEditContext::loadControlSplines()
         allFrameDofValues.push_back(frameDofValues);
     }
 
+    // Poses are staged on the joints and keyed in bulk, so time does not need
+    // to move until the end
+
+    m_keyframe_sink.clear();
+
     for (int frame = m_start_frame; frame <= m_end_frame; frame++)
     {
-        status = jumpToFrame(frame, true);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-
         for (int rigDofIndex = 0; rigDofIndex < m_rig_n_dofs; rigDofIndex++)
         {
             map<int, double> frameDofValues = allFrameDofValues[rigDofIndex];
@@ -272,10 +274,13 @@ MStatus SmoothMotionEditContext::loadControlSplines()
         status = loadRigDofSolutionFull();
         CHECK_MSTATUS(status);
 
-        status = keyframeRig();
+        status = m_keyframe_sink.addFrame(frame, m_framerate);
         CHECK_MSTATUS(status);
     }
 
+    status = m_keyframe_sink.commit();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
     status = jumpToFrame(m_start_frame, true);
     CHECK_MSTATUS_AND_RETURN_IT(status);
 
@@ -561,6 +566,8 @@ MStatus SmoothMotionEditContext::parseKinematicTree()
 
     m_rig_n_dofs = nDofs;
 
+    m_keyframe_sink.setRig(m_rig_joints, m_rig_dof_vec_mappings);
+
     MGlobal::displayInfo(to_string(m_rig_n_dofs).c_str());
     MGlobal::displayInfo(to_string(m_rig_dof_vec_mappings.size()).c_str());
 
@@ -1705,22 +1712,6 @@ MStatus SmoothMotionEditContext::interpolateSerializedPoint(
     return MS::kSuccess;
 }
 
-MStatus SmoothMotionEditContext::keyframeRig()
-{
-    MStatus status;
-
-    for (int i = 0; i < m_joint_names.length(); i++)
-    {
-        MString jointName = m_joint_names[i];
-
-        MString saveCommand = "setKeyframe { \"" + jointName + "\" }";
-        status = MGlobal::executeCommand(saveCommand);
-        CHECK_MSTATUS_AND_RETURN_IT(status);
-    }
-
-    return MS::kSuccess;
-}
-
 MStatus SmoothMotionEditContext::loadRigDofSolutionFull()
 {
     MStatus status;
@@ -27,6 +27,8 @@
 #include "BSplineCurveFit.h"
 #include "Vector2.h"
 
+#include "rigKeyframeSink.hpp"
+
 #include <cstring>
 #include <map>
 #include <memory>
@@ -164,8 +166,6 @@ public:
                                        MFloatPoint &position,
                                        MFloatVector &normal);
 
-    MStatus keyframeRig();
-
     MStatus loadSingleRigDofFromControlSpline(int rigDofIndex, int frame);
 
     MStatus loadRigDofSolutionFull();
@@ -216,6 +216,7 @@ private:
     int m_start_frame;
     int m_end_frame;
     MStringArray m_joint_names;
+    RigKeyframeSink m_keyframe_sink;
 
     // Kinematic vars
 